@@ -62,14 +62,35 @@ SOURCES  += main.cpp \
     commevent.cpp \
     p2pevent.cpp \
     collectiveevent.cpp \
-    commdrawinterface.cpp \
     counter.cpp \
     counterrecord.cpp \
     charmimporter.cpp \
     otf2importer.cpp \
     otf2exporter.cpp \
     otf2exportfunctor.cpp \
+    tracegenerator.cpp \
+    charmgenerator.cpp \
+    stagetimer.cpp \
+    selfprofiler.cpp \
+    memorycensus.cpp \
+    perfcounters.cpp \
+    singlelinkage.cpp \
+    clustermatrix.cpp \
+    clara.cpp \
+    steppyramid.cpp \
+    stephistogram.cpp \
+    tracesummary.cpp \
+    commindex.cpp \
     metrics.cpp \
+    timeindex.cpp \
+    aggregateprofiles.cpp \
+    aggregatesteptotals.cpp \
+    gnomedrawer.cpp \
+    exchangegnomedrawer.cpp \
+    hitgrid.cpp \
+    pixellines.cpp \
+    framestats.cpp \
+    traditionaltiles.cpp \
     entity.cpp \
     primaryentitygroup.cpp \
     entitygroup.cpp \
@@ -111,14 +132,36 @@ HEADERS += \
     p2pevent.h \
     collectiveevent.h \
     commbundle.h \
-    commdrawinterface.h \
+    strideinfo.h \
     counter.h \
     counterrecord.h \
     charmimporter.h \
     otf2importer.h \
     otf2exporter.h \
     otf2exportfunctor.h \
+    tracegenerator.h \
+    charmgenerator.h \
+    stagetimer.h \
+    selfprofiler.h \
+    memorycensus.h \
+    perfcounters.h \
+    singlelinkage.h \
+    clustermatrix.h \
+    clara.h \
+    steppyramid.h \
+    stephistogram.h \
+    tracesummary.h \
+    commindex.h \
     metrics.h \
+    timeindex.h \
+    aggregateprofiles.h \
+    aggregatesteptotals.h \
+    gnomedrawer.h \
+    exchangegnomedrawer.h \
+    hitgrid.h \
+    pixellines.h \
+    framestats.h \
+    traditionaltiles.h \
     entity.h \
     primaryentitygroup.h \
     entitygroup.h \
@@ -161,12 +204,6 @@ macx: LIBS += -L$${HOME}/opt/lib -lotf2
 macx: INCLUDEPATH += $${HOME}/opt/include/otf2/
 macx: DEPENDPATH += $${HOME}/opt/include/otf2/
 
-unix:!macx: LIBS += -L$${HOME}/opt/lib -lmuster
-
-macx: LIBS += -L$${HOME}/opt/muster/lib -lmuster
-macx: INCLUDEPATH += $${HOME}/opt/muster/include
-macx: DEPENDPATH += $${HOME}/opt/muster/include
-
 OTHER_FILES += \
     CMakeLists.txt
 
@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "aggregateprofiles.h"
+#include "event.h"
+#include "commevent.h"
+#include "timeindex.h"
+#include <algorithm>
+
+AggregateProfiles::AggregateProfiles(TimeIndex * _index)
+    : events(QVector<CommEvent *>()),
+      offsets(QVector<int>()),
+      functions(QVector<int>()),
+      times(QVector<long long int>()),
+      index(_index)
+{
+}
+
+// Walk the overlapping roots once per interval. Intervals of an entity are
+// disjoint, so this touches each part of the call trees about once.
+void AggregateProfiles::calculate()
+{
+    qSort(events.begin(), events.end(), Event::eventEnterLessThan);
+
+    offsets.clear();
+    functions.clear();
+    times.clear();
+    offsets.reserve(events.size() + 1);
+
+    QMap<int, long long int> * profile = new QMap<int, long long int>();
+    for (QVector<CommEvent *>::Iterator evt = events.begin();
+         evt != events.end(); ++evt)
+    {
+        offsets.append(functions.size());
+
+        unsigned long long stoptime = (*evt)->enter;
+        unsigned long long starttime = 0;
+        if ((*evt)->comm_prev)
+            starttime = (*evt)->comm_prev->exit;
+
+        profile->clear();
+        int last = index->lastRoot(stoptime);
+        for (int i = index->firstRoot(starttime); i <= last; i++)
+        {
+            profileRecurse(index->roots->at(i), profile, starttime, stoptime);
+        }
+
+        // QMap iterates in key order, so each run is sorted by function
+        for (QMap<int, long long int>::Iterator fxn = profile->begin();
+             fxn != profile->end(); ++fxn)
+        {
+            functions.append(fxn.key());
+            times.append(fxn.value());
+        }
+    }
+    offsets.append(functions.size());
+    delete profile;
+
+    functions.squeeze();
+    times.squeeze();
+}
+
+long long int AggregateProfiles::profileRecurse(Event * evt,
+                                                QMap<int, long long int> * profile,
+                                                unsigned long long start,
+                                                unsigned long long stop)
+{
+    if (evt->enter > stop || evt->exit < start)
+        return 0;
+
+    unsigned long long overlap_stop = std::min(stop, evt->exit);
+    unsigned long long overlap_start = std::max(start, evt->enter);
+    long long overlap = overlap_stop - overlap_start;
+    for (int i = evt->firstCalleeEndingAfter(start);
+         i < evt->callees->size(); i++)
+    {
+        Event * child = evt->callees->at(i);
+        if (child->enter > stop)
+            break;
+        overlap -= profileRecurse(child, profile, start, stop);
+    }
+
+    (*profile)[evt->function] += overlap;
+    return overlap;
+}
+
+// Position of evt in events, -1 if it is not there
+int AggregateProfiles::findEvent(CommEvent * evt)
+{
+    int low = 0, high = events.size();
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (events.at(mid)->enter < evt->enter)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    // Several events may share an enter time
+    for (int i = low; i < events.size() && events.at(i)->enter == evt->enter;
+         i++)
+    {
+        if (events.at(i) == evt)
+            return i;
+    }
+    return -1;
+}
+
+QList<Trace::FunctionPair> AggregateProfiles::getProfile(CommEvent * evt)
+{
+    QList<Trace::FunctionPair> profile = QList<Trace::FunctionPair>();
+    int position = findEvent(evt);
+    if (position < 0 || position + 1 >= offsets.size())
+        return profile;
+
+    for (int i = offsets.at(position); i < offsets.at(position + 1); i++)
+    {
+        profile.append(Trace::FunctionPair(functions.at(i), times.at(i)));
+    }
+    return profile;
+}
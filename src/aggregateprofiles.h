@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef AGGREGATEPROFILES_H
+#define AGGREGATEPROFILES_H
+
+#include <QVector>
+#include <QList>
+#include <QMap>
+#include "trace.h"
+
+class Event;
+class CommEvent;
+class TimeIndex;
+
+// Function profiles of the aggregate (non-communication) intervals of one
+// entity. The interval of a CommEvent runs from the exit of its comm_prev
+// to its own enter. Profiles are computed once after processing and kept
+// as contiguous (function, time) runs sorted by function id, so looking
+// one up is a binary search rather than a call tree walk.
+class AggregateProfiles
+{
+public:
+    AggregateProfiles(TimeIndex * _index);
+
+    void addEvent(CommEvent * evt) { events.append(evt); }
+    void calculate();
+
+    // Profile of a single aggregate interval, sorted by function id
+    QList<Trace::FunctionPair> getProfile(CommEvent * evt);
+
+    QVector<CommEvent *> events; // Sorted by enter once calculated
+    QVector<int> offsets; // Run of events[i] is [offsets[i], offsets[i+1])
+    QVector<int> functions;
+    QVector<long long int> times;
+
+private:
+    long long int profileRecurse(Event * evt,
+                                 QMap<int, long long int> * profile,
+                                 unsigned long long start,
+                                 unsigned long long stop);
+    int findEvent(CommEvent * evt);
+
+    TimeIndex * index;
+};
+
+#endif // AGGREGATEPROFILES_H
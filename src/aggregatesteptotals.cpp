@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "aggregatesteptotals.h"
+#include "aggregateprofiles.h"
+#include "commevent.h"
+#include <algorithm>
+
+AggregateStepTotals::AggregateStepTotals()
+    : functions(QVector<int>()),
+      offsets(QVector<int>()),
+      steps(QVector<int>()),
+      cumulative(QVector<long long int>())
+{
+}
+
+// Every (function, step, time) entry of the stored profiles is sorted by
+// function then step, merged where entities share a step, and summed
+// along each function's run.
+void AggregateStepTotals::build(QVector<AggregateProfiles *> * profiles)
+{
+    QVector<StepTime> entries;
+    int count = 0;
+    for (QVector<AggregateProfiles *>::Iterator entity = profiles->begin();
+         entity != profiles->end(); ++entity)
+    {
+        count += (*entity)->functions.size();
+    }
+    entries.reserve(count);
+
+    for (QVector<AggregateProfiles *>::Iterator entity = profiles->begin();
+         entity != profiles->end(); ++entity)
+    {
+        AggregateProfiles * p = *entity;
+        for (int j = 0; j + 1 < p->offsets.size(); j++)
+        {
+            int step = p->events.at(j)->step;
+            for (int i = p->offsets.at(j); i < p->offsets.at(j + 1); i++)
+            {
+                entries.append(StepTime(p->functions.at(i), step,
+                                        p->times.at(i)));
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    functions.clear();
+    offsets.clear();
+    steps.clear();
+    cumulative.clear();
+    long long int running = 0;
+    for (QVector<StepTime>::Iterator entry = entries.begin();
+         entry != entries.end(); ++entry)
+    {
+        if (functions.isEmpty() || functions.last() != entry->function)
+        {
+            functions.append(entry->function);
+            offsets.append(steps.size());
+            running = 0;
+        }
+        running += entry->time;
+        if (steps.size() > offsets.last() && steps.last() == entry->step)
+        {
+            cumulative.last() = running;
+            continue;
+        }
+        steps.append(entry->step);
+        cumulative.append(running);
+    }
+    offsets.append(steps.size());
+
+    functions.squeeze();
+    offsets.squeeze();
+    steps.squeeze();
+    cumulative.squeeze();
+}
+
+// Time of the run [first, last) at steps up to and including step
+long long int AggregateStepTotals::prefix(int first, int last, int step) const
+{
+    const int * end = std::upper_bound(steps.constData() + first,
+                                       steps.constData() + last, step);
+    int position = end - steps.constData();
+    if (position == first)
+        return 0;
+    return cumulative.at(position - 1);
+}
+
+void AggregateStepTotals::addTotals(int start, int stop,
+                                    QMap<int, long long int> * totals) const
+{
+    if (stop < start)
+        return;
+
+    for (int f = 0; f < functions.size(); f++)
+    {
+        int first = offsets.at(f);
+        int last = offsets.at(f + 1);
+        if (steps.at(first) > stop || steps.at(last - 1) < start)
+            continue;
+
+        long long int time = prefix(first, last, stop)
+                             - prefix(first, last, start - 1);
+        if (time > 0)
+            (*totals)[functions.at(f)] += time;
+    }
+}
+
+long long AggregateStepTotals::memoryBytes() const
+{
+    return sizeof(AggregateStepTotals)
+           + (functions.capacity() + offsets.capacity() + steps.capacity())
+             * sizeof(int)
+           + cumulative.capacity() * sizeof(long long int);
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef AGGREGATESTEPTOTALS_H
+#define AGGREGATESTEPTOTALS_H
+
+#include <QVector>
+#include <QMap>
+
+class AggregateProfiles;
+
+// Running totals of the aggregate time of each function by step, summed
+// over all entities. Only the steps where a function has time are kept,
+// so the totals over a step range are a difference of two prefix sums
+// per function rather than a pass over every aggregate interval.
+class AggregateStepTotals
+{
+public:
+    AggregateStepTotals();
+
+    void build(QVector<AggregateProfiles *> * profiles);
+
+    // Adds each function's time over steps [start, stop] to totals
+    void addTotals(int start, int stop, QMap<int, long long int> * totals) const;
+    int size() const { return steps.size(); }
+    long long memoryBytes() const;
+
+private:
+    class StepTime {
+    public:
+        StepTime(int _f, int _s, long long int _t)
+            : function(_f), step(_s), time(_t) {}
+        StepTime()
+            : function(0), step(0), time(0) {}
+
+        bool operator<(const StepTime &st) const
+        {
+            if (function != st.function)
+                return function < st.function;
+            return step < st.step;
+        }
+
+        int function;
+        int step;
+        long long int time;
+    };
+
+    long long int prefix(int first, int last, int step) const;
+
+    QVector<int> functions;
+    QVector<int> offsets; // Run of functions[i] is [offsets[i], offsets[i+1])
+    QVector<int> steps; // Ascending within a run
+    QVector<long long int> cumulative; // Time at steps[0..k] of the run
+};
+
+#endif // AGGREGATESTEPTOTALS_H
@@ -0,0 +1,560 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "charmgenerator.h"
+#include "ravelutils.h"
+#include <QStringList>
+#include <QMap>
+#include <QFile>
+#include <QtAlgorithms>
+#include <zlib.h>
+#include <iostream>
+
+CharmGenerator::CharmGenerator()
+    : pes(16),
+      iterations(10),
+      arrays(1),
+      dimensions(QList<int>() << 8 << 8),
+      entries(1),
+      migration_period(0),
+      migration(0.1),
+      reduction_period(0),
+      idle(true),
+      gzip(false),
+      imbalance(0),
+      noise(0),
+      compute(100000),
+      message_size(1024),
+      seed(0),
+      path(""),
+      basename(""),
+      elements_per_array(0),
+      neighbors(0),
+      latency(2000),
+      call_cost(500),
+      placement(QVector<int>()),
+      clock(QVector<long long>()),
+      events(QVector<int>()),
+      incoming(QVector<Task>()),
+      outgoing(QVector<Task>()),
+      buffers(QVector<QByteArray>()),
+      started(QVector<bool>())
+{
+}
+
+// Dimensions are given as extents separated by x, e.g. 16x16x4
+bool CharmGenerator::setDimensions(QString dims)
+{
+    QStringList extents = dims.split("x");
+    if (extents.size() < 1 || extents.size() > 4)
+        return false;
+
+    QList<int> parsed;
+    for (QStringList::Iterator extent = extents.begin();
+         extent != extents.end(); ++extent)
+    {
+        bool ok = false;
+        int value = extent->toInt(&ok);
+        if (!ok || value < 1)
+            return false;
+        parsed.append(value);
+    }
+
+    dimensions = parsed;
+    return true;
+}
+
+QString CharmGenerator::getDimensionString()
+{
+    QStringList extents;
+    for (QList<int>::Iterator extent = dimensions.begin();
+         extent != dimensions.end(); ++extent)
+    {
+        extents.append(QString::number(*extent));
+    }
+    return extents.join("x");
+}
+
+long long CharmGenerator::getElementCount()
+{
+    long long count = arrays;
+    for (QList<int>::Iterator extent = dimensions.begin();
+         extent != dimensions.end(); ++extent)
+    {
+        count *= *extent;
+    }
+    return count;
+}
+
+void CharmGenerator::generateTrace(QString _path, QString _basename)
+{
+    path = _path;
+    basename = _basename;
+    if (entries < 1)
+        entries = 1;
+
+    elements_per_array = getElementCount() / arrays;
+    neighbors = 2 * dimensions.size();
+    int elements = arrays * elements_per_array;
+
+    // Leave room for the ghost sends and contribution in each compute
+    if (compute < (neighbors + 2) * call_cost)
+        compute = (neighbors + 2) * call_cost;
+
+    // Block mapping of elements to PEs like the default array map
+    placement = QVector<int>(elements);
+    for (int i = 0; i < elements; i++)
+        placement[i] = (long long) i * pes / elements;
+
+    clock = QVector<long long>(pes, 0);
+    events = QVector<int>(pes, 0);
+    incoming = QVector<Task>(elements * neighbors);
+    outgoing = QVector<Task>(elements * neighbors);
+    buffers = QVector<QByteArray>(pes);
+    started = QVector<bool>(pes, false);
+
+    writeSts();
+    for (int i = 0; i < pes; i++)
+    {
+        buffers[i].append("PROJECTIONS-RECORD\n");
+        writeLine(i, QString::number(BEGIN_COMPUTATION) + " 0");
+    }
+
+    for (int i = 0; i < iterations; i++)
+    {
+        simulateIteration(i);
+        if (iterations >= 10 && (i + 1) % (iterations / 10) == 0)
+            std::cout << "Simulated " << (i + 1) << " of " << iterations
+                      << " iterations" << std::endl;
+    }
+
+    for (int i = 0; i < pes; i++)
+    {
+        writeLine(i, QString::number(END_COMPUTATION) + " "
+                     + QString::number(clock[i]));
+        flush(i);
+    }
+
+    placement.clear();
+    incoming.clear();
+    outgoing.clear();
+    buffers.clear();
+}
+
+void CharmGenerator::writeSts()
+{
+    QFile file(path + "/" + basename + ".sts");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        std::cout << "Unable to write " << file.fileName().toStdString().c_str()
+                  << std::endl;
+        return;
+    }
+
+    QStringList lines;
+    lines << "PROJECTIONS_ID"
+          << "VERSION 7.0"
+          << "MACHINE synthetic"
+          << "PROCESSORS " + QString::number(pes)
+          << "TOTAL_CHARES 3"
+          << "TOTAL_EPS " + QString::number(GE_COMPUTE + entries)
+          << "TOTAL_MSGS 3"
+          << "TOTAL_PSEUDOS 0"
+          << "TOTAL_EVENTS 0"
+          << "CHARE " + QString::number(GC_MAIN) + " Main -1"
+          << "CHARE " + QString::number(GC_ARRAY) + " Block "
+             + QString::number(dimensions.size())
+          << "CHARE " + QString::number(GC_REDUCTION) + " CkReductionMgr -1"
+          << "ENTRY CHARE " + QString::number(GE_MAIN)
+             + " Main(CkArgMsg* impl_msg) " + QString::number(GC_MAIN) + " 0"
+          << "ENTRY CHARE " + QString::number(GE_DONE)
+             + " done(CkReductionMsg* impl_msg) " + QString::number(GC_MAIN) + " 1"
+          << "ENTRY CHARE " + QString::number(GE_GHOST)
+             + " recvGhost(GhostMsg* impl_msg) " + QString::number(GC_ARRAY) + " 2"
+          << "ENTRY CHARE " + QString::number(GE_CONTRIBUTE)
+             + " addContribution(CkReductionMsg* impl_msg) "
+             + QString::number(GC_REDUCTION) + " 1"
+          << "ENTRY CHARE " + QString::number(GE_RECVMSG)
+             + " RecvMsg(CkReductionMsg* impl_msg) "
+             + QString::number(GC_REDUCTION) + " 1";
+    for (int i = 0; i < entries; i++)
+        lines << "ENTRY CHARE " + QString::number(GE_COMPUTE + i) + " compute_"
+                 + QString::number(i) + "(GhostMsg* impl_msg) "
+                 + QString::number(GC_ARRAY) + " 2";
+    lines << "MESSAGE 0 0"
+          << "MESSAGE 1 0"
+          << "MESSAGE 2 " + QString::number(message_size)
+          << "END";
+
+    file.write(lines.join("\n").toUtf8());
+    file.write("\n");
+    file.close();
+}
+
+void CharmGenerator::simulateIteration(int iteration)
+{
+    if (iteration > 0 && migration_period > 0
+        && iteration % migration_period == 0)
+    {
+        migrate(iteration);
+    }
+
+    QVector<QList<int> > hosted = QVector<QList<int> >(pes);
+    for (int i = 0; i < placement.size(); i++)
+        hosted[placement[i]].append(i);
+
+    if (iteration == 0)
+        startElements();
+
+    QVector<QList<Task> > contributions = QVector<QList<Task> >(pes);
+    for (int i = 0; i < pes; i++)
+        processElements(i, iteration, &(hosted[i]), &(contributions[i]));
+
+    // Ghosts sent this iteration are received in the next one
+    qSwap(incoming, outgoing);
+
+    if (reduction_period > 0 && (iteration + 1) % reduction_period == 0)
+        reduce(&contributions);
+}
+
+// Main on PE 0 kicks off every element's first compute
+void CharmGenerator::startElements()
+{
+    long long time = clock[0];
+    int main_event = sendEvent(0);
+    writeBegin(0, GE_MAIN, 0, main_event, time, -1, 0);
+    for (int i = 0; i < placement.size(); i++)
+    {
+        time += call_cost;
+        Task task;
+        task.arrival = time + (placement[i] == 0 ? 0 : latency);
+        task.element = i;
+        task.slot = 0;
+        task.pe = 0;
+        task.event = sendEvent(0);
+        writeCreation(0, GE_COMPUTE, task.event, time, arrayId(i));
+        incoming[i * neighbors] = task;
+    }
+    time += call_cost;
+    writeEnd(0, GE_MAIN, main_event, time, 0);
+    clock[0] = time;
+}
+
+// Run everything sent to this PE's elements in arrival order. After its
+// last ghost an element sends itself the compute message.
+void CharmGenerator::processElements(int pe, int iteration, QList<int> * hosted,
+                                     QList<Task> * contributions)
+{
+    int needed = (iteration == 0) ? 1 : neighbors;
+    QList<Task> tasks;
+    for (QList<int>::Iterator element = hosted->begin();
+         element != hosted->end(); ++element)
+    {
+        for (int i = 0; i < needed; i++)
+            tasks.append(incoming[*element * neighbors + i]);
+    }
+    qSort(tasks);
+
+    QMap<int, int> received;
+    for (QList<Task>::Iterator task = tasks.begin(); task != tasks.end(); ++task)
+    {
+        waitUntil(pe, task->arrival);
+        if (iteration == 0)
+        {
+            runCompute(pe, iteration, task->element, task->pe, task->event,
+                       contributions);
+            continue;
+        }
+
+        int array = arrayId(task->element);
+        long long time = clock[pe];
+        writeBegin(pe, GE_GHOST, task->pe, task->event, time, task->element,
+                   array);
+        received[task->element] += 1;
+        int compute_event = -1;
+        if (received.value(task->element) == needed)
+        {
+            compute_event = sendEvent(pe);
+            writeCreation(pe, GE_COMPUTE + iteration % entries, compute_event,
+                          time + call_cost / 2, array);
+        }
+        writeEnd(pe, GE_GHOST, task->event, time + call_cost, array);
+        clock[pe] = time + call_cost;
+
+        if (compute_event >= 0)
+            runCompute(pe, iteration, task->element, pe, compute_event,
+                       contributions);
+    }
+}
+
+// Ghosts go out at the end of the compute, followed by the reduction
+// contribution when this iteration has one.
+void CharmGenerator::runCompute(int pe, int iteration, int element, int sender,
+                                int event, QList<Task> * contributions)
+{
+    int entry = GE_COMPUTE + iteration % entries;
+    int array = arrayId(element);
+    long long time = clock[pe];
+    long long length = computeTime(element, iteration);
+    writeBegin(pe, entry, sender, event, time, element, array);
+
+    for (int i = 0; i < neighbors; i++)
+    {
+        long long send = time + length - (neighbors + 1 - i) * call_cost;
+        int target = neighbor(element, i);
+        Task ghost;
+        ghost.arrival = send + (placement[target] == pe ? 0 : latency);
+        ghost.element = target;
+        ghost.slot = i;
+        ghost.pe = pe;
+        ghost.event = sendEvent(pe);
+        writeCreation(pe, GE_GHOST, ghost.event, send, array);
+        outgoing[target * neighbors + i] = ghost;
+    }
+
+    if (reduction_period > 0 && (iteration + 1) % reduction_period == 0)
+    {
+        Task contribution;
+        contribution.arrival = time + length - call_cost;
+        contribution.element = element;
+        contribution.slot = 0;
+        contribution.pe = pe;
+        contribution.event = sendEvent(pe);
+        writeCreation(pe, GE_CONTRIBUTE, contribution.event,
+                      contribution.arrival, array);
+        contributions->append(contribution);
+    }
+
+    writeEnd(pe, entry, event, time + length, array);
+    clock[pe] = time + length;
+}
+
+// Reduce up a binary tree of PEs, children always have larger ids so we
+// can finish them first. PEs with nothing to contribute stay out of it.
+void CharmGenerator::reduce(QVector<QList<Task> > * contributions)
+{
+    QVector<Task> forwarded = QVector<Task>(pes);
+    QVector<bool> active = QVector<bool>(pes, false);
+    bool finished = false;
+    for (int pe = pes - 1; pe >= 0; pe--)
+    {
+        QList<Task> tasks = contributions->at(pe);
+        for (int child = 2 * pe + 1; child <= 2 * pe + 2 && child < pes; child++)
+            if (active[child])
+                tasks.append(forwarded[child]);
+        if (tasks.isEmpty())
+            continue;
+        qSort(tasks);
+
+        for (int i = 0; i < tasks.size(); i++)
+        {
+            Task task = tasks.at(i);
+            waitUntil(pe, task.arrival);
+            long long time = clock[pe];
+            int entry = (task.element >= 0) ? GE_CONTRIBUTE : GE_RECVMSG;
+            int array = (task.element >= 0) ? arrayId(task.element) : 1;
+            writeBegin(pe, entry, task.pe, task.event, time, -1, array);
+            if (i == tasks.size() - 1)
+            {
+                // Pass the partial result up, or to main at the root
+                Task up;
+                up.arrival = time + call_cost / 2;
+                up.element = -1;
+                up.slot = 0;
+                up.pe = pe;
+                up.event = sendEvent(pe);
+                if (pe > 0)
+                {
+                    up.arrival += latency;
+                    writeCreation(pe, GE_RECVMSG, up.event, time + call_cost / 2,
+                                  1);
+                    forwarded[pe] = up;
+                    active[pe] = true;
+                }
+                else
+                {
+                    writeCreation(pe, GE_DONE, up.event, time + call_cost / 2, 0);
+                    forwarded[pe] = up;
+                    finished = true;
+                }
+            }
+            writeEnd(pe, entry, task.event, time + call_cost, array);
+            clock[pe] = time + call_cost;
+        }
+    }
+
+    if (!finished)
+        return;
+
+    long long time = clock[0];
+    writeBegin(0, GE_DONE, 0, forwarded[0].event, time, -1, 0);
+    writeEnd(0, GE_DONE, forwarded[0].event, time + call_cost, 0);
+    clock[0] = time + call_cost;
+}
+
+void CharmGenerator::migrate(int iteration)
+{
+    for (int i = 0; i < placement.size(); i++)
+        if (RavelUtils::hashRandom(seed, i, iteration, 3) < migration)
+            placement[i] = (placement[i] + 1) % pes;
+}
+
+// Imbalance is a per-element constant, noise changes every iteration
+long long CharmGenerator::computeTime(int element, int iteration)
+{
+    double slow = 1 + imbalance * RavelUtils::hashRandom(seed, element, 0, 1);
+    double jitter = 1 + noise * RavelUtils::hashRandom(seed, element,
+                                                       iteration, 2);
+    return (long long) (compute * slow * jitter);
+}
+
+// Neighbor across the grid in direction slot, 2 per dimension, wrapping
+int CharmGenerator::neighbor(int element, int slot)
+{
+    int base = (element / elements_per_array) * elements_per_array;
+    int local = element - base;
+    int dimension = slot / 2;
+
+    int stride = 1;
+    for (int i = dimensions.size() - 1; i > dimension; i--)
+        stride *= dimensions.at(i);
+    int extent = dimensions.at(dimension);
+    int coordinate = (local / stride) % extent;
+    int moved = (coordinate + ((slot % 2 == 0) ? 1 : extent - 1)) % extent;
+    return base + local + (moved - coordinate) * stride;
+}
+
+// Array index as the four fields of a Projections record
+QString CharmGenerator::elementIndex(int element)
+{
+    int index[4] = { 0, 0, 0, 0 };
+    if (element >= 0)
+    {
+        int local = element % elements_per_array;
+        for (int i = dimensions.size() - 1; i >= 0; i--)
+        {
+            index[i] = local % dimensions.at(i);
+            local /= dimensions.at(i);
+        }
+    }
+    return QString::number(index[0]) + " " + QString::number(index[1]) + " "
+           + QString::number(index[2]) + " " + QString::number(index[3]);
+}
+
+// Array ids start at 1, 0 means not an array
+int CharmGenerator::arrayId(int element)
+{
+    return element / elements_per_array + 1;
+}
+
+int CharmGenerator::sendEvent(int pe)
+{
+    int event = events[pe];
+    events[pe]++;
+    return event;
+}
+
+void CharmGenerator::waitUntil(int pe, long long time)
+{
+    if (time <= clock[pe])
+        return;
+
+    if (idle)
+    {
+        writeLine(pe, QString::number(BEGIN_IDLE) + " "
+                      + QString::number(clock[pe]) + " " + QString::number(pe));
+        writeLine(pe, QString::number(END_IDLE) + " "
+                      + QString::number(time) + " " + QString::number(pe));
+    }
+    clock[pe] = time;
+}
+
+// Version 7.0 records, see CharmImporter::parseLine
+void CharmGenerator::writeBegin(int pe, int entry, int sender, int event,
+                                long long time, int element, int array)
+{
+    writeLine(pe, QString::number(BEGIN_PROCESSING) + " 2 "
+                  + QString::number(entry) + " " + QString::number(time) + " "
+                  + QString::number(event) + " " + QString::number(sender) + " "
+                  + QString::number(message_size) + " "
+                  + QString::number(time) + " " + elementIndex(element) + " "
+                  + QString::number(time) + " " + QString::number(array));
+}
+
+void CharmGenerator::writeEnd(int pe, int entry, int event, long long time,
+                              int array)
+{
+    writeLine(pe, QString::number(END_PROCESSING) + " 2 "
+                  + QString::number(entry) + " " + QString::number(time) + " "
+                  + QString::number(event) + " " + QString::number(pe) + " "
+                  + QString::number(message_size) + " "
+                  + QString::number(time) + " " + QString::number(array));
+}
+
+void CharmGenerator::writeCreation(int pe, int entry, int event, long long time,
+                                   int array)
+{
+    writeLine(pe, QString::number(CREATION) + " 2 "
+                  + QString::number(entry) + " " + QString::number(time) + " "
+                  + QString::number(event) + " " + QString::number(pe) + " "
+                  + QString::number(message_size) + " "
+                  + QString::number(time) + " " + QString::number(array));
+}
+
+void CharmGenerator::writeLine(int pe, QString line)
+{
+    buffers[pe].append(line.toLatin1());
+    buffers[pe].append('\n');
+    if (buffers[pe].size() > 16 * 1024)
+        flush(pe);
+}
+
+// Append the buffer to the PE's log, gzip files get a new member each time
+// which zlib reads through transparently.
+void CharmGenerator::flush(int pe)
+{
+    if (buffers[pe].isEmpty())
+        return;
+
+    QString filename = path + "/" + basename + "." + QString::number(pe)
+                       + ".log";
+    if (gzip)
+    {
+        gzFile logfile = gzopen((filename + ".gz").toStdString().c_str(),
+                                started[pe] ? "ab" : "wb");
+        gzwrite(logfile, buffers[pe].constData(), buffers[pe].size());
+        gzclose(logfile);
+    }
+    else
+    {
+        QFile logfile(filename);
+        logfile.open(QIODevice::WriteOnly
+                     | (started[pe] ? QIODevice::Append : QIODevice::Truncate));
+        logfile.write(buffers[pe]);
+        logfile.close();
+    }
+
+    started[pe] = true;
+    buffers[pe].clear();
+}
@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CHARMGENERATOR_H
+#define CHARMGENERATOR_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+
+// Writes synthetic Charm++ Projections logs (a .sts file and one log per
+// PE) for chare arrays exchanging ghosts with their grid neighbors.
+//
+// The whole machine is simulated one iteration at a time. An element
+// receives one ghost from each neighbor, computes, and sends its own ghosts
+// for the next iteration. Each PE runs its messages in arrival order and
+// goes idle while it waits. Optional reductions go through a binary tree
+// of CkReductionMgr messages back to the main chare. Log lines are kept in
+// small per-PE buffers and appended to the files as the buffers fill, so
+// tens of thousands of PEs do not need that many open files.
+class CharmGenerator
+{
+public:
+    CharmGenerator();
+
+    bool setDimensions(QString dims);
+    QString getDimensionString();
+    long long getElementCount();
+
+    void generateTrace(QString path, QString basename);
+
+    int pes;
+    int iterations;
+    int arrays; // number of arrays sharing the shape
+    QList<int> dimensions; // extent of each of up to four dimensions
+    int entries; // compute entry methods, used in turn
+    int migration_period; // iterations between migrations, 0 for none
+    double migration; // fraction of elements moving each time
+    int reduction_period; // iterations between reductions, 0 for none
+    bool idle; // write idle records
+    bool gzip;
+    double imbalance; // persistent per-element slowdown
+    double noise; // per-iteration jitter
+    long long compute; // base compute time
+    long long message_size;
+    unsigned long seed;
+
+private:
+    // Projections record types
+    enum RecordType { CREATION = 1, BEGIN_PROCESSING = 2,
+                      END_PROCESSING = 3, BEGIN_COMPUTATION = 6,
+                      END_COMPUTATION = 7, BEGIN_IDLE = 14, END_IDLE = 15 };
+
+    // Chares and entries written to the .sts
+    enum GeneratorChare { GC_MAIN, GC_ARRAY, GC_REDUCTION };
+    enum GeneratorEntry { GE_MAIN, GE_DONE, GE_GHOST, GE_CONTRIBUTE,
+                          GE_RECVMSG, GE_COMPUTE };
+
+    // A message waiting to be processed
+    struct Task {
+        long long arrival;
+        int element; // -1 for runtime messages
+        int slot;
+        int pe; // sender
+        int event; // sender's event id
+
+        bool operator<(const Task & other) const
+        {
+            if (arrival != other.arrival)
+                return arrival < other.arrival;
+            return element < other.element;
+        }
+    };
+
+    QString path;
+    QString basename;
+    int elements_per_array;
+    int neighbors; // ghosts per element
+
+    long long latency;
+    long long call_cost;
+
+    QVector<int> placement;
+    QVector<long long> clock;
+    QVector<int> events;
+    QVector<Task> incoming;
+    QVector<Task> outgoing;
+    QVector<QByteArray> buffers;
+    QVector<bool> started;
+
+    void writeSts();
+    void simulateIteration(int iteration);
+    void startElements();
+    void processElements(int pe, int iteration, QList<int> * hosted,
+                         QList<Task> * contributions);
+    void runCompute(int pe, int iteration, int element, int sender, int event,
+                    QList<Task> * contributions);
+    void reduce(QVector<QList<Task> > * contributions);
+    void migrate(int iteration);
+
+    long long computeTime(int element, int iteration);
+    int neighbor(int element, int slot);
+    QString elementIndex(int element);
+    int arrayId(int element);
+    int sendEvent(int pe);
+    void waitUntil(int pe, long long time);
+
+    void writeBegin(int pe, int entry, int sender, int event, long long time,
+                    int element, int array);
+    void writeEnd(int pe, int entry, int event, long long time, int array);
+    void writeCreation(int pe, int entry, int event, long long time,
+                       int array);
+    void writeLine(int pe, QString line);
+    void flush(int pe);
+};
+
+#endif // CHARMGENERATOR_H
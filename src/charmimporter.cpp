@@ -28,6 +28,7 @@
 #include "metrics.h"
 
 #include "ravelutils.h"
+#include "stagetimer.h"
 
 CharmImporter::CharmImporter()
     : chares(new QMap<int, Chare*>()),
@@ -134,6 +135,7 @@ CharmImporter::~CharmImporter()
 
 void CharmImporter::importCharmLog(QString dataFileName, ImportOptions * _options)
 {
+    StageTimer stageTimer("importCharmLog");
     std::cout << "Reading " << dataFileName.toStdString().c_str() << std::endl;
     options = _options;
     readSts(dataFileName);
@@ -0,0 +1,452 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "clara.h"
+#include <QtConcurrent>
+#include <cfloat>
+#include <algorithm>
+
+#include "ravelutils.h"
+
+static const int max_swaps = 1000;
+const double Clara::min_silhouette = 0.25;
+
+// One CLARA sample: PAM on a subset of the items, then the assignment of
+// every item to the nearest of the medoids found
+class ClaraSample
+{
+public:
+    ClaraSample(const Clara::Distance * _distance, int _n, int _k, int _size,
+                unsigned long _seed, int _index)
+        : distance(_distance), n(_n), k(_k), size(_size), seed(_seed),
+          index(_index), items(QVector<int>()), medoids(QVector<int>()),
+          cluster_ids(QVector<int>()), total_distance(DBL_MAX) {}
+
+    const Clara::Distance * distance;
+    int n;
+    int k;
+    int size;
+    unsigned long seed;
+    int index;
+    QVector<int> items;
+    QVector<int> medoids;
+    QVector<int> cluster_ids;
+    double total_distance;
+};
+
+// PAM over the sampled items, by their position in the sample
+class Pam
+{
+public:
+    Pam(int _size)
+        : size(_size),
+          matrix(QVector<double>(_size * _size, 0)),
+          medoids(QVector<int>()),
+          is_medoid(QVector<bool>(_size, false)),
+          nearest(QVector<int>(_size, 0)),
+          nearest_distance(QVector<double>(_size, DBL_MAX)),
+          second_distance(QVector<double>(_size, DBL_MAX)) {}
+
+    double d(int i, int j) const { return matrix.at(i * size + j); }
+    void build(int k);
+    void addMedoid();
+    void refine();
+    double silhouette() const;
+    void findNearest();
+    double swapCost(int medoid, int candidate) const;
+    void swap(int medoid, int candidate);
+
+    int size;
+    QVector<double> matrix;
+    QVector<int> medoids; // positions in the sample
+    QVector<bool> is_medoid;
+    QVector<int> nearest; // index into medoids
+    QVector<double> nearest_distance;
+    QVector<double> second_distance;
+};
+
+// Greedy initial medoids: the most central item, then whichever item
+// reduces the total distance most, until there are k
+void Pam::build(int k)
+{
+    int first = 0;
+    double best = DBL_MAX;
+    for (int i = 0; i < size; i++)
+    {
+        double total = 0;
+        for (int j = 0; j < size; j++)
+            total += d(i, j);
+        if (total < best)
+        {
+            best = total;
+            first = i;
+        }
+    }
+    medoids.clear();
+    is_medoid.fill(false);
+    medoids.append(first);
+    is_medoid[first] = true;
+    findNearest();
+
+    while (medoids.size() < k)
+        addMedoid();
+}
+
+// Add the item that reduces the total distance most to the current medoids
+void Pam::addMedoid()
+{
+    int chosen = -1;
+    double best_gain = -1;
+    for (int i = 0; i < size; i++)
+    {
+        if (is_medoid.at(i))
+            continue;
+        double gain = 0;
+        for (int j = 0; j < size; j++)
+            gain += std::max(nearest_distance.at(j) - d(i, j), 0.0);
+        if (gain > best_gain)
+        {
+            best_gain = gain;
+            chosen = i;
+        }
+    }
+    if (chosen < 0)
+        return;
+    medoids.append(chosen);
+    is_medoid[chosen] = true;
+    findNearest();
+}
+
+void Pam::findNearest()
+{
+    for (int j = 0; j < size; j++)
+    {
+        nearest[j] = 0;
+        nearest_distance[j] = DBL_MAX;
+        second_distance[j] = DBL_MAX;
+        for (int m = 0; m < medoids.size(); m++)
+        {
+            double dm = d(medoids.at(m), j);
+            if (dm < nearest_distance.at(j))
+            {
+                second_distance[j] = nearest_distance.at(j);
+                nearest_distance[j] = dm;
+                nearest[j] = m;
+            }
+            else if (dm < second_distance.at(j))
+            {
+                second_distance[j] = dm;
+            }
+        }
+    }
+}
+
+// Change in total distance from replacing medoids[medoid] by candidate
+double Pam::swapCost(int medoid, int candidate) const
+{
+    double cost = 0;
+    for (int j = 0; j < size; j++)
+    {
+        double dc = d(candidate, j);
+        if (nearest.at(j) == medoid)
+            cost += std::min(dc, second_distance.at(j)) - nearest_distance.at(j);
+        else if (dc < nearest_distance.at(j))
+            cost += dc - nearest_distance.at(j);
+    }
+    return cost;
+}
+
+void Pam::swap(int medoid, int candidate)
+{
+    is_medoid[medoids.at(medoid)] = false;
+    is_medoid[candidate] = true;
+    medoids[medoid] = candidate;
+    findNearest();
+}
+
+// The best swap of one candidate with any of the current medoids
+class SwapCandidate
+{
+public:
+    SwapCandidate(const Pam * _pam, int _candidate)
+        : pam(_pam), candidate(_candidate), medoid(-1), cost(DBL_MAX) {}
+
+    const Pam * pam;
+    int candidate;
+    int medoid;
+    double cost;
+};
+
+static void evaluateSwap(SwapCandidate& swap)
+{
+    for (int m = 0; m < swap.pam->medoids.size(); m++)
+    {
+        double cost = swap.pam->swapCost(m, swap.candidate);
+        if (cost < swap.cost)
+        {
+            swap.cost = cost;
+            swap.medoid = m;
+        }
+    }
+}
+
+// Take the best swap until none improves. Candidates are evaluated
+// concurrently but reduced in order, so ties break the same way every time.
+void Pam::refine()
+{
+    QVector<SwapCandidate> swaps;
+    for (int iteration = 0; iteration < max_swaps; iteration++)
+    {
+        swaps.clear();
+        for (int i = 0; i < size; i++)
+            if (!is_medoid.at(i))
+                swaps.append(SwapCandidate(this, i));
+        QtConcurrent::blockingMap(swaps, evaluateSwap);
+
+        const SwapCandidate * best = NULL;
+        for (QVector<SwapCandidate>::ConstIterator candidate = swaps.constBegin();
+             candidate != swaps.constEnd(); ++candidate)
+        {
+            if (candidate->medoid >= 0 && (!best || candidate->cost < best->cost))
+                best = &(*candidate);
+        }
+        if (!best || best->cost >= 0)
+            break;
+        swap(best->medoid, best->candidate);
+    }
+}
+
+// Mean silhouette of the sample over the current medoids
+double Pam::silhouette() const
+{
+    int k = medoids.size();
+    if (k < 2)
+        return 0;
+    QVector<int> counts(k, 0);
+    for (int j = 0; j < size; j++)
+        counts[nearest.at(j)]++;
+
+    double total = 0;
+    QVector<double> sums(k);
+    for (int j = 0; j < size; j++)
+    {
+        int own = nearest.at(j);
+        if (counts.at(own) < 2)
+            continue; // Singletons count as zero
+        sums.fill(0);
+        for (int i = 0; i < size; i++)
+            sums[nearest.at(i)] += d(i, j);
+        double a = sums.at(own) / (counts.at(own) - 1);
+        double b = DBL_MAX;
+        for (int c = 0; c < k; c++)
+            if (c != own && counts.at(c))
+                b = std::min(b, sums.at(c) / counts.at(c));
+        double scale = std::max(a, b);
+        if (scale > 0 && scale < DBL_MAX)
+            total += (b - a) / scale;
+    }
+    return total / size;
+}
+
+// Assignment of items [first, last) to their nearest medoid
+class AssignChunk
+{
+public:
+    AssignChunk(ClaraSample * _sample, int _first, int _last)
+        : sample(_sample), first(_first), last(_last), total_distance(0) {}
+
+    ClaraSample * sample;
+    int first;
+    int last;
+    double total_distance;
+};
+
+// Each medoid is compared against the whole chunk in one batch, then each
+// item takes the nearest, the lowest cluster on ties
+static void assignChunk(AssignChunk& chunk)
+{
+    const QVector<int>& medoids = chunk.sample->medoids;
+    int count = chunk.last - chunk.first;
+    QVector<int> items(count);
+    for (int i = 0; i < count; i++)
+        items[i] = chunk.first + i;
+
+    QVector<int> ids(count, 0);
+    QVector<double> best(count, DBL_MAX);
+    QVector<double> row(count);
+    for (int c = 0; c < medoids.size(); c++)
+    {
+        chunk.sample->distance->distances(medoids.at(c), items.constData(),
+                                          count, row.data());
+        for (int i = 0; i < count; i++)
+        {
+            double dc = (items.at(i) == medoids.at(c)) ? 0 : row.at(i);
+            if (dc < best.at(i))
+            {
+                best[i] = dc;
+                ids[i] = c;
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        chunk.sample->cluster_ids[chunk.first + i] = ids.at(i);
+        chunk.total_distance += best.at(i);
+    }
+}
+
+// Draw the sample with a partial shuffle and fill in its distances
+static void drawSample(ClaraSample& sample, Pam& pam)
+{
+    if (sample.size < sample.n)
+    {
+        QVector<int> order(sample.n);
+        for (int i = 0; i < sample.n; i++)
+            order[i] = i;
+        for (int i = 0; i < sample.size; i++)
+        {
+            int j = i + int(RavelUtils::hashRandom(sample.seed, sample.index, i, 4)
+                            * (sample.n - i));
+            std::swap(order[i], order[j]);
+        }
+        sample.items = order.mid(0, sample.size);
+        std::sort(sample.items.begin(), sample.items.end());
+    }
+    else
+    {
+        sample.items.resize(sample.n);
+        for (int i = 0; i < sample.n; i++)
+            sample.items[i] = i;
+    }
+
+    // The matrix the PAM swaps read, a batch of row i against the earlier
+    // items at a time
+    QVector<double> row(sample.size);
+    for (int i = 1; i < sample.size; i++)
+    {
+        sample.distance->distances(sample.items.at(i), sample.items.constData(),
+                                   i, row.data());
+        for (int j = 0; j < i; j++)
+        {
+            pam.matrix[i * sample.size + j] = row.at(j);
+            pam.matrix[j * sample.size + i] = row.at(j);
+        }
+    }
+}
+
+static void runSample(ClaraSample& sample)
+{
+    Pam pam(sample.size);
+    drawSample(sample, pam);
+    pam.build(sample.k);
+    pam.refine();
+
+    for (QVector<int>::Iterator m = pam.medoids.begin(); m != pam.medoids.end(); ++m)
+        sample.medoids.append(sample.items.at(*m));
+    std::sort(sample.medoids.begin(), sample.medoids.end());
+
+    // Assign everything, summing the chunks in order
+    sample.cluster_ids.resize(sample.n);
+    QVector<AssignChunk> chunks;
+    for (int first = 0; first < sample.n; first += Clara::chunk_size)
+        chunks.append(AssignChunk(&sample, first,
+                                  std::min(sample.n, first + Clara::chunk_size)));
+    QtConcurrent::blockingMap(chunks, assignChunk);
+    sample.total_distance = 0;
+    for (QVector<AssignChunk>::Iterator chunk = chunks.begin();
+         chunk != chunks.end(); ++chunk)
+    {
+        sample.total_distance += chunk->total_distance;
+    }
+}
+
+Clara::Clara(int _n, unsigned long _seed)
+    : n(_n),
+      seed(_seed),
+      medoids(QVector<int>()),
+      cluster_ids(QVector<int>(_n, 0)),
+      total_distance(0)
+{
+}
+
+void Clara::cluster(const Distance * distance, int k)
+{
+    medoids.clear();
+    cluster_ids.fill(0);
+    total_distance = 0;
+    k = std::min(k, n);
+    if (k <= 0)
+        return;
+
+    // Sample size as suggested by Kaufman & Rousseeuw. When that covers
+    // everything, one run of PAM is the answer.
+    int size = std::min(n, 40 + 2 * k);
+    int count = (size == n) ? 1 : num_samples;
+    QVector<ClaraSample> samples;
+    for (int i = 0; i < count; i++)
+        samples.append(ClaraSample(distance, n, k, size, seed, i));
+    QtConcurrent::blockingMap(samples, runSample);
+
+    int best = 0;
+    for (int i = 1; i < samples.size(); i++)
+        if (samples.at(i).total_distance < samples.at(best).total_distance)
+            best = i;
+    medoids = samples.at(best).medoids;
+    cluster_ids = samples.at(best).cluster_ids;
+    total_distance = samples.at(best).total_distance;
+}
+
+// Grow the medoids of one sample a cluster at a time, refining each count
+// with PAM swaps from the previous count's medoids. The distances are
+// computed once for the sample, so this costs far less than clustering
+// everything. Returns the count with the best mean silhouette, or 1 if no
+// count separates the sample.
+int Clara::chooseClusters(const Distance * distance, int max_k) const
+{
+    max_k = std::min(max_k, n);
+    if (max_k < 2)
+        return std::max(max_k, 1);
+
+    ClaraSample sample(distance, n, max_k, std::min(n, 40 + 2 * max_k),
+                       seed, num_samples);
+    Pam pam(sample.size);
+    drawSample(sample, pam);
+
+    int best_k = 1;
+    double best = min_silhouette;
+    pam.build(1);
+    for (int k = 2; k <= max_k; k++)
+    {
+        pam.addMedoid();
+        pam.refine();
+        double score = pam.silhouette();
+        if (score > best)
+        {
+            best = score;
+            best_k = k;
+        }
+    }
+    return best_k;
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CLARA_H
+#define CLARA_H
+
+#include <QVector>
+
+// k-medoids clustering with CLARA (Kaufman & Rousseeuw 1990). PAM is run on
+// several random samples of the items and every item is then assigned to
+// the nearest medoid of each sample's result, keeping the one with the
+// lowest total distance.
+//
+// The samples run concurrently, and within a sample the PAM swap costs are
+// evaluated concurrently over the candidates. Samples are drawn from the
+// seed and ties are broken by index, so the result depends only on the
+// seed and not on the threads.
+class Clara
+{
+public:
+    // Distance between items i and j. Called from several threads at once.
+    // distances() gives item i against several others in one call, which
+    // a Distance can override to compute them as a batch.
+    class Distance {
+    public:
+        virtual ~Distance() {}
+        virtual double distance(int i, int j) const = 0;
+        virtual void distances(int i, const int * others, int count,
+                               double * results) const
+        {
+            for (int j = 0; j < count; j++)
+                results[j] = distance(i, others[j]);
+        }
+    };
+
+    Clara(int _n, unsigned long _seed);
+
+    void cluster(const Distance * distance, int k);
+
+    // A number of clusters up to max_k, chosen by silhouette on a sample
+    int chooseClusters(const Distance * distance, int max_k) const;
+    int numClusters() const { return medoids.size(); }
+    int medoid(int c) const { return medoids.at(c); }
+    int clusterOf(int i) const { return cluster_ids.at(i); }
+    double totalDistance() const { return total_distance; }
+
+    static const int num_samples = 5;
+    static const int chunk_size = 256; // items per assignment task
+    static const double min_silhouette; // below this the data is one cluster
+
+private:
+    int n;
+    unsigned long seed;
+    QVector<int> medoids; // ascending, cluster c has medoid medoids[c]
+    QVector<int> cluster_ids;
+    double total_distance;
+};
+
+#endif // CLARA_H
@@ -22,9 +22,6 @@ public:
     ClusterEntity& operator+(const ClusterEntity &);
     ClusterEntity& operator/(const int);
     ClusterEntity& operator=(const ClusterEntity &);
-
-    double calculateMetricDistance(const ClusterEntity& other) const;
-
 };
 
 #endif // CLUSTERENTITY_H
@@ -0,0 +1,325 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "clustermatrix.h"
+#include <QtGlobal>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CLUSTERMATRIX_X86
+#include <immintrin.h>
+#endif
+
+// Sum of squared differences of two runs of doubles
+typedef double (*SquaredDifference)(const double *, const double *, int);
+// The same for one run against four others, written to sums[0..3]
+typedef void (*SquaredDifferences4)(const double *, const double * const *,
+                                    int, double *);
+
+static double squaredDifferenceScalar(const double * a, const double * b,
+                                      int count)
+{
+    double total = 0;
+    for (int i = 0; i < count; i++)
+        total += (a[i] - b[i]) * (a[i] - b[i]);
+    return total;
+}
+
+static void squaredDifferences4Scalar(const double * a,
+                                      const double * const * b, int count,
+                                      double * sums)
+{
+    double total0 = 0, total1 = 0, total2 = 0, total3 = 0;
+    for (int i = 0; i < count; i++)
+    {
+        double value = a[i];
+        total0 += (value - b[0][i]) * (value - b[0][i]);
+        total1 += (value - b[1][i]) * (value - b[1][i]);
+        total2 += (value - b[2][i]) * (value - b[2][i]);
+        total3 += (value - b[3][i]) * (value - b[3][i]);
+    }
+    sums[0] = total0;
+    sums[1] = total1;
+    sums[2] = total2;
+    sums[3] = total3;
+}
+
+#ifdef CLUSTERMATRIX_X86
+__attribute__((target("avx2,fma")))
+static double squaredDifferenceAVX2(const double * a, const double * b,
+                                    int count)
+{
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256d diff1 = _mm256_sub_pd(_mm256_loadu_pd(a + i),
+                                      _mm256_loadu_pd(b + i));
+        __m256d diff2 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4),
+                                      _mm256_loadu_pd(b + i + 4));
+        sum1 = _mm256_fmadd_pd(diff1, diff1, sum1);
+        sum2 = _mm256_fmadd_pd(diff2, diff2, sum2);
+    }
+    sum1 = _mm256_add_pd(sum1, sum2);
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum1);
+    double total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < count; i++)
+        total += (a[i] - b[i]) * (a[i] - b[i]);
+    return total;
+}
+
+__attribute__((target("avx512f")))
+static double squaredDifferenceAVX512(const double * a, const double * b,
+                                      int count)
+{
+    __m512d sum = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512d diff = _mm512_sub_pd(_mm512_loadu_pd(a + i),
+                                     _mm512_loadu_pd(b + i));
+        sum = _mm512_fmadd_pd(diff, diff, sum);
+    }
+    if (i < count) // Masked tail
+    {
+        __mmask8 mask = (__mmask8) ((1u << (count - i)) - 1);
+        __m512d diff = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                                     _mm512_maskz_loadu_pd(mask, b + i));
+        sum = _mm512_fmadd_pd(diff, diff, sum);
+    }
+    return _mm512_reduce_add_pd(sum);
+}
+
+__attribute__((target("avx2,fma")))
+static void squaredDifferences4AVX2(const double * a,
+                                    const double * const * b, int count,
+                                    double * sums)
+{
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd();
+    __m256d sum3 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d value = _mm256_loadu_pd(a + i);
+        __m256d diff0 = _mm256_sub_pd(value, _mm256_loadu_pd(b[0] + i));
+        __m256d diff1 = _mm256_sub_pd(value, _mm256_loadu_pd(b[1] + i));
+        __m256d diff2 = _mm256_sub_pd(value, _mm256_loadu_pd(b[2] + i));
+        __m256d diff3 = _mm256_sub_pd(value, _mm256_loadu_pd(b[3] + i));
+        sum0 = _mm256_fmadd_pd(diff0, diff0, sum0);
+        sum1 = _mm256_fmadd_pd(diff1, diff1, sum1);
+        sum2 = _mm256_fmadd_pd(diff2, diff2, sum2);
+        sum3 = _mm256_fmadd_pd(diff3, diff3, sum3);
+    }
+    double lanes[4][4];
+    _mm256_storeu_pd(lanes[0], sum0);
+    _mm256_storeu_pd(lanes[1], sum1);
+    _mm256_storeu_pd(lanes[2], sum2);
+    _mm256_storeu_pd(lanes[3], sum3);
+    for (int j = 0; j < 4; j++)
+    {
+        double total = lanes[j][0] + lanes[j][1] + lanes[j][2] + lanes[j][3];
+        for (int tail = i; tail < count; tail++)
+            total += (a[tail] - b[j][tail]) * (a[tail] - b[j][tail]);
+        sums[j] = total;
+    }
+}
+
+__attribute__((target("avx512f")))
+static void squaredDifferences4AVX512(const double * a,
+                                      const double * const * b, int count,
+                                      double * sums)
+{
+    __m512d sum0 = _mm512_setzero_pd();
+    __m512d sum1 = _mm512_setzero_pd();
+    __m512d sum2 = _mm512_setzero_pd();
+    __m512d sum3 = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512d value = _mm512_loadu_pd(a + i);
+        __m512d diff0 = _mm512_sub_pd(value, _mm512_loadu_pd(b[0] + i));
+        __m512d diff1 = _mm512_sub_pd(value, _mm512_loadu_pd(b[1] + i));
+        __m512d diff2 = _mm512_sub_pd(value, _mm512_loadu_pd(b[2] + i));
+        __m512d diff3 = _mm512_sub_pd(value, _mm512_loadu_pd(b[3] + i));
+        sum0 = _mm512_fmadd_pd(diff0, diff0, sum0);
+        sum1 = _mm512_fmadd_pd(diff1, diff1, sum1);
+        sum2 = _mm512_fmadd_pd(diff2, diff2, sum2);
+        sum3 = _mm512_fmadd_pd(diff3, diff3, sum3);
+    }
+    if (i < count) // Masked tail
+    {
+        __mmask8 mask = (__mmask8) ((1u << (count - i)) - 1);
+        __m512d value = _mm512_maskz_loadu_pd(mask, a + i);
+        __m512d diff0 = _mm512_sub_pd(value, _mm512_maskz_loadu_pd(mask, b[0] + i));
+        __m512d diff1 = _mm512_sub_pd(value, _mm512_maskz_loadu_pd(mask, b[1] + i));
+        __m512d diff2 = _mm512_sub_pd(value, _mm512_maskz_loadu_pd(mask, b[2] + i));
+        __m512d diff3 = _mm512_sub_pd(value, _mm512_maskz_loadu_pd(mask, b[3] + i));
+        sum0 = _mm512_fmadd_pd(diff0, diff0, sum0);
+        sum1 = _mm512_fmadd_pd(diff1, diff1, sum1);
+        sum2 = _mm512_fmadd_pd(diff2, diff2, sum2);
+        sum3 = _mm512_fmadd_pd(diff3, diff3, sum3);
+    }
+    sums[0] = _mm512_reduce_add_pd(sum0);
+    sums[1] = _mm512_reduce_add_pd(sum1);
+    sums[2] = _mm512_reduce_add_pd(sum2);
+    sums[3] = _mm512_reduce_add_pd(sum3);
+}
+#endif
+
+static SquaredDifference chooseKernel(const char ** name,
+                                      SquaredDifferences4 * batch)
+{
+#ifdef CLUSTERMATRIX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        *name = "avx512";
+        *batch = squaredDifferences4AVX512;
+        return squaredDifferenceAVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        *name = "avx2";
+        *batch = squaredDifferences4AVX2;
+        return squaredDifferenceAVX2;
+    }
+#endif
+    *name = "scalar";
+    *batch = squaredDifferences4Scalar;
+    return squaredDifferenceScalar;
+}
+
+static const char * kernel_name = "scalar";
+static SquaredDifferences4 squaredDifferences4 = squaredDifferences4Scalar;
+static const SquaredDifference squaredDifference
+        = chooseKernel(&kernel_name, &squaredDifferences4);
+
+ClusterMatrix::ClusterMatrix(int _rows, int _columns)
+    : num_rows(_rows),
+      num_columns(_columns),
+      stride((_columns + 7) / 8 * 8),
+      data(NULL),
+      starts(QVector<int>(_rows, _columns))
+{
+    size_t bytes = (size_t) num_rows * stride * sizeof(double);
+    data = static_cast<double *>(qMallocAligned(qMax(bytes, (size_t) 64), 64));
+    memset(data, 0, bytes);
+}
+
+ClusterMatrix::~ClusterMatrix()
+{
+    qFreeAligned(data);
+}
+
+void ClusterMatrix::setRow(int r, const long long int * values, int count)
+{
+    count = qMin(count, num_columns);
+    double * row = data + (long long) r * stride;
+    starts[r] = num_columns - count;
+    for (int i = 0; i < count; i++)
+        row[starts.at(r) + i] = values[i];
+}
+
+double ClusterMatrix::distance(int r1, int r2) const
+{
+    int first = qMax(starts.at(r1), starts.at(r2));
+    int count = num_columns - first;
+    if (count <= 0)
+        return -1;
+    return squaredDifference(row(r1) + first, row(r2) + first, count) / count;
+}
+
+// Four rows share the columns from the latest of their starts on, which go
+// through the batch kernel against row r together. Whatever a row has
+// before that is added pairwise.
+void ClusterMatrix::distances4(int r, const int * others, double * results) const
+{
+    int firsts[4];
+    int shared = starts.at(r);
+    for (int j = 0; j < 4; j++)
+    {
+        firsts[j] = qMax(starts.at(r), starts.at(others[j]));
+        shared = qMax(shared, firsts[j]);
+    }
+
+    const double * rows[4];
+    for (int j = 0; j < 4; j++)
+        rows[j] = row(others[j]) + shared;
+    double sums[4];
+    squaredDifferences4(row(r) + shared, rows, num_columns - shared, sums);
+
+    for (int j = 0; j < 4; j++)
+    {
+        int count = num_columns - firsts[j];
+        if (count <= 0)
+        {
+            results[j] = -1;
+            continue;
+        }
+        if (firsts[j] < shared)
+            sums[j] += squaredDifference(row(r) + firsts[j],
+                                         row(others[j]) + firsts[j],
+                                         shared - firsts[j]);
+        results[j] = sums[j] / count;
+    }
+}
+
+void ClusterMatrix::distances(int r, int first, int last, double * results) const
+{
+    int others[4];
+    int other = first;
+    for (; other + 4 <= last; other += 4)
+    {
+        for (int j = 0; j < 4; j++)
+            others[j] = other + j;
+        distances4(r, others, results + (other - first));
+    }
+    for (; other < last; other++)
+        results[other - first] = distance(r, other);
+}
+
+void ClusterMatrix::distances(int r, const int * others, int count,
+                              double * results) const
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+        distances4(r, others + i, results + i);
+    for (; i < count; i++)
+        results[i] = distance(r, others[i]);
+}
+
+const char * ClusterMatrix::kernelName()
+{
+    return kernel_name;
+}
+
+long long ClusterMatrix::memoryBytes() const
+{
+    return sizeof(ClusterMatrix) + (long long) num_rows * stride * sizeof(double)
+           + starts.capacity() * sizeof(int);
+}
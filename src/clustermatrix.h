@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef CLUSTERMATRIX_H
+#define CLUSTERMATRIX_H
+
+#include <QVector>
+
+// The cluster vectors of a partition as one matrix, a row per entity. Rows
+// are contiguous doubles padded to 64 bytes so the distance kernel can use
+// SIMD. Each entity's vector is right aligned as they all run to the end of
+// the partition, and only overlapping columns are compared.
+//
+// The kernel is picked when the library loads: AVX-512, AVX2 or scalar.
+class ClusterMatrix
+{
+public:
+    ClusterMatrix(int _rows, int _columns);
+    ~ClusterMatrix();
+
+    int rows() const { return num_rows; }
+    int columns() const { return num_columns; }
+
+    // Fill the end of row r with count values
+    void setRow(int r, const long long int * values, int count);
+    int start(int r) const { return starts.at(r); }
+    const double * row(int r) const { return data + (long long) r * stride; }
+
+    // Mean squared difference over the columns both rows have, or -1 if
+    // they have none
+    double distance(int r1, int r2) const;
+
+    // Distances from row r to rows [first, last), or to count given rows.
+    // Row r is compared against four other rows at a time, so each part of
+    // it is loaded once per four rows rather than once per pair.
+    void distances(int r, int first, int last, double * results) const;
+    void distances(int r, const int * others, int count,
+                   double * results) const;
+
+    long long memoryBytes() const;
+
+    static const char * kernelName();
+
+private:
+    void distances4(int r, const int * others, double * results) const;
+
+    int num_rows;
+    int num_columns;
+    int stride; // doubles per row
+    double * data;
+    QVector<int> starts;
+};
+
+#endif // CLUSTERMATRIX_H
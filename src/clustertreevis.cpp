@@ -23,11 +23,11 @@
 // Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 //////////////////////////////////////////////////////////////////////////////
 #include "clustertreevis.h"
-#include "gnome.h"
+#include "gnomedrawer.h"
 
 ClusterTreeVis::ClusterTreeVis(QWidget *parent, VisOptions * _options)
     : VisWidget(parent, _options),
-      gnome(NULL)
+      drawer(NULL)
 {
     backgroundColor = palette().color(QPalette::Background);
     setAutoFillBackground(true);
@@ -35,9 +35,9 @@ ClusterTreeVis::ClusterTreeVis(QWidget *parent, VisOptions * _options)
 
 // We do everything based on the active gnome which is set here.
 // This vis does not keep track of anything else like the others do
-void ClusterTreeVis::setGnome(Gnome * _gnome)
+void ClusterTreeVis::setGnomeDrawer(GnomeDrawer * _drawer)
 {
-    gnome = _gnome;
+    drawer = _drawer;
     //repaint();
 }
 
@@ -47,10 +47,10 @@ void ClusterTreeVis::qtPaint(QPainter *painter)
     if (!visProcessed)
         return;
 
-    if (gnome)
+    if (drawer)
     {
-        gnome->drawTopLabels(painter, rect());
-        gnome->drawQtTree(painter, rect());
+        drawer->drawTopLabels(painter, rect());
+        drawer->drawQtTree(painter, rect());
     }
 
 }
@@ -58,9 +58,9 @@ void ClusterTreeVis::qtPaint(QPainter *painter)
 // Pass to active gnome
 void ClusterTreeVis::mouseDoubleClickEvent(QMouseEvent * event)
 {
-    if (gnome)
+    if (drawer)
     {
-        gnome->handleTreeDoubleClick(event);
+        drawer->handleTreeDoubleClick(event);
         changeSource = true;
         emit(clusterChange());
         repaint();
@@ -27,19 +27,21 @@
 
 #include "viswidget.h"
 
+class GnomeDrawer;
+
 class ClusterTreeVis : public VisWidget
 {
     Q_OBJECT
 public:
     explicit ClusterTreeVis(QWidget *parent = 0,
                             VisOptions * _options = new VisOptions());
-    Gnome * getGnome() { return gnome; }
+    GnomeDrawer * getGnomeDrawer() { return drawer; }
 
 signals:
     void clusterChange();
     
 public slots:
-    void setGnome(Gnome * _gnome);
+    void setGnomeDrawer(GnomeDrawer * _drawer);
     void clusterChanged();
 
 protected:
@@ -48,7 +50,7 @@ protected:
     void mousePressEvent(QMouseEvent * event);
     
 private:
-    Gnome * gnome;
+    GnomeDrawer * drawer;
 };
 
 #endif // CLUSTERTREEVIS_H
@@ -26,8 +26,10 @@
 #include "clustertreevis.h"
 #include "trace.h"
 #include "gnome.h"
+#include "gnomedrawer.h"
 
 #include <QMouseEvent>
+#include <QElapsedTimer>
 #include <QWheelEvent>
 
 #include <cmath>
@@ -35,17 +37,49 @@
 ClusterVis::ClusterVis(ClusterTreeVis *ctv, QWidget* parent,
                        VisOptions *_options)
     : TimelineVis(parent, _options),
-      drawnGnomes(QMap<Gnome *, QRect>()),
+      gnomeDrawers(QMap<Gnome *, GnomeDrawer *>()),
+      drawnGnomes(QMap<GnomeDrawer *, QRect>()),
       selected(NULL),
       treevis(ctv),
       hover_gnome(NULL)
 {
 }
 
+ClusterVis::~ClusterVis()
+{
+    clearGnomeDrawers();
+}
+
+// Drawing state for each gnome lives here rather than in the gnome
+GnomeDrawer * ClusterVis::getGnomeDrawer(Gnome * gnome)
+{
+    GnomeDrawer * drawer = gnomeDrawers.value(gnome, NULL);
+    if (!drawer)
+    {
+        drawer = GnomeDrawer::create(gnome);
+        gnomeDrawers.insert(gnome, drawer);
+    }
+    return drawer;
+}
+
+void ClusterVis::clearGnomeDrawers()
+{
+    for (QMap<Gnome *, GnomeDrawer *>::Iterator drawer = gnomeDrawers.begin();
+         drawer != gnomeDrawers.end(); ++drawer)
+    {
+        delete drawer.value();
+    }
+    gnomeDrawers.clear();
+    drawnGnomes.clear();
+    hover_gnome = NULL;
+}
+
 // Standard initialization
 void ClusterVis::setTrace(Trace * t)
 {
     VisWidget::setTrace(t);
+    clearGnomeDrawers();
+    treevis->setGnomeDrawer(NULL);
     // Initial conditions
     if (options->showAggregateSteps)
         startStep = -1;
@@ -118,31 +152,37 @@ void ClusterVis::mouseMoveEvent(QMouseEvent * event)
     {
         mousex = event->x();
         mousey = event->y();
-        Gnome * focus_gnome = treevis->getGnome();
+
+        // Gnomes are found where the frame on screen drew them
+        QMouseEvent frameEvent(event->type(), framePoint(event->pos()),
+                               event->button(), event->buttons(),
+                               event->modifiers());
+        QPoint point = frameEvent.pos();
+        GnomeDrawer * focus_gnome = treevis->getGnomeDrawer();
         bool emit_flag = false;
-        if (hover_gnome && drawnGnomes[hover_gnome].contains(mousex, mousey))
+        if (hover_gnome && drawnGnomes[hover_gnome].contains(point))
         {
-            if (hover_gnome->handleHover(event))
+            if (hover_gnome->handleHover(&frameEvent))
                 repaint();
             if (hover_gnome != focus_gnome)
             {
-                treevis->setGnome(hover_gnome);
+                treevis->setGnomeDrawer(hover_gnome);
                 emit_flag = true;
             }
         }
         else
         {
             hover_gnome = NULL;
-            for (QMap<Gnome *, QRect>::Iterator grect = drawnGnomes.begin();
+            for (QMap<GnomeDrawer *, QRect>::Iterator grect = drawnGnomes.begin();
                  grect != drawnGnomes.end(); ++grect)
             {
-                if (grect.value().contains(mousex, mousey))
+                if (grect.value().contains(point))
                 {
                     hover_gnome = grect.key();
-                    hover_gnome->handleHover(event);
+                    hover_gnome->handleHover(&frameEvent);
                     if (hover_gnome != focus_gnome)
                     {
-                        treevis->setGnome(hover_gnome);
+                        treevis->setGnomeDrawer(hover_gnome);
                         emit_flag = true;
                     }
                 }
@@ -193,34 +233,37 @@ void ClusterVis::mouseDoubleClickEvent(QMouseEvent * event)
     if (!visProcessed)
         return;
 
-    int x = event->x();
-    int y = event->y();
+    QMouseEvent frameEvent(event->type(), framePoint(event->pos()),
+                           event->button(), event->buttons(),
+                           event->modifiers());
+    int x = frameEvent.x();
+    int y = frameEvent.y();
 
     // Reset selection for other gnomes -- the gnomes can't tell if one is
     // selected and another is not, so this effectively clears the selection in
     // the old gnome when a different one has become selected. We should
     // probably just save the one that's currently selected, but this list is
     //fairly short and we need it anyway for other interactions.
-    for (QMap<Gnome *, QRect>::Iterator gnome = drawnGnomes.begin();
+    for (QMap<GnomeDrawer *, QRect>::Iterator gnome = drawnGnomes.begin();
          gnome != drawnGnomes.end(); ++gnome)
     {
         gnome.key()->setSelected(false);
     }
 
-    for (QMap<Gnome *, QRect>::Iterator gnome = drawnGnomes.begin();
+    for (QMap<GnomeDrawer *, QRect>::Iterator gnome = drawnGnomes.begin();
          gnome != drawnGnomes.end(); ++gnome)
     {
         if (gnome.value().contains(x,y))
         {
-            Gnome * g = gnome.key();
-            Gnome::ChangeType change = g->handleDoubleClick(event);
+            GnomeDrawer * g = gnome.key();
+            GnomeDrawer::ChangeType change = g->handleDoubleClick(&frameEvent);
             repaint();
-            if (change == Gnome::CHANGE_CLUSTER) // Clicked to open Cluster
+            if (change == GnomeDrawer::CHANGE_CLUSTER) // Clicked to open Cluster
             {
                 changeSource = true;
                 emit(clusterChange());
             }
-            else if (change == Gnome::CHANGE_SELECTION) // Selected a cluster
+            else if (change == GnomeDrawer::CHANGE_SELECTION) // Selected a cluster
             {
                 changeSource = true;
                 PartitionCluster * pc = g->getSelectedPartitionCluster();
@@ -228,7 +271,7 @@ void ClusterVis::mouseDoubleClickEvent(QMouseEvent * event)
                 {
                     changeSource = false;
                     g->setSelected(true);
-                    emit(entitiesSelected(*(pc->members), g));
+                    emit(entitiesSelected(*(pc->members), g->getGnome()));
 
                 }
                 else
@@ -259,6 +302,19 @@ void ClusterVis::clusterChanged()
 
 
 // Called before drawing begins
+// Gnomes lay out their own rows, so only steps move with the view.
+bool ClusterVis::viewRange(ViewRange * range)
+{
+    range->plot = QRect(labelWidth, 0, rect().width() - labelWidth,
+                        rect().height());
+    range->x = startStep;
+    if (options->showAggregateSteps)
+        range->xscale = floor(rect().width() / stepSpan);
+    else
+        range->xscale = floor(rect().width() / (ceil(stepSpan / 2.0))) / 2;
+    return range->xscale > 0;
+}
+
 void ClusterVis::prepaint()
 {
     if (!visProcessed)
@@ -372,6 +428,9 @@ void ClusterVis::drawNativeGL()
     Partition * part = NULL;
     int topStep = boundStep(startStep + stepSpan) + 1;
     int bottomStep = floor(startStep) - 1;
+    QElapsedTimer walk;
+    walk.start();
+    int partitions = 0;
     for (int i = startPartition; i < trace->partitions->length(); ++i)
     {
         part = trace->partitions->at(i);
@@ -379,21 +438,24 @@ void ClusterVis::drawNativeGL()
             break;
         else if (part->max_global_step < bottomStep)
             continue;
+        partitions++;
         if (part->gnome)
         {
             // The y value here of 0 isn't general... we need another structure
             // to keep track of how much y is used when we're doing the gnome
             // thing.
-            part->gnome->drawGnomeGL(QRect(barwidth
-                                           * (part->min_global_step - startStep),
-                                           0,
-                                           barwidth,
-                                           barheight),
-                                     options);
+            GnomeDrawer * drawer = getGnomeDrawer(part->gnome);
+            drawer->drawGnomeGL(QRect(barwidth
+                                      * (part->min_global_step - startStep),
+                                      0,
+                                      barwidth,
+                                      barheight),
+                                options);
             continue;
         }
     }
-
+    frameStats.add(FrameStats::FS_TRAVERSAL, walk.nsecsElapsed());
+    frameStats.count(FrameStats::FS_PARTITIONS, partitions);
 }
 
 // If there are few enough objects, use Qt
@@ -424,14 +486,18 @@ void ClusterVis::paintEvents(QPainter * painter)
     stepwidth = blockwidth;
 
     // In case there's no hover-gnome this gets used
-    Gnome * leftmost = NULL;
-    Gnome * nextgnome = NULL;
+    GnomeDrawer * leftmost = NULL;
+    GnomeDrawer * nextgnome = NULL;
 
     // Given for each gnome
     float drawSpan;
     float drawStart;
 
-    // Draw active partitions gnomes
+    // Draw active partitions gnomes. The gnomes draw their own events, so
+    // only the ones they drew are counted.
+    QElapsedTimer walk;
+    walk.start();
+    int partitions = 0, drawn = 0;
     for (int i = startPartition; i < trace->partitions->length(); ++i)
     {
         part = trace->partitions->at(i);
@@ -439,6 +505,7 @@ void ClusterVis::paintEvents(QPainter * painter)
             break;
         else if (part->max_global_step < bottomStep)
             continue;
+        partitions++;
         if (part->gnome) {
             // The y value here of 0 isn't general... we need another structure
             // to keep track of how much y is used when we're doing the gnome
@@ -456,26 +523,31 @@ void ClusterVis::paintEvents(QPainter * painter)
                                     blockwidth * (drawSpan),
                                     part->events->size() / 1.0
                                     / trace->num_entities * effectiveHeight);
-            part->gnome->drawGnomeQt(painter, gnomeRect, options, blockwidth);
-            drawnGnomes[part->gnome] = gnomeRect;
+            GnomeDrawer * drawer = getGnomeDrawer(part->gnome);
+            drawer->drawGnomeQt(painter, gnomeRect, options, blockwidth);
+            drawn += drawer->drawnEventCount();
+            drawnGnomes[drawer] = gnomeRect;
             if (!leftmost)
-                leftmost = part->gnome;
+                leftmost = drawer;
             else if (!nextgnome)
-                nextgnome = part->gnome;
+                nextgnome = drawer;
             continue;
         }
 
     }
+    frameStats.add(FrameStats::FS_TRAVERSAL, walk.nsecsElapsed());
+    frameStats.count(FrameStats::FS_PARTITIONS, partitions);
+    frameStats.count(FrameStats::FS_EVENTS_DRAWN, drawn);
 
-    if (!treevis->getGnome())
+    if (!treevis->getGnomeDrawer())
     {
         QRect left = drawnGnomes[leftmost];
         float left_steps = (std::min(rect().width(), left.x() + left.width())
                             - std::max(0, left.x())) / 1.0 / blockwidth;
         if (left_steps < 2)
-            treevis->setGnome(nextgnome);
+            treevis->setGnomeDrawer(nextgnome);
         else
-            treevis->setGnome(leftmost);
+            treevis->setGnomeDrawer(leftmost);
     }
 
 }
@@ -483,9 +555,9 @@ void ClusterVis::paintEvents(QPainter * painter)
 // When the neighborhood slider changes, this is called
 void ClusterVis::changeNeighborRadius(int neighbors)
 {
-    if (treevis->getGnome())
+    if (treevis->getGnomeDrawer())
     {
-        treevis->getGnome()->setNeighbors(neighbors);
+        treevis->getGnomeDrawer()->getGnome()->setNeighbors(neighbors);
         emit(neighborChange(neighbors));
         repaint();
     }
@@ -495,7 +567,7 @@ void ClusterVis::changeNeighborRadius(int neighbors)
 void ClusterVis::selectEvent(Event * event, bool aggregate, bool overdraw)
 {
     if (selected_gnome)
-        selected_gnome->clearSelectedPartitionCluster();
+        getGnomeDrawer(selected_gnome)->clearSelectedPartitionCluster();
     TimelineVis::selectEvent(event, aggregate, overdraw);
 
 }
@@ -29,6 +29,7 @@
 
 class ClusterTreeVis;
 class PartitionCluster;
+class GnomeDrawer;
 
 class ClusterVis : public TimelineVis
 {
@@ -36,7 +37,7 @@ class ClusterVis : public TimelineVis
 public:
     ClusterVis(ClusterTreeVis * ctv, QWidget* parent = 0,
                VisOptions *_options = new VisOptions());
-    ~ClusterVis() {}
+    ~ClusterVis();
     void setTrace(Trace * t);
 
     void mouseMoveEvent(QMouseEvent * event);
@@ -58,12 +59,16 @@ protected:
     void drawNativeGL();
     void paintEvents(QPainter *painter);
     void prepaint();
+    bool viewRange(ViewRange * range);
     void mouseDoubleClickEvent(QMouseEvent * event);
+    GnomeDrawer * getGnomeDrawer(Gnome * gnome);
+    void clearGnomeDrawers();
 
-    QMap<Gnome *, QRect> drawnGnomes;
+    QMap<Gnome *, GnomeDrawer *> gnomeDrawers;
+    QMap<GnomeDrawer *, QRect> drawnGnomes;
     PartitionCluster * selected;
     ClusterTreeVis * treevis;
-    Gnome * hover_gnome;
+    GnomeDrawer * hover_gnome;
 
 };
 
@@ -78,7 +78,7 @@ void CollectiveEvent::initialize_strides(QList<CommEvent *> * stride_events,
 void CollectiveEvent::initialize_basic_strides(QSet<CollectiveRecord *> *collectives)
 {
     collectives->insert(collective);
-    stride = 0;
+    stride_info->stride = 0;
 }
 
 void CollectiveEvent::update_basic_strides()
@@ -87,7 +87,8 @@ void CollectiveEvent::update_basic_strides()
     CommEvent * entity_next = comm_next;
 
     // while we have receives
-    while (entity_next && entity_next->stride < 0)
+    while (entity_next && entity_next->partition == partition
+           && entity_next->stride_info->stride < 0)
     {
         entity_next = entity_next->comm_next;
     }
@@ -101,8 +102,8 @@ void CollectiveEvent::update_basic_strides()
              = collective->events->begin();
              ev != collective->events->end(); ++ev)
         {
-            entity_next->stride_parents->insert(*ev);
-            (*ev)->stride_children->insert(entity_next);
+            entity_next->stride_info->stride_parents.insert(*ev);
+            (*ev)->stride_info->stride_children.insert(entity_next);
         }
     }
 }
@@ -145,8 +146,8 @@ void CollectiveEvent::set_stride_relationships()
              = collective->events->begin();
              ev != collective->events->end(); ++ev)
         {
-            entity_next->stride_parents->insert(*ev);
-            (*ev)->stride_children->insert(entity_next);
+            entity_next->stride_info->stride_parents.insert(*ev);
+            (*ev)->stride_info->stride_children.insert(entity_next);
         }
     }
 }
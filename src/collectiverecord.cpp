@@ -25,7 +25,6 @@
 #include "collectiverecord.h"
 #include "commevent.h"
 #include "collectiveevent.h"
-#include "viswidget.h"
 
 CollectiveRecord::CollectiveRecord(unsigned long long _matching,
                                    unsigned int _root,
@@ -48,12 +47,6 @@ CommEvent * CollectiveRecord::getDesignee()
     return events->first();
 }
 
-
-void CollectiveRecord::draw(QPainter * painter, CommDrawInterface *vis)
-{
-    vis->drawCollective(painter, this);
-}
-
 // Return stride set to this collective. Will return zero if cannot set.
 int CollectiveRecord::set_basic_strides()
 {
@@ -61,13 +54,14 @@ int CollectiveRecord::set_basic_strides()
     for (QList<CollectiveEvent *>::Iterator evt = events->begin();
          evt != events->end(); ++evt)
     {
-        for (QSet<CommEvent *>::Iterator parent = (*evt)->stride_parents->begin();
-             parent != (*evt)->stride_parents->end(); ++parent)
+        QSet<CommEvent *> * stride_parents = &((*evt)->stride_info->stride_parents);
+        for (QSet<CommEvent *>::Iterator parent = stride_parents->begin();
+             parent != stride_parents->end(); ++parent)
         {
-            if (!((*parent)->stride)) // Equals zero meaning its unset
+            if (!((*parent)->stride_info->stride)) // Equals zero meaning its unset
                 return 0;
-            else if ((*parent)->stride > max_stride)
-                max_stride = (*parent)->stride;
+            else if ((*parent)->stride_info->stride > max_stride)
+                max_stride = (*parent)->stride_info->stride;
         }
     }
 
@@ -75,7 +69,7 @@ int CollectiveRecord::set_basic_strides()
     for (QList<CollectiveEvent *>::Iterator evt = events->begin();
          evt != events->end(); ++evt)
     {
-        (*evt)->stride = max_stride;
+        (*evt)->stride_info->stride = max_stride;
     }
     return max_stride;
 }
@@ -46,7 +46,7 @@ public:
     QList<CollectiveEvent *> * events;
 
     CommEvent * getDesignee();
-    void draw(QPainter * painter, CommDrawInterface * vis);
+    bool isMessage() { return false; }
 
     int set_basic_strides();
 };
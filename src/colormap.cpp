@@ -24,6 +24,13 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "colormap.h"
 #include <iostream>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+int ColorMap::next_serial = 0;
 
 // Initial color/value pair in constructor
 ColorMap::ColorMap(QColor color, float value, bool _categorical)
@@ -31,9 +38,12 @@ ColorMap::ColorMap(QColor color, float value, bool _categorical)
       maxValue(1),
       maxClamp(1),
       categorical(_categorical),
-      colors(new QVector<ColorValue *>())
+      colors(new QVector<ColorValue *>()),
+      table(QVector<QRgb>()),
+      serial(++next_serial)
 {
     colors->push_back(new ColorValue(color, value));
+    buildTable();
 }
 
 ColorMap::~ColorMap()
@@ -59,6 +69,8 @@ ColorMap::ColorMap(const ColorMap & copy)
     {
         colors->push_back(new ColorValue((*itr)->color, (*itr)->value));
     }
+    table = copy.table;
+    serial = copy.serial;
 }
 
 void ColorMap::setRange(double low, double high)
@@ -66,11 +78,13 @@ void ColorMap::setRange(double low, double high)
     minValue = low;
     maxValue = high;
     maxClamp = high;
+    serial = ++next_serial;
 }
 
 void ColorMap::setClamp(double clamp)
 {
     maxClamp = clamp;
+    serial = ++next_serial;
 }
 
 void ColorMap::addColor(QColor color, float stop)
@@ -90,6 +104,8 @@ void ColorMap::addColor(QColor color, float stop)
     if (!added) {
         colors->push_back(new ColorValue(color, stop));
     }
+    buildTable();
+    serial = ++next_serial;
 }
 
 QColor ColorMap::color(double value, double opacity)
@@ -98,12 +114,95 @@ QColor ColorMap::color(double value, double opacity)
     if (categorical)
         return categorical_color(value);
 
-    // Find the colors at either end of the given value and blend them them
+    // Below the range (or an empty range) is off the table
+    double norm_value = (value - minValue) / (maxClamp - minValue);
+    if (!(norm_value >= 0))
+        return interpolate(norm_value, opacity);
+
+    QRgb rgb = table.at(tableIndex(norm_value));
+    return QColor(qRed(rgb), qGreen(rgb), qBlue(rgb), opacity*255);
+}
+
+// Table positions of n values, clamped to [0, last]. SSE2 does two values
+// per instruction with no branches. Its max gives 0 for NaN, as the scalar
+// comparisons do.
+static void tableIndices(const double * values, int n, double low,
+                         double scale, double last, int * indices)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128d vlow = _mm_set1_pd(low);
+    const __m128d vscale = _mm_set1_pd(scale);
+    const __m128d vhalf = _mm_set1_pd(0.5);
+    const __m128d vzero = _mm_setzero_pd();
+    const __m128d vlast = _mm_set1_pd(last);
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d position = _mm_sub_pd(_mm_loadu_pd(values + i), vlow);
+        position = _mm_add_pd(_mm_mul_pd(position, vscale), vhalf);
+        position = _mm_min_pd(_mm_max_pd(position, vzero), vlast);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(indices + i),
+                         _mm_cvttpd_epi32(position));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        double position = (values[i] - low) * scale + 0.5;
+        position = position > 0 ? position : 0;
+        position = position < last ? position : last;
+        indices[i] = static_cast<int>(position);
+    }
+}
+
+// Values are done in blocks: clamped table indices without branches, then
+// a gather from the table. Values below the range and NaNs, which land on
+// index 0, are replaced in a separate pass.
+void ColorMap::color(const double * values, int count, QRgb * results)
+{
+    if (categorical)
+    {
+        for (int i = 0; i < count; i++)
+            results[i] = categorical_color(values[i]).rgba();
+        return;
+    }
+
+    const int block_size = 256;
+    int indices[block_size];
+    double scale = (table_size - 1) / (maxClamp - minValue);
+    const double last = table_size - 1.0;
+    const QRgb * entries = table.constData();
+    for (int first = 0; first < count; first += block_size)
+    {
+        int n = std::min(block_size, count - first);
+        const double * block = values + first;
+        QRgb * block_results = results + first;
+
+        tableIndices(block, n, minValue, scale, last, indices);
+        for (int i = 0; i < n; i++)
+            block_results[i] = entries[indices[i]];
+
+        for (int i = 0; i < n; i++)
+        {
+            double norm_value = (block[i] - minValue) / (maxClamp - minValue);
+            if (!(norm_value >= 0))
+                block_results[i] = interpolate(norm_value, 1.0).rgba();
+        }
+    }
+}
+
+int ColorMap::tableIndex(double norm_value) const
+{
+    return static_cast<int>(std::min(norm_value * (table_size - 1) + 0.5,
+                                     table_size - 1.0));
+}
+
+// Find the colors at either end of the normalized value and blend them
+QColor ColorMap::interpolate(double norm_value, double opacity)
+{
     ColorValue base1 = ColorValue(QColor(0,0,0,opacity*255), 0);
     ColorValue base2 = ColorValue(QColor(0,0,0,opacity*255), 1);
     ColorValue* low = &base1;
     ColorValue* high = &base2;
-    double norm_value = (value - minValue) / (maxClamp - minValue);
     for (QVector<ColorValue* >::Iterator itr = colors->begin();
          itr != colors->end(); itr++)
     {
@@ -119,13 +218,28 @@ QColor ColorMap::color(double value, double opacity)
                   opacity*255);
 }
 
+void ColorMap::buildTable()
+{
+    if (categorical)
+    {
+        table.resize(colors->size());
+        for (int i = 0; i < colors->size(); i++)
+            table[i] = colors->at(i)->color.rgba();
+        return;
+    }
+
+    table.resize(table_size);
+    for (int i = 0; i < table_size; i++)
+        table[i] = interpolate(i / double(table_size - 1), 1.0).rgba();
+}
+
 // In categorical, we only take the minValue into account and the number of
 // input colors. This is somewhat magical and should probably be turned into
 // something that is more elegant and makes sense.
 QColor ColorMap::categorical_color(double value)
 {
-    int cat_value = int(value - minValue) % colors->size();
-    return colors->at(cat_value)->color;
+    int cat_value = int(value - minValue) % table.size();
+    return QColor::fromRgba(table.at(cat_value));
 }
 
 // Weighted average of two color values based on where norm falls
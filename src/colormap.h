@@ -36,11 +36,18 @@ public:
     ColorMap(const ColorMap& copy);
     void addColor(QColor color, float stop);
     QColor color(double value, double opacity = 1.0);
+
+    // Opaque colors of count values, the same as color() gives
+    void color(const double * values, int count, QRgb * results);
     void setRange(double low, double high);
     void setClamp(double clamp);
     double getMax() { return maxValue; }
     bool isCategorical() { return categorical; }
 
+    // Changes whenever the colors a value gets may change, so anything
+    // drawn with the map can tell it is stale. Copies share the serial.
+    int getSerial() const { return serial; }
+
 private:
     class ColorValue {
     public:
@@ -56,6 +63,9 @@ private:
     QColor average(ColorValue * low, ColorValue * high,
                    double norm, double opacity = 1.0);
     QColor categorical_color(double value);
+    QColor interpolate(double norm_value, double opacity);
+    void buildTable();
+    int tableIndex(double norm_value) const;
 
     // metric value range
     double minValue;
@@ -66,6 +76,15 @@ private:
 
     bool categorical;
     QVector<ColorValue *> * colors;
+
+    // Continuous maps are sampled over the normalized range [0, 1], so
+    // changing the range or clamp does not need a new table. Categorical
+    // maps keep their colors in order.
+    QVector<QRgb> table;
+    static const int table_size = 1024;
+
+    int serial;
+    static int next_serial;
 };
 
 #endif // COLORMAP_H
@@ -25,15 +25,14 @@
 #ifndef COMMBUNDLE_H
 #define COMMBUNDLE_H
 
-class QPainter;
 class CommEvent;
-class CommDrawInterface;
 
+// A message or a collective record. The views tell them apart to draw them.
 class CommBundle
 {
 public:
     virtual CommEvent * getDesignee()=0; // Event responsible
-    virtual void draw(QPainter * painter, CommDrawInterface * vis)=0;
+    virtual bool isMessage()=0; // else a CollectiveRecord
 };
 
 #endif // COMMBUNDLE_H
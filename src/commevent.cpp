@@ -44,27 +44,14 @@ CommEvent::CommEvent(unsigned long long _enter, unsigned long long _exit,
       extent_end(_exit),
       atomic(-1),
       matching(-1),
-      last_stride(NULL),
-      next_stride(NULL),
-      last_recvs(NULL),
-      last_step(-1),
-      stride_parents(new QSet<CommEvent *>()),
-      stride_children(new QSet<CommEvent *>()),
-      stride(-1),
+      stride_info(NULL),
       step(-1),
-      phase(_phase),
-      gvid("")
+      phase(_phase)
 {
 }
 
 CommEvent::~CommEvent()
 {
-    if (last_recvs)
-        delete last_recvs;
-    if (stride_children)
-        delete stride_children;
-    if (stride_parents)
-        delete stride_parents;
 }
 
 
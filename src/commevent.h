@@ -26,6 +26,7 @@
 #define COMMEVENT_H
 
 #include "event.h"
+#include "strideinfo.h"
 #include <QString>
 #include <QList>
 #include <QSet>
@@ -57,24 +58,27 @@ public:
     // recv. Otherwise, we just go by time
     static bool eventStrideLessThan(const CommEvent * evt1, const CommEvent * evt2)
     {
-        if (evt1->last_stride->stride == evt2->last_stride->stride)
+        StrideInfo * info1 = evt1->stride_info;
+        StrideInfo * info2 = evt2->stride_info;
+        StrideInfo * last1 = info1->last_stride->stride_info;
+        StrideInfo * last2 = info2->last_stride->stride_info;
+        if (last1->stride == last2->stride)
         {
             // This should only happen on receives, but just in case
-            if (evt1->last_stride->next_stride && evt2->last_stride->next_stride)
+            if (last1->next_stride && last2->next_stride)
             {
-                if (evt1->last_stride->next_stride->entity == evt2->last_stride->next_stride->entity)
+                if (last1->next_stride->entity == last2->next_stride->entity)
                 {
                     // Happens in the case where entity X and entity Y send to entity Z
                     // and both of those Z entries send back to entity X and entity Y
                     // recv X and recv Y have the same number and were sent by
                     // the same entity and have the same stride.
-                    if (evt1->stride == evt2->stride)
+                    if (info1->stride == info2->stride)
                     {
                         // Need to go back to the senders to figure it out
-                        if (evt1->last_stride->next_stride
-                            && evt2->last_stride->next_stride)
-                            return eventStrideLessThan(evt1->last_stride->next_stride,
-                                                       evt2->last_stride->next_stride);
+                        if (last1->next_stride && last2->next_stride)
+                            return eventStrideLessThan(last1->next_stride,
+                                                       last2->next_stride);
 
 
                         if (evt1->isReceive() && !evt2->isReceive())
@@ -87,23 +91,22 @@ public:
                     }
                     else
                     {
-                        return evt1->stride < evt2->stride;
+                        return info1->stride < info2->stride;
                     }
                 }
                 else
                 {
-                    return evt1->last_stride->next_stride->entity < evt2->last_stride->next_stride->entity;
+                    return last1->next_stride->entity < last2->next_stride->entity;
                 }
             }
             else
             {
-                if (evt1->stride == evt2->stride)
+                if (info1->stride == info2->stride)
                 {
                     // Need to go back to the senders to figure it out
-                    if (evt1->last_stride->next_stride
-                        && evt2->last_stride->next_stride)
-                        return eventStrideLessThan(evt1->last_stride->next_stride,
-                                                   evt2->last_stride->next_stride);
+                    if (last1->next_stride && last2->next_stride)
+                        return eventStrideLessThan(last1->next_stride,
+                                                   last2->next_stride);
 
                     if (evt1->isReceive() && !evt2->isReceive())
                         return evt2;
@@ -115,21 +118,23 @@ public:
                 }
                 else
                 {
-                    return evt1->stride < evt2->stride;
+                    return info1->stride < info2->stride;
                 }
             }
         }
 
-        return evt1->last_stride->stride < evt2->last_stride->stride;
+        return last1->stride < last2->stride;
     }
 
     static bool eventStrideLessThanMPI(const CommEvent * evt1, const CommEvent * evt2)
     {
-        if (evt1->stride == evt2->stride)
+        StrideInfo * info1 = evt1->stride_info;
+        StrideInfo * info2 = evt2->stride_info;
+        if (info1->stride == info2->stride)
         {
-            if (evt1->next_stride && evt2->next_stride)
+            if (info1->next_stride && info2->next_stride)
             {
-                return evt1->next_stride->entity < evt2->next_stride->entity;
+                return info1->next_stride->entity < info2->next_stride->entity;
             }
             else
             {
@@ -141,7 +146,7 @@ public:
                     return evt1->enter < evt2->enter;
             }
         }
-        return evt1->stride < evt2->stride;
+        return info1->stride < info2->stride;
     }
 
     bool hasMetric(QString name);
@@ -202,20 +207,11 @@ public:
     int atomic;
     long matching;
 
-    // Used in stepping procedure
-    CommEvent * last_stride;
-    CommEvent * next_stride;
-    QList<CommEvent *> * last_recvs;
-    int last_step;
-    QSet<CommEvent *> * stride_parents;
-    QSet<CommEvent *> * stride_children;
-    int stride;
+    // Used in stepping procedure, only set while the owning partition
+    // is being stepped (see Partition::initializeStrideInfo)
+    StrideInfo * stride_info;
 
     int step;
     int phase;
-
-    // For graph drawing
-    QString gvid;
-
 };
 #endif // COMMEVENT_H
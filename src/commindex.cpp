@@ -0,0 +1,137 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "commindex.h"
+#include <algorithm>
+
+#include "trace.h"
+#include "rpartition.h"
+#include "p2pevent.h"
+#include "message.h"
+#include "collectiverecord.h"
+#include "collectiveevent.h"
+
+CommIndex::CommIndex()
+    : bundles(QVector<CommBundle *>()),
+      last_steps(QVector<int>()),
+      offsets(QVector<int>()),
+      max_span(0)
+{
+}
+
+// Messages are taken from their sender only so each is listed once. The
+// bundles are bucketed by first step with a counting sort.
+void CommIndex::build(Trace * trace)
+{
+    QVector<CommBundle *> unsorted;
+    QVector<int> firsts, lasts;
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part)
+    {
+        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                if (!(*evt)->isP2P())
+                    continue;
+                QVector<Message *> * messages
+                        = static_cast<P2PEvent *>(*evt)->getMessages();
+                for (QVector<Message *>::Iterator msg = messages->begin();
+                     msg != messages->end(); ++msg)
+                {
+                    if ((*msg)->sender != *evt || !(*msg)->receiver)
+                        continue;
+                    unsorted.append(*msg);
+                    firsts.append(std::min((*msg)->sender->step,
+                                           (*msg)->receiver->step));
+                    lasts.append(std::max((*msg)->sender->step,
+                                          (*msg)->receiver->step));
+                }
+            }
+        }
+    }
+
+    for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+         = trace->collectives->begin();
+         cr != trace->collectives->end(); ++cr)
+    {
+        if (!cr.value()->events || cr.value()->events->isEmpty())
+            continue;
+        int first = cr.value()->events->first()->step;
+        int last = first;
+        for (QList<CollectiveEvent *>::Iterator evt = cr.value()->events->begin();
+             evt != cr.value()->events->end(); ++evt)
+        {
+            first = std::min(first, (*evt)->step);
+            last = std::max(last, (*evt)->step);
+        }
+        unsorted.append(cr.value());
+        firsts.append(first);
+        lasts.append(last);
+    }
+
+    max_span = 0;
+    int steps = std::max(trace->global_max_step + 1, 1);
+    offsets = QVector<int>(steps + 1, 0);
+    for (int i = 0; i < unsorted.size(); i++)
+    {
+        firsts[i] = qBound(0, firsts[i], steps - 1);
+        max_span = std::max(max_span, lasts[i] - firsts[i]);
+        offsets[firsts[i] + 1]++;
+    }
+    for (int s = 0; s < steps; s++)
+        offsets[s + 1] += offsets[s];
+
+    bundles = QVector<CommBundle *>(unsorted.size(), NULL);
+    last_steps = QVector<int>(unsorted.size(), 0);
+    QVector<int> next = offsets;
+    for (int i = 0; i < unsorted.size(); i++)
+    {
+        int slot = next[firsts[i]]++;
+        bundles[slot] = unsorted.at(i);
+        last_steps[slot] = lasts.at(i);
+    }
+}
+
+void CommIndex::find(int start, int stop, QVector<CommBundle *> * results) const
+{
+    int steps = offsets.size() - 1;
+    if (steps <= 0 || stop < start || stop < 0)
+        return;
+
+    int begin = offsets.at(qBound(0, start - max_span, steps));
+    int end = offsets.at(qBound(0, stop + 1, steps));
+    for (int i = begin; i < end; i++)
+        if (last_steps.at(i) >= start)
+            results->append(bundles.at(i));
+}
+
+long long CommIndex::memoryBytes() const
+{
+    return sizeof(CommIndex) + bundles.capacity() * sizeof(CommBundle *)
+           + (last_steps.capacity() + offsets.capacity()) * sizeof(int);
+}
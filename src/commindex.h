@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef COMMINDEX_H
+#define COMMINDEX_H
+
+#include <QVector>
+
+class Trace;
+class CommBundle;
+
+// Every message and collective record of a trace once, ordered by the first
+// step of the events it joins. A view asks for the ones touching its step
+// range instead of gathering them from each event it draws, which would
+// reach a message from both ends and need a set to draw it only once.
+class CommIndex
+{
+public:
+    CommIndex();
+
+    void build(Trace * trace);
+
+    // Appends the bundles with a step range overlapping [start, stop]
+    void find(int start, int stop, QVector<CommBundle *> * results) const;
+    int size() const { return bundles.size(); }
+    long long memoryBytes() const;
+
+private:
+    void add(CommBundle * bundle, int first, int last);
+
+    QVector<CommBundle *> bundles; // by first step
+    QVector<int> last_steps; // per bundle
+    QVector<int> offsets; // offsets[s] = first bundle starting at s or later
+    int max_span; // largest last - first step of any bundle
+};
+
+#endif // COMMINDEX_H
@@ -27,6 +27,7 @@
 #include "metrics.h"
 #include "rpartition.h"
 #include <iostream>
+#include <algorithm>
 
 Event::Event(unsigned long long _enter, unsigned long long _exit,
              int _function, unsigned long _entity, unsigned long _pe)
@@ -91,23 +92,84 @@ bool Event::operator==(const Event &event)
 
 Event * Event::findChild(unsigned long long time)
 {
-    Event * result = NULL;
-    Event * child_match = NULL;
-    if (enter <= time && exit >= time)
+    if (enter > time || exit < time)
+        return NULL;
+
+    // Only the first callee still running at time can contain it
+    int index = firstCalleeEndingAfter(time);
+    if (index < callees->size())
+    {
+        Event * child_match = callees->at(index)->findChild(time);
+        if (child_match)
+            return child_match;
+    }
+    return this;
+}
+
+// Append this event and every descendant overlapping [start, stop]
+void Event::findOverlapping(unsigned long long start, unsigned long long stop,
+                            QVector<Event *> * results)
+{
+    if (enter > stop || exit < start)
+        return;
+
+    results->append(this);
+    for (int i = firstCalleeEndingAfter(start); i < callees->size(); i++)
+    {
+        Event * child = callees->at(i);
+        if (child->enter > stop)
+            break;
+        child->findOverlapping(start, stop, results);
+    }
+}
+
+// Index of the first callee that has not exited before time, or the
+// number of callees if they have all finished
+int Event::firstCalleeEndingAfter(unsigned long long time)
+{
+    int low = 0, high = callees->size();
+    while (low < high)
     {
-        result = this;
-        for (QVector<Event *>::Iterator child = callees->begin();
-             child != callees->end(); ++child)
+        int mid = (low + high) / 2;
+        if (callees->at(mid)->exit < time)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Coalescing can append a caller after its siblings, so make sure the
+// whole subtree is in enter order before we search it
+void Event::sortCallees()
+{
+    for (int i = 1; i < callees->size(); i++)
+    {
+        if (callees->at(i)->enter < callees->at(i - 1)->enter)
         {
-            child_match = (*child)->findChild(time);
-            if (child_match)
-            {
-                result = child_match;
-                break;
-            }
+            qStableSort(callees->begin(), callees->end(), eventEnterLessThan);
+            break;
         }
     }
-    return result;
+
+    for (QVector<Event *>::Iterator child = callees->begin();
+         child != callees->end(); ++child)
+    {
+        (*child)->sortCallees();
+    }
+}
+
+// Latest exit in this subtree, normally our own unless the trace was
+// cut off while children were still open
+unsigned long long Event::subtreeEnd()
+{
+    unsigned long long end = exit;
+    for (QVector<Event *>::Iterator child = callees->begin();
+         child != callees->end(); ++child)
+    {
+        end = std::max(end, (*child)->subtreeEnd());
+    }
+    return end;
 }
 
 unsigned long long Event::getVisibleEnd(unsigned long long start)
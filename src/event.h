@@ -31,8 +31,6 @@
 #include <otf2/otf2.h>
 
 class Function;
-class QPainter;
-class CommDrawInterface;
 class Metrics;
 
 class Event
@@ -52,15 +50,24 @@ public:
     {
         return evt1->entity < evt2->entity;
     }
+    static bool eventEnterLessThan(const Event * evt1, const Event * evt2)
+    {
+        return evt1->enter < evt2->enter;
+    }
 
+    // Callees are in enter order and do not overlap, so lookups
+    // within a call tree are binary searches over them
     Event * findChild(unsigned long long time);
+    void findOverlapping(unsigned long long start, unsigned long long stop,
+                         QVector<Event *> * results);
+    int firstCalleeEndingAfter(unsigned long long time);
+    void sortCallees();
+    unsigned long long subtreeEnd();
     unsigned long long getVisibleEnd(unsigned long long start);
     bool same_subtree(Event * other);
     Event * least_multiple_caller(QMap<Event *, int> * memo = NULL);
     Event * least_multiple_function_caller(QMap<int, Function *> * functions);
     virtual int comm_count(QMap<Event *, int> * memo = NULL);
-    virtual void track_delay(QPainter *painter, CommDrawInterface * vis)
-        { Q_UNUSED(painter); Q_UNUSED(vis); }
     virtual bool isCommEvent() { return false; }
     virtual bool isReceive() const { return false; }
     virtual bool isCollective() { return false; }
@@ -28,12 +28,11 @@
 #include "gnome.h"
 #include <QMap>
 #include <QSet>
-#include <QRect>
 
-class QPainter;
 class PartitionCluster;
 
-// Gnome with detector & special drawing functions for exchange patterns
+// Gnome with detector for exchange patterns. ExchangeGnomeDrawer has the
+// special drawing functions for them.
 class ExchangeGnome : public Gnome
 {
 public:
@@ -44,13 +43,11 @@ public:
     void preprocess();
 
 protected:
-    void drawGnomeQtClusterEnd(QPainter * painter, QRect clusterRect,
-                               PartitionCluster * pc,
-                               int barwidth, int barheight, int blockwidth,
-                               int blockheight, int startStep);
     void generateTopEntities();
 
 private:
+    friend class ExchangeGnomeDrawer;
+
     // send-receive, sends-receives, sends-waitall
     enum ExchangeType { EXCH_SRSR, EXCH_SSRR, EXCH_SSWA, EXCH_UNKNOWN };
     ExchangeType type;
@@ -62,17 +59,6 @@ private:
     QSet<int> SRSRpatterns;
 
     int maxWAsize; // for drawing Waitall pies
-
-    void drawGnomeQtClusterSRSR(QPainter * painter, QRect startxy,
-                                PartitionCluster * pc, int barwidth,
-                                int barheight, int blockwidth, int blockheight,
-                                int startStep);
-    void drawGnomeQtClusterSSWA(QPainter * painter, QRect startxy,
-                                PartitionCluster * pc, int barwidth,
-                                int barheight, int blockwidth, int blockheight,
-                                int startStep);
-
-
 };
 
 #endif // EXCHANGEGNOME_H
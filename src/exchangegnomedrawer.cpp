@@ -0,0 +1,353 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "exchangegnomedrawer.h"
+#include <QPainter>
+#include <QRect>
+#include <cmath>
+#include "exchangegnome.h"
+#include "rpartition.h"
+#include "partitioncluster.h"
+#include "clusterevent.h"
+#include "colormap.h"
+
+ExchangeGnomeDrawer::ExchangeGnomeDrawer(ExchangeGnome * _exchange)
+    : GnomeDrawer(_exchange),
+      exchange(_exchange)
+{
+}
+
+// Probably need to do this for the isend -> waitall pattern...
+// Replace the receive line with a pie indicating the size of the waitall
+void ExchangeGnomeDrawer::drawGnomeQtClusterSSWA(QPainter * painter, QRect startxy,
+                                                 PartitionCluster * pc,
+                                                 int barwidth, int barheight,
+                                                 int blockwidth, int blockheight,
+                                                 int startStep)
+{
+    // For this we only need one row of events but we probably want to have
+    // some extra room for all of the messages that happen
+    bool drawMessages = true;
+    if (startxy.height() > 2 * clusterMaxHeight)
+    {
+        blockheight = 2*(clusterMaxHeight - 20);
+        barheight = blockheight; // - 3;
+    }
+    else
+    {
+        blockheight = startxy.height() / 2;
+        if (blockheight < 40)
+            drawMessages = false;
+        else
+            blockheight -= 20; // Room for message drawing
+        if (barheight > blockheight - 3)
+            barheight = blockheight;
+    }
+    int x, ys, yw, w, hs, hw, xa, wa, nsends, nwaits;
+    int base_y = startxy.y() + startxy.height() / 2 - blockheight / 2;
+    if (options->showAggregateSteps) {
+        startStep -= 1;
+    }
+    painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+    for (QList<ClusterEvent *>::Iterator evt = pc->events->begin();
+         evt != pc->events->end(); ++evt)
+    {
+        if (options->showAggregateSteps)
+            x = floor(((*evt)->step - startStep) * blockwidth) + 1
+                + startxy.x();
+        else
+            x = floor(((*evt)->step - startStep) / 2 * blockwidth) + 1
+                + startxy.x();
+        w = barwidth;
+        nsends = (*evt)->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_SEND);
+        nwaits = (*evt)->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_WAITALL);
+        int divisor = pc->members->size();
+        if (!options->showInactiveSteps)
+            divisor = nsends + nwaits;
+
+        hs = blockheight * nsends / 1.0 / divisor;
+        ys = base_y;
+        hw = blockheight * nwaits / 1.0 / divisor;
+        yw = base_y + blockheight - hw;
+
+        // Draw the event
+        if (nsends) {
+            QColor sendColor = options->colormap->color((*evt)->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                          ClusterEvent::CE_COMM_SEND,
+                                                                          ClusterEvent::CE_THRESH_BOTH)
+                                                        / nsends);
+            painter->fillRect(QRectF(x, ys, w, hs), QBrush(sendColor));
+        }
+         if (nwaits)
+         {
+            QColor waitColor = options->colormap->color((*evt)->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                          ClusterEvent::CE_COMM_WAITALL,
+                                                                          ClusterEvent::CE_THRESH_BOTH)
+                                                        / nwaits );
+            painter->fillRect(QRectF(x, yw, w, hw), QBrush(waitColor));
+         }
+
+        // Draw border but only if we're doing spacing, otherwise too messy
+        if (blockwidth != w) {
+            painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+            painter->drawRect(QRect(x, ys, w, blockheight));
+        }
+
+        // Draw the sends as normal, draw the waitalls as a partially filled
+        // pie and a number label
+        // Maybe we want to move the number label inside some day?
+        if (drawMessages) {
+            if (nsends)
+            {
+                painter->setPen(QPen(Qt::black, nsends * 2.0 / divisor,
+                                     Qt::SolidLine));
+                painter->drawLine(x + blockwidth / 2, ys, x + barwidth,
+                                  ys - 20);
+            }
+            if (nwaits)
+            {
+                float avg_recvs = (*evt)->waitallrecvs / 1.0 / nwaits;
+                int angle = 90 * 16 * avg_recvs  / exchange->maxWAsize;
+                int start = 180 * 16;
+                painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+                painter->setBrush(QBrush(Qt::black));
+                painter->drawPie(x + blockwidth - 16,
+                                 base_y + blockheight - 12,
+                                 25, 25, start, angle);
+                painter->drawText(x + blockwidth / 4 - 12,
+                                  base_y + blockheight + 15,
+                                  QString::number(avg_recvs, 'g', 2));
+                painter->setBrush(QBrush());
+                painter->drawPie(x + blockwidth - 16,
+                                 base_y + blockheight - 12,
+                                 25, 25, start, 90 * 16);
+                painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+            }
+        }
+
+        // Repeat for aggregate step which has no messages of course
+        if (options->showAggregateSteps) {
+            xa = floor(((*evt)->step - startStep - 1) * blockwidth) + 1
+                 + startxy.x();
+            wa = barwidth;
+
+            if (nsends)
+                painter->fillRect(QRectF(xa, ys, wa, hs),
+                              QBrush(options->colormap->color((*evt)->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                ClusterEvent::CE_COMM_SEND,
+                                                                                ClusterEvent::CE_THRESH_BOTH)
+                                                              / nsends)));
+
+            if (nwaits)
+                painter->fillRect(QRectF(xa, yw, wa, hw),
+                              QBrush(options->colormap->color((*evt)->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                ClusterEvent::CE_COMM_WAITALL,
+                                                                                ClusterEvent::CE_THRESH_BOTH)
+                                                              / nwaits)));
+
+            if (blockwidth != w)
+            {
+                painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+                painter->drawRect(QRect(xa, ys, wa, blockheight));
+            }
+        }
+
+
+    }
+}
+
+// For SRSR instead of doing a single combined box for each step, we divide in
+// half and draw each half as either the active or waiting entity. All active
+// entities are aggregated onto the active step in the drawing, regardless of
+// what they are doing. This is the most distoring because it is showing a
+// simplified diagram of what is not going on to give the general idea.
+void ExchangeGnomeDrawer::drawGnomeQtClusterSRSR(QPainter * painter, QRect startxy,
+                                                 PartitionCluster * pc,
+                                                 int barwidth, int barheight,
+                                                 int blockwidth, int blockheight,
+                                                 int startStep)
+{
+    // Unlike others, this doesn't need to leave room for outer messages
+    if (startxy.height() > 2 * clusterMaxHeight)
+    {
+        blockheight = clusterMaxHeight;
+        barheight = clusterMaxHeight - 3;
+    }
+    else
+    {
+        blockheight = startxy.height() / 2;
+        if (barheight > blockheight - 3)
+            barheight = blockheight;
+        else
+            barheight = blockheight - 3;
+    }
+
+
+    int base_y = startxy.y() + startxy.height() / 2 - blockheight;
+    int x, y, w, h, xa, wa, xr, yr;
+    xr = blockwidth;
+    int starti = startStep;
+    if (options->showAggregateSteps) {
+        startStep -= 1;
+        xr *= 2;
+    }
+    painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+    QList<DrawMessage *> msgs = QList<DrawMessage *>();
+    ClusterEvent * evt = pc->events->first();
+    int events_index = 0;
+
+    // Unlike our other drawing methods, we walk through based on steps and
+    // advance the ClusterEvent separately. This isn't particularly
+    // functionally different but puts the emphasis on the step over the event.
+    // At least that's what I assume I was thinking.
+    for (int i = starti; i < exchange->partition->max_global_step; i += 2)
+    {
+        if (options->showAggregateSteps)
+        {
+            x = floor((i - startStep) * blockwidth) + 1 + startxy.x();
+            xa = floor((i - startStep - 1) * blockwidth) + 1 + startxy.x();
+            wa = barwidth;
+        }
+        else
+            x = floor((i - startStep) / 2 * blockwidth) + 1 + startxy.x();
+        w = barwidth;
+        h = barheight;
+        y = base_y;
+
+        // Every other set is in the second lane
+        if (((i - startStep + 2) / 4) % 2)
+            y += blockheight;
+
+        // If we have an event at this space, otherwise draw a dummy
+        if (evt->step == i && evt->getCount())
+        {
+
+            // Draw the event
+            painter->fillRect(QRectF(x, y, w, h),
+                              QBrush(options->colormap->color(evt->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                             ClusterEvent::CE_COMM_ALL,
+                                                                             ClusterEvent::CE_THRESH_BOTH)
+                                                             / evt->getCount(ClusterEvent::CE_EVENT_COMM,
+                                                                             ClusterEvent::CE_COMM_ALL,
+                                                                             ClusterEvent::CE_THRESH_BOTH)
+                                                             )));
+
+            // Draw border but only if we're doing spacing, otherwise too messy
+            if (blockwidth != w)
+                painter->drawRect(QRectF(x,y,w,h));
+
+            // Draw the aggregate & border too if necessary
+            if (options->showAggregateSteps) {
+                painter->fillRect(QRectF(xa, y, wa, h),
+                                  QBrush(options->colormap->color(evt->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                 ClusterEvent::CE_COMM_ALL,
+                                                                                 ClusterEvent::CE_THRESH_BOTH)
+                                                                  / evt->getCount(ClusterEvent::CE_EVENT_AGG,
+                                                                                  ClusterEvent::CE_COMM_ALL,
+                                                                                  ClusterEvent::CE_THRESH_BOTH)
+                                                                       )));
+                if (blockwidth != w)
+                    painter->drawRect(QRectF(xa, y, wa, h));
+            }
+
+            // Save message info here to be drawn later. We get its weight as
+            // well as its start and end positions
+            if (evt->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_SEND) > 0)
+            {
+                if (y == base_y)
+                    yr = base_y + blockheight;
+                else
+                    yr = base_y;
+                msgs.append(new DrawMessage(QPoint(x + w/2, y + h/2),
+                                            QPoint(x + w/2 + xr, yr + h/2),
+                                            evt->getCount(ClusterEvent::CE_EVENT_COMM,
+                                                          ClusterEvent::CE_COMM_SEND)));
+            }
+            if (evt->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_RECV) > 0
+                    && !msgs.isEmpty())
+            {
+                DrawMessage * dm = msgs.last();
+                dm->nrecvs = evt->getCount(ClusterEvent::CE_EVENT_COMM,
+                                           ClusterEvent::CE_COMM_RECV);
+            }
+            events_index++;
+            if (events_index < pc->events->size())
+                evt = pc->events->at(events_index);
+        }
+        else // Nothing in the cluster here, draw a dummy
+        {
+            painter->setPen(QPen(Qt::black, 1.5, Qt::DashLine));
+            if (blockwidth != w)
+                painter->drawRect(QRectF(x,y,w,h));
+            else
+                painter->drawRect(QRectF(x+2,y+2,w-4,h-4));
+            if (options->showAggregateSteps)
+            {
+                if (blockwidth != w)
+                    painter->drawRect(QRectF(xa, y, wa, h));
+                else
+                    painter->drawRect(QRectF(xa+2, y+2, wa-4, h-4));
+            }
+            painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+        }
+    }
+
+    // Now draw the messages....
+    for (QList<DrawMessage *>::Iterator dm = msgs.begin();
+         dm != msgs.end(); ++dm)
+    {
+        painter->setPen(QPen(Qt::black,
+                             (*dm)->nsends * 2.0 / pc->members->size(),
+                             Qt::SolidLine));
+        painter->drawLine((*dm)->send, (*dm)->recv);
+    }
+
+    // Clean up the draw messages...
+    for (QList<DrawMessage *>::Iterator dm = msgs.begin();
+         dm != msgs.end(); ++dm)
+    {
+        delete *dm;
+    }
+}
+
+
+// Special drawing styles for exchange types
+// SSRR does not need a special drawing type
+void ExchangeGnomeDrawer::drawGnomeQtClusterEnd(QPainter * painter, QRect clusterRect,
+                                                PartitionCluster * pc,
+                                                int barwidth, int barheight,
+                                                int blockwidth, int blockheight,
+                                                int startStep)
+{
+    if (exchange->type == ExchangeGnome::EXCH_SRSR)
+        drawGnomeQtClusterSRSR(painter, clusterRect, pc, barwidth, barheight,
+                               blockwidth, blockheight, startStep);
+    else if (exchange->type == ExchangeGnome::EXCH_SSWA)
+        drawGnomeQtClusterSSWA(painter, clusterRect, pc, barwidth, barheight,
+                               blockwidth, blockheight, startStep);
+    else
+        GnomeDrawer::drawGnomeQtClusterEnd(painter, clusterRect, pc, barwidth,
+                                           barheight, blockwidth, blockheight,
+                                           startStep);
+}
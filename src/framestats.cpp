@@ -0,0 +1,199 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "framestats.h"
+#include <QDateTime>
+#include <QTextStream>
+
+FrameStats::Frame::Frame()
+    : number(0),
+      time(0),
+      nanos(0),
+      reused(false)
+{
+    for (int i = 0; i < FS_NUM_PHASES; i++)
+        phases[i] = 0;
+    for (int i = 0; i < FS_NUM_COUNTERS; i++)
+        counts[i] = 0;
+}
+
+FrameStats::Section::Section(FrameStats * _stats, Phase _phase)
+    : stats(_stats),
+      phase(_phase),
+      timer(QElapsedTimer())
+{
+    timer.start();
+}
+
+FrameStats::Section::~Section()
+{
+    stats->add(phase, timer.nsecsElapsed());
+}
+
+FrameStats::FrameStats(int _capacity)
+    : current(Frame()),
+      timer(QElapsedTimer()),
+      frames(QVector<Frame>(_capacity)),
+      capacity(_capacity),
+      next(0),
+      stored(0),
+      numbered(0)
+{
+}
+
+void FrameStats::begin()
+{
+    current = Frame();
+    current.number = numbered++;
+    current.time = QDateTime::currentMSecsSinceEpoch();
+    timer.start();
+}
+
+void FrameStats::end(bool reused)
+{
+    current.nanos = timer.nsecsElapsed();
+    current.reused = reused;
+    qint64 draw = current.nanos;
+    for (int i = 0; i < FS_NUM_PHASES; i++)
+    {
+        if (i != FS_DRAW)
+            draw -= current.phases[i];
+    }
+    current.phases[FS_DRAW] = qMax(draw, qint64(0));
+
+    frames[next] = current;
+    next = (next + 1) % capacity;
+    stored = qMin(stored + 1, capacity);
+}
+
+void FrameStats::clear()
+{
+    next = 0;
+    stored = 0;
+}
+
+const FrameStats::Frame &FrameStats::last() const
+{
+    return frames.at((next + capacity - 1) % capacity);
+}
+
+QVector<FrameStats::Frame> FrameStats::history() const
+{
+    QVector<Frame> oldest_first;
+    oldest_first.reserve(stored);
+    for (int i = 0; i < stored; i++)
+        oldest_first.append(frames.at((next + capacity - stored + i) % capacity));
+    return oldest_first;
+}
+
+long long FrameStats::memoryBytes() const
+{
+    return frames.capacity() * sizeof(Frame);
+}
+
+// Two lines for the overlay, about the last frame
+QString FrameStats::summary() const
+{
+    if (isEmpty())
+        return QString("No frames yet");
+
+    const Frame &frame = last();
+    QString times = QString::number(frame.nanos / 1e6, 'f', 1) + " ms";
+    if (frame.reused)
+        times += " (reused)";
+    times += ":";
+    for (int i = 0; i < FS_NUM_PHASES; i++)
+        times += " " + phaseName(static_cast<Phase>(i)) + " "
+                 + QString::number(frame.phases[i] / 1e6, 'f', 1);
+
+    QString counts;
+    for (int i = 0; i < FS_NUM_COUNTERS; i++)
+    {
+        if (i)
+            counts += ", ";
+        counts += counterName(static_cast<Counter>(i)).replace('_', ' ')
+                  + " " + QString::number(frame.counts[i]);
+    }
+    return times + "\n" + counts;
+}
+
+void FrameStats::writeCSVHeader(QTextStream &out)
+{
+    out << "view,frame,time_ms,total_ms";
+    for (int i = 0; i < FS_NUM_PHASES; i++)
+        out << "," << phaseName(static_cast<Phase>(i)) << "_ms";
+    for (int i = 0; i < FS_NUM_COUNTERS; i++)
+        out << "," << counterName(static_cast<Counter>(i));
+    out << ",reused\n";
+}
+
+void FrameStats::writeCSV(QTextStream &out, const QString &view) const
+{
+    QVector<Frame> oldest_first = history();
+    for (QVector<Frame>::Iterator frame = oldest_first.begin();
+         frame != oldest_first.end(); ++frame)
+    {
+        out << view << "," << frame->number << "," << frame->time << ","
+            << QString::number(frame->nanos / 1e6, 'f', 3);
+        for (int i = 0; i < FS_NUM_PHASES; i++)
+            out << "," << QString::number(frame->phases[i] / 1e6, 'f', 3);
+        for (int i = 0; i < FS_NUM_COUNTERS; i++)
+            out << "," << frame->counts[i];
+        out << "," << (frame->reused ? 1 : 0) << "\n";
+    }
+}
+
+QString FrameStats::phaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case FS_PREPAINT:
+        return "prepaint";
+    case FS_TRAVERSAL:
+        return "traversal";
+    case FS_DRAW:
+        return "draw";
+    case FS_MESSAGES:
+        return "messages";
+    default:
+        return "";
+    }
+}
+
+QString FrameStats::counterName(Counter counter)
+{
+    switch (counter)
+    {
+    case FS_PARTITIONS:
+        return "partitions";
+    case FS_EVENTS_VISITED:
+        return "events_visited";
+    case FS_EVENTS_DRAWN:
+        return "events_drawn";
+    case FS_MESSAGES_DRAWN:
+        return "messages_drawn";
+    default:
+        return "";
+    }
+}
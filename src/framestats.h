@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QString>
+
+class QTextStream;
+
+// Where the time of each paint of a view went and how much it walked and
+// drew, for the last few hundred paints. Views time their traversal with
+// Sections and count as they go; draw is whatever the paint spent outside
+// the other phases.
+class FrameStats
+{
+public:
+    FrameStats(int _capacity = 600);
+
+    enum Phase { FS_PREPAINT, FS_TRAVERSAL, FS_DRAW, FS_MESSAGES,
+                 FS_NUM_PHASES };
+    enum Counter { FS_PARTITIONS, FS_EVENTS_VISITED, FS_EVENTS_DRAWN,
+                   FS_MESSAGES_DRAWN, FS_NUM_COUNTERS };
+
+    class Frame {
+    public:
+        Frame();
+
+        int number;
+        qint64 time; // ms since the epoch when the paint started
+        qint64 nanos;
+        qint64 phases[FS_NUM_PHASES];
+        long long counts[FS_NUM_COUNTERS];
+        bool reused; // moved the last frame rather than painting
+    };
+
+    // Adds the time until it goes out of scope to a phase of the frame
+    class Section {
+    public:
+        Section(FrameStats * _stats, Phase _phase);
+        ~Section();
+
+    private:
+        FrameStats * stats;
+        Phase phase;
+        QElapsedTimer timer;
+    };
+
+    void begin();
+    void end(bool reused = false);
+    void add(Phase phase, qint64 nanos) { current.phases[phase] += nanos; }
+    void count(Counter counter, long long n = 1)
+        { current.counts[counter] += n; }
+
+    void clear();
+    bool isEmpty() const { return !stored; }
+    const Frame &last() const;
+    QVector<Frame> history() const; // oldest first
+    long long memoryBytes() const;
+
+    QString summary() const;
+    static void writeCSVHeader(QTextStream &out);
+    void writeCSV(QTextStream &out, const QString &view) const;
+
+    static QString phaseName(Phase phase);
+    static QString counterName(Counter counter);
+
+private:
+    Frame current;
+    QElapsedTimer timer;
+    QVector<Frame> frames; // ring buffer
+    int capacity;
+    int next;
+    int stored;
+    int numbered;
+};
+
+#endif // FRAMESTATS_H
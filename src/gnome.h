@@ -25,95 +25,90 @@
 #ifndef GNOME_H
 #define GNOME_H
 
-#include "commdrawinterface.h"
 #include "rpartition.h"
 #include "function.h"
-#include "visoptions.h"
 #include "partitioncluster.h"
 #include "clusterentity.h"
-#include <QPainter>
-#include <QRect>
+#include "singlelinkage.h"
+#include "clustermatrix.h"
+#include "clara.h"
+#include <cfloat>
+#include <climits>
 
 class Event;
-class QMouseEvent;
 class ClusterEntity;
 
-// Our unit of clustering and drawing. The idea is the inheritance hierarchy
-// will allow customization. However, this design with both a detector and
-// a drawing style needs to be factored in some other way. The design right
-// now is suspect.
-class Gnome : CommDrawInterface
+// Our unit of clustering. The idea is the inheritance hierarchy will allow
+// customization of both the detector and the clustering. Drawing a gnome is
+// done by a matching GnomeDrawer in the GUI so the clustering can run
+// without it.
+class Gnome
 {
 public:
     Gnome();
     ~Gnome();
 
-    enum ChangeType { CHANGE_CLUSTER, CHANGE_SELECTION, CHANGE_NONE };
-
     virtual bool detectGnome(Partition * part);
     virtual Gnome * create();
     void set_seed(unsigned long s) { seed = s; }
+    // Cluster with CLARA into up to max_k clusters, choosing the count
+    // automatically or always using max_k
+    void set_clusters(int max_k, bool choose)
+        { max_clusters = max_k; auto_clusters = choose; }
     virtual void preprocess();
     void setPartition(Partition * part) { partition = part; }
     void setFunctions(QMap<int, Function *> * _functions)
         { functions = _functions; }
-
-    // Tree GUI
-    virtual void drawQtTree(QPainter * painter, QRect extents);
     virtual void setNeighbors(int _neighbors);
-    void drawTopLabels(QPainter * painter, QRect extents);
-    virtual void handleTreeDoubleClick(QMouseEvent * event);
-
-    // Main GUI
-    virtual void drawGnomeQt(QPainter * painter, QRect extents,
-                             VisOptions * _options, int blockwidth);
-    virtual void drawGnomeGL(QRect extents, VisOptions * _options)
-        { Q_UNUSED(extents); options = _options; }
-    virtual ChangeType handleDoubleClick(QMouseEvent * event);
-    PartitionCluster * getSelectedPartitionCluster() { return selected_pc; }
-    void setSelected(bool selected) { is_selected = selected; }
-    void clearSelectedPartitionCluster() { selected_pc = NULL; }
-    bool handleHover(QMouseEvent * event);
-    void drawHover(QPainter * painter);
-
-    virtual void drawMessage(QPainter * painter, Message * message) { Q_UNUSED(painter); Q_UNUSED(message); }
-    virtual void drawCollective(QPainter * painter, CollectiveRecord * cr) { Q_UNUSED(painter); Q_UNUSED(cr); }
-    virtual void drawDelayTracking(QPainter * painter, CommEvent * c)
-        { Q_UNUSED(painter); Q_UNUSED(c); }
-
-    // For clusterings
-    struct entity_distance {
-        double operator()(ClusterEntity * cp1, ClusterEntity * cp2) const {
-            return cp1->calculateMetricDistance(*cp2);
-        }
-    };
-
-    struct entity_distance_np {
-        double operator()(const ClusterEntity& cp1,
-                          const ClusterEntity& cp2) const {
-            return cp1.calculateMetricDistance(cp2);
-        }
-    };
 
 protected:
+    friend class GnomeDrawer;
+    friend class MemoryCensus;
+
     Partition * partition;
     QMap<int, Function *> * functions;
-    VisOptions * options;
     unsigned long seed;
-    int mousex;
-    int mousey;
+    int max_clusters;
+    bool auto_clusters;
 
     QString metric;
-    class DistancePair {
+    bool top_by_centroid; // focus entities from centroid rather than max
+    // Distances for single linkage between entities of the partition, by
+    // the rows of its cluster matrix
+    class EntityDistance : public SingleLinkage::Distance {
+    public:
+        EntityDistance(const ClusterMatrix * _matrix)
+            : matrix(_matrix) {}
+        long long distance(int i, int j) const
+            { return toMetricDistance(matrix->distance(i, j)); }
+        void distances(int i, int first, int last, long long * results) const;
+
+        const ClusterMatrix * matrix;
+    };
+    // For CLARA, by the same rows
+    class RowDistance : public Clara::Distance {
     public:
-        DistancePair(long long _d, int _p1, int _p2)
-            : distance(_d), p1(_p1), p2(_p2) {}
-        bool operator<(const DistancePair &dp) const
-            { return distance < dp.distance; }
+        RowDistance(const ClusterMatrix * _matrix)
+            : matrix(_matrix) {}
+        double distance(int i, int j) const
+        {
+            double d = matrix->distance(i, j);
+            return d < 0 ? DBL_MAX : d;
+        }
+        void distances(int i, const int * others, int count,
+                       double * results) const;
 
-        long long distance;
-        int p1;
-        int p2;
+        const ClusterMatrix * matrix;
+    };
+    // and between the clusters found by CLARA
+    class ClusterDistance : public SingleLinkage::Distance {
+    public:
+        ClusterDistance(QVector<PartitionCluster *> * _clusters)
+            : clusters(_clusters) {}
+        long long distance(int i, int j) const
+            { return clusters->at(j)->distance(clusters->at(i)); }
+
+        QVector<PartitionCluster *> * clusters;
     };
     class CentroidDistance {
     public:
@@ -134,71 +129,25 @@ protected:
         int step;
     };
 
-    long long int calculateMetricDistance(int p1, int p2);
-    long long int calculateMetricDistance2(QList<CommEvent *> * list1,
-                                           QList<CommEvent *> * list2);
+    // Matrix distances are -1 where the rows share no steps
+    static long long int toMetricDistance(double distance)
+        { return distance < 0 ? LLONG_MAX : (long long int) distance; }
     void findMusters();
     void findClusters();
     void hierarchicalMusters();
+    PartitionCluster * buildHierarchy(const SingleLinkage& linkage,
+                                      const QVector<PartitionCluster *>& leaves);
     virtual void generateTopEntities(PartitionCluster * pc = NULL);
     void generateTopEntitiesWorker(int entity);
     int findCentroidEntity(PartitionCluster * pc);
     int findMaxMetricEntity(PartitionCluster * pc);
 
-
-    class DrawMessage {
-    public:
-        DrawMessage(QPoint _send, QPoint _recv, int _nsends)
-            : send(_send), recv(_recv), nsends(_nsends), nrecvs(0) { }
-
-        QPoint send;
-        QPoint recv;
-        int nsends;
-        int nrecvs;
-    };
-
     QMap<int, PartitionCluster * > * cluster_leaves;
     QMap<int, PartitionCluster * > * cluster_map;
     PartitionCluster * cluster_root;
     int max_metric_entity;
     QList<int> top_entities; // focus entities really
-    bool alternation; // cluster background
     int neighbors; // neighbor radius
-
-    QSet<Message *> saved_messages;
-    QMap<PartitionCluster *, QRect> drawnPCs;
-    QMap<PartitionCluster *, QRect> drawnNodes;
-    QMap<Event *, QRect> drawnEvents;
-    PartitionCluster * selected_pc;
-    bool is_selected;
-    Event * hover_event;
-    bool hover_aggregate;
-    int stepwidth;
-
-    void drawGnomeQtCluster(QPainter * painter, QRect extents, int blockwidth);
-    void drawGnomeQtTopEntities(QPainter * painter, QRect extents,
-                                 int blockwidth, int barwidth);
-    void drawGnomeQtClusterBranch(QPainter * painter, QRect current,
-                                  PartitionCluster * pc,
-                                  float blockheight, int blockwidth, int barheight,
-                                  int barwidth);
-    void drawGnomeQtClusterLeaf(QPainter * painter, QRect startxy,
-                                QList<CommEvent *> *elist,
-                                int blockwidth, int startStep);
-    void drawGnomeQtInterMessages(QPainter * painter, int blockwidth,
-                                  int startStep, int startx);
-    virtual void drawGnomeQtClusterEnd(QPainter * painter, QRect clusterRect,
-                                       PartitionCluster * pc,
-                                       int barwidth, int barheight,
-                                       int blockwidth, int blockheight,
-                                       int startStep); // blockheight not used
-    void drawTreeBranch(QPainter * painter, QRect current,
-                        PartitionCluster * pc,
-                        int branch_length, int labelwidth, float blockheight,
-                        int leafx);
-    int getTopHeight(QRect extents);
-
-    static const int clusterMaxHeight = 76;
 };
 
 #endif // GNOME_H
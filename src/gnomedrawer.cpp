@@ -0,0 +1,950 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "gnomedrawer.h"
+#include <QLocale>
+#include <QMouseEvent>
+#include <climits>
+#include <cmath>
+
+#include "gnome.h"
+#include "exchangegnome.h"
+#include "exchangegnomedrawer.h"
+#include "rpartition.h"
+#include "function.h"
+#include "p2pevent.h"
+#include "clusterevent.h"
+#include "message.h"
+#include "colormap.h"
+
+GnomeDrawer::GnomeDrawer(Gnome * _gnome)
+    : gnome(_gnome),
+      options(NULL),
+      mousex(-1),
+      mousey(-1),
+      alternation(true),
+      saved_messages(QSet<Message *>()),
+      drawnPCs(QMap<PartitionCluster *, QRect>()),
+      drawnNodes(QMap<PartitionCluster *, QRect>()),
+      drawnEvents(HitGrid()),
+      selected_pc(NULL),
+      is_selected(false),
+      hover_event(NULL),
+      hover_aggregate(false),
+      stepwidth(0)
+{
+}
+
+// Drawing style follows the type of gnome
+GnomeDrawer * GnomeDrawer::create(Gnome * gnome)
+{
+    ExchangeGnome * exchange = dynamic_cast<ExchangeGnome *>(gnome);
+    if (exchange)
+        return new ExchangeGnomeDrawer(exchange);
+    return new GnomeDrawer(gnome);
+}
+
+
+void GnomeDrawer::drawGnomeQt(QPainter * painter, QRect extents,
+                              VisOptions *_options, int blockwidth)
+{
+    options = _options;
+    if (options->metric != gnome->metric)
+    {
+        gnome->metric = options->metric;
+        gnome->preprocess();
+    }
+    saved_messages.clear();
+    drawnPCs.clear();
+    drawnNodes.clear();
+    drawnEvents.reset(extents);
+
+    drawGnomeQtCluster(painter, extents, blockwidth);
+}
+
+// The height allowed to the top entities (of the total Gnome drawing height).
+// This is not the y but the height.
+// This could be improved.
+int GnomeDrawer::getTopHeight(QRect extents)
+{
+    int topHeight = 0;
+    int fair_portion = gnome->top_entities.size() / 1.0
+                       / gnome->cluster_root->members->size() * extents.height();
+    int min_size = 12 * gnome->top_entities.size();
+
+    // If we don't have enough for 12 pixels each entity,
+    // go with the fair portion
+    if (min_size > extents.height())
+        topHeight = fair_portion;
+    else // but if we do, go with whatever is bigger
+        topHeight = std::max(fair_portion, min_size);
+
+    // Max cluster leftover tries the other way - seeing how much room we need
+    // for our clusters and then choosing the size based on them. Note however
+    // that this is not how the clusters will actually be allotted in terms of
+    // size (since they're shown relative to how many they contain), so
+    // this may not make sense. Perhaps we need a non-linear cluster scale.
+    int max_cluster_leftover = extents.height()
+                               - gnome->cluster_root->visible_clusters()
+                               * (2 * clusterMaxHeight);
+    if (topHeight < max_cluster_leftover)
+        topHeight = max_cluster_leftover;
+
+    return topHeight;
+}
+
+void GnomeDrawer::drawGnomeQtCluster(QPainter * painter,
+                                     QRect extents,
+                                     int blockwidth)
+{
+    alternation = true;
+
+
+    int topHeight = getTopHeight(extents);
+
+    int effectiveHeight = extents.height() - topHeight;
+    int effectiveWidth = extents.width();
+
+    int entitiespan = gnome->partition->events->size();
+    int stepSpan = gnome->partition->max_global_step - gnome->partition->min_global_step + 2;
+    int spacingMinimum = 12;
+
+
+    int entity_spacing = 0;
+    if (effectiveHeight / entitiespan > spacingMinimum)
+        entity_spacing = 3;
+
+    int step_spacing = 0;
+    if (effectiveWidth / stepSpan + 1 > spacingMinimum)
+        step_spacing = 3;
+
+
+    float blockheight = effectiveHeight / 1.0 / entitiespan;
+    if (blockheight >= 1.0)
+        blockheight = floor(blockheight);
+    int barheight = blockheight - entity_spacing;
+    int barwidth = blockwidth - step_spacing;
+    painter->setPen(QPen(QColor(0, 0, 0)));
+
+    // Draw the Focus entities
+    QRect top_extents = QRect(extents.x(), extents.y(),
+                              extents.width(), topHeight);
+    drawGnomeQtTopEntities(painter, top_extents, blockwidth, barwidth);
+
+    // Draw the clusters
+    QRect cluster_extents = QRect(extents.x(), extents.y() + topHeight,
+                                  extents.width(), effectiveHeight);
+    drawGnomeQtClusterBranch(painter, cluster_extents, gnome->cluster_root,
+                             blockheight, blockwidth, barheight, barwidth);
+
+    // Now that we have drawn all the events, we need to draw the leaf-cluster
+    // messages or the leaf-leaf messages which are saved in saved_messages.
+    drawGnomeQtInterMessages(painter, blockwidth,
+                             gnome->partition->min_global_step, extents.x());
+
+    drawHover(painter);
+
+}
+
+// Entity labels for the focus entities
+void GnomeDrawer::drawTopLabels(QPainter * painter, QRect extents)
+{
+    int topHeight = getTopHeight(extents);
+    int entitiespan = gnome->top_entities.size();
+
+    float blockheight = floor(topHeight / entitiespan);
+
+    QLocale systemlocale = QLocale::system();
+    QFontMetrics font_metrics = painter->fontMetrics();
+    QString testString = systemlocale.toString(gnome->top_entities.last());
+    int labelWidth = font_metrics.width(testString);
+    int labelHeight = font_metrics.height();
+
+    int x = extents.width() - labelWidth - 2;
+
+    painter->setPen(Qt::black);
+    painter->setFont(QFont("Helvetica", 10));
+    int total_labels = floor(topHeight / labelHeight);
+    int y;
+    int skip = 1;
+    if (total_labels < entitiespan && total_labels > 0)
+    {
+        skip = ceil(float(entitiespan) / total_labels);
+    }
+
+    if (total_labels > 0)
+    {
+        for (int i = 0; i < gnome->top_entities.size(); i+= skip)
+        {
+            y = floor(i * blockheight) + (blockheight + labelHeight) / 2 + 1;
+            if (y < topHeight)
+                painter->drawText(x, y, QString::number(gnome->top_entities[i]));
+        }
+    }
+}
+
+
+// Draw focus entities much like StepVis
+void GnomeDrawer::drawGnomeQtTopEntities(QPainter * painter, QRect extents,
+                                                  int blockwidth, int barwidth)
+{
+    int effectiveHeight = extents.height();
+
+    int entity_spacing = blockwidth - barwidth;
+    int step_spacing = entity_spacing;
+
+    float x, y, w, h, xa, wa;
+    float blockheight = floor(effectiveHeight / gnome->top_entities.size());
+    int startStep = gnome->partition->min_global_step;
+    if (options->showAggregateSteps)
+    {
+        startStep -= 1;
+    }
+    float barheight = blockheight - entity_spacing;
+    stepwidth = blockwidth;
+
+    QSet<Message *> drawMessages = QSet<Message *>();
+    painter->setPen(QPen(QColor(0, 0, 0)));
+    QMap<int, int> entityYs = QMap<int, int>();
+    float myopacity, opacity = 1.0;
+    if (is_selected && selected_pc)
+        opacity = 0.5;
+    for (int i = 0; i < gnome->top_entities.size(); ++i)
+    {
+        QList<CommEvent *> * event_list = gnome->partition->events->value(gnome->top_entities[i]);
+        bool selected = false;
+        if (is_selected && selected_pc
+            && selected_pc->members->contains(gnome->top_entities[i]))
+        {
+            selected = true;
+        }
+        y =  floor(extents.y() + i * blockheight) + 1;
+
+        entityYs[gnome->top_entities[i]] = y;
+        for (QList<CommEvent *>::Iterator evt = event_list->begin();
+             evt != event_list->end(); ++evt)
+        {
+            if (options->showAggregateSteps)
+                x = floor(((*evt)->step - startStep) * blockwidth) + 1
+                    + extents.x();
+            else
+                x = floor(((*evt)->step - startStep) / 2 * blockwidth) + 1
+                    + extents.x();
+            w = barwidth;
+            h = barheight;
+
+            myopacity = opacity;
+            if (selected)
+                myopacity = 1.0;
+            painter->fillRect(QRectF(x, y, w, h),
+                              QBrush(options->colormap->color((*evt)->getMetric(gnome->metric),
+                                                              myopacity)));
+
+            // Draw border but only if we're doing spacing, otherwise too messy
+            painter->setPen(QPen(QColor(0, 0, 0, myopacity * 255)));
+            if (step_spacing > 0 && entity_spacing > 0)
+            {
+                painter->drawRect(QRectF(x,y,w,h));
+            }
+
+            // Change to commBundle method
+            QVector<Message *> * msgs = (*evt)->getMessages();
+            if (msgs)
+                for (QVector<Message *>::Iterator msg = msgs->begin();
+                     msg != msgs->end(); ++msg)
+                {
+                    if (gnome->top_entities.contains((*msg)->sender->entity)
+                            && gnome->top_entities.contains((*msg)->receiver->entity))
+                    {
+                        drawMessages.insert((*msg));
+                    }
+                    else if (*evt == (*msg)->sender)
+                    {
+                        // send
+                        if ((*msg)->sender->entity > (*msg)->receiver->entity)
+                            painter->drawLine(x + w/2, y + h/2, x + w, y);
+                        else
+                            painter->drawLine(x + w/2, y + h/2, x + w, y + h);
+                    }
+                    else
+                    {
+                        // recv
+                        if ((*msg)->sender->entity > (*msg)->receiver->entity)
+                            painter->drawLine(x + w/2, y + h/2, x, y + h);
+                        else
+                            painter->drawLine(x + w/2, y + h/2, x, y);
+                    }
+                }
+
+            if (options->showAggregateSteps) {
+                xa = floor(((*evt)->step - startStep - 1) * blockwidth) + 1 + extents.x();
+                wa = barwidth;
+
+                painter->fillRect(QRectF(xa, y, wa, h),
+                                  QBrush(options->colormap->color((*evt)->getMetric(gnome->metric,
+                                                                                    true),
+                                                                  myopacity)));
+
+                if (step_spacing > 0 && entity_spacing > 0)
+                {
+                    painter->drawRect(QRectF(xa, y, wa, h));
+                }
+                drawnEvents.insert(*evt, QRect(xa, y, (x - xa) + w, h));
+            } else {
+                // For selection
+                drawnEvents.insert(*evt, QRect(x, y, w, h));
+            }
+
+        }
+    }
+
+    // Messages
+    // We need to do all of the message drawing after the event drawing
+    // for overlap purposes. We draw whether or not the vis options say we should
+    // because we are just for the pattern idea
+
+        if (gnome->top_entities.size() <= 32)
+            painter->setPen(QPen(Qt::black, 2, Qt::SolidLine));
+        else
+            painter->setPen(QPen(Qt::black, 1, Qt::SolidLine));
+        P2PEvent * send_event;
+        P2PEvent * recv_event;
+        QPointF p1, p2;
+        w = barwidth;
+        h = barheight;
+        for (QSet<Message *>::Iterator msg = drawMessages.begin();
+             msg != drawMessages.end(); ++msg) {
+            send_event = (*msg)->sender;
+            recv_event = (*msg)->receiver;
+            y = entityYs[send_event->entity];
+            if (options->showAggregateSteps)
+                x = floor((send_event->step - startStep) * blockwidth) + 1
+                    + extents.x();
+            else
+                x = floor((send_event->step - startStep) / 2 * blockwidth) + 1
+                    + extents.x();
+            if (options->showMessages == VisOptions::MSG_TRUE)
+            {
+                p1 = QPointF(x + w/2.0, y + h/2.0);
+                y = entityYs[recv_event->entity];
+                if (options->showAggregateSteps)
+                    x = floor((recv_event->step - startStep) * blockwidth) + 1
+                        + extents.x();
+                else
+                    x = floor((recv_event->step - startStep) / 2 * blockwidth)
+                        + 1 + extents.x();
+                p2 = QPointF(x + w/2.0, y + h/2.0);
+            }
+            else
+            {
+                p1 = QPointF(x, y + h/2.0);
+                y = entityYs[recv_event->entity];
+                p2 = QPointF(x + w, y + h/2.0);
+            }
+            painter->drawLine(p1, p2);
+        }
+
+}
+
+// Draw messages between clusters if we have opened to leaves
+void GnomeDrawer::drawGnomeQtInterMessages(QPainter * painter, int blockwidth,
+                                           int startStep, int startx)
+{
+    if (options->showAggregateSteps)
+        startStep -= 1;
+    painter->setPen(QPen(Qt::black, 1.5, Qt::SolidLine));
+    for (QSet<Message *>::Iterator msg = saved_messages.begin();
+         msg != saved_messages.end(); ++msg)
+    {
+        int x1, y1, x2, y2;
+        PartitionCluster * sender_pc = gnome->cluster_map->value((*msg)->sender->entity)->get_closed_root();
+        PartitionCluster * receiver_pc = gnome->cluster_map->value((*msg)->receiver->entity)->get_closed_root();
+
+        x1 = startx + blockwidth * ((*msg)->sender->step - startStep + 0.5);
+
+        // Sender is leaf
+        if (sender_pc->children->isEmpty())
+            y1 = sender_pc->extents.y() + sender_pc->extents.height() / 2;
+
+        // Sender is lower cluster
+        else if (sender_pc->extents.y() > receiver_pc->extents.y())
+            y1 = sender_pc->extents.y();
+
+        else
+            y1 = sender_pc->extents.y() + sender_pc->extents.height();
+
+
+
+        x2 = startx + blockwidth * ((*msg)->receiver->step - startStep + 0.5);
+
+        // Sender is leaf
+        if (receiver_pc->children->isEmpty())
+            y2 = receiver_pc->extents.y() + receiver_pc->extents.height() / 2;
+
+        // Sender is lower cluster
+        else if (receiver_pc->extents.y() > sender_pc->extents.y())
+            y2 = receiver_pc->extents.y();
+
+        else
+            y2 = receiver_pc->extents.y() + receiver_pc->extents.height();
+
+        painter->drawLine(x1, y1, x2, y2);
+    }
+}
+
+// Draw hierarchical clustering navigation tree recursively
+void GnomeDrawer::drawQtTree(QPainter * painter, QRect extents)
+{
+    int labelwidth = 0;
+    if (gnome->cluster_root->leaf_open())
+    {
+        painter->setFont(QFont("Helvetica", 10));
+        QFontMetrics font_metrics = painter->fontMetrics();
+        QString text = QString::number((*(std::max_element(gnome->cluster_root->members->begin(),
+                                                           gnome->cluster_root->members->end()))));
+
+        // Determine bounding box of FontMetrics
+        labelwidth = font_metrics.boundingRect(text).width();
+    }
+    int depth = gnome->cluster_root->max_open_depth();
+    int branch_length = 5;
+    if (depth == 0)
+        branch_length = 0;
+    else if (5 * depth < extents.width() - labelwidth)
+        branch_length = (extents.width() - labelwidth) / depth;
+
+    int topHeight = getTopHeight(extents);
+    int effectiveHeight = extents.height() - topHeight;
+    int entitiespan = gnome->partition->events->size();
+    float blockheight = effectiveHeight / 1.0 / entitiespan;
+    if (blockheight >= 1.0)
+        blockheight = floor(blockheight);
+
+    int leafx = branch_length * depth + labelwidth;
+
+    drawTreeBranch(painter, QRect(extents.x(),
+                                  extents.y() + topHeight,
+                                  extents.width(),
+                                  extents.height() - topHeight),
+                   gnome->cluster_root, branch_length, labelwidth, blockheight, leafx);
+}
+
+
+
+// Draw hierarchical clustering navigation tree recursively
+void GnomeDrawer::drawTreeBranch(QPainter * painter, QRect current,
+                                 PartitionCluster * pc,
+                                 int branch_length, int labelwidth,
+                                 float blockheight, int leafx)
+{
+    int pc_size = pc->members->size();
+    int my_x = current.x();
+    int top_y = current.y();
+    int my_y = top_y + pc_size / 2.0 * blockheight;
+    int child_x, child_y, used_y = 0;
+    painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+    if (pc->open && !pc->children->isEmpty())
+    {
+        for (QList<PartitionCluster *>::Iterator child = pc->children->begin();
+             child != pc->children->end(); ++child)
+        {
+            // Draw line from wherever we start to correct height -- actually
+            // loop through children since info this side? We are in the middle
+            // of these extents at current.x() and current.y() + current.h()
+            // Though we may want to take the discreteness of the entities
+            // into account and figure it out by blockheight
+            painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+            int child_size = (*child)->members->size();
+            child_y = top_y + child_size / 2.0 * blockheight + used_y;
+            painter->drawLine(my_x, my_y, my_x, child_y);
+
+            // Draw forward correct amount of px
+            child_x = my_x + branch_length;
+            painter->drawLine(my_x, child_y, child_x, child_y);
+
+            QRect node = QRect(my_x - 3, my_y - 3, 6, 6);
+            painter->fillRect(node, QBrush(Qt::black));
+            drawnNodes[pc] = node;
+
+            drawTreeBranch(painter, QRect(child_x, top_y + used_y,
+                                          current.width(), current.height()),
+                           *child, branch_length, labelwidth,
+                           blockheight, leafx);
+            used_y += child_size * blockheight;
+        }
+    }
+    else if (pc->children->isEmpty()) // Draw a leaf with label
+    {
+        painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+            int entity = pc->members->at(0);
+            painter->drawLine(my_x, my_y, leafx - labelwidth, my_y);
+            painter->setPen(QPen(Qt::white, 2.0, Qt::SolidLine));
+            painter->drawLine(leafx - labelwidth, my_y, leafx, my_y);
+            painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+            painter->drawText(leafx - labelwidth, my_y + 3,
+                              QString::number(entity));
+    }
+    else // This is a cluster leaf, no label but we extend the line all the way
+    {
+        painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+        painter->drawLine(my_x, my_y, leafx, my_y);
+    }
+
+
+}
+
+// This walks through the tree and finds the y position and height at which we
+// should draw the cluster in the main vis
+void GnomeDrawer::drawGnomeQtClusterBranch(QPainter * painter, QRect current,
+                                           PartitionCluster * pc,
+                                           float blockheight, int blockwidth,
+                                           int barheight, int barwidth)
+{
+    int my_x = current.x();
+    int top_y = current.y();
+    int used_y = 0;
+    painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+    if (pc->open && !pc->children->isEmpty())
+    {
+        // Draw line to myself
+        for (QList<PartitionCluster *>::Iterator child = pc->children->begin();
+             child != pc->children->end(); ++child)
+        {
+            // Draw line from wherever we start to correct height -- actually
+            // loop through children since info this side? We are in the middle
+            // of these extents at current.x() and current.y() + current.h()
+            // Though we may want to take the discreteness of the entities
+            // into account and figure it out by blockheight
+            int child_size = (*child)->members->size();
+            drawGnomeQtClusterBranch(painter, QRect(my_x,
+                                                    top_y + used_y,
+                                                    current.width(),
+                                                    current.height()),
+                                     *child, blockheight, blockwidth,
+                                     barheight, barwidth);
+            used_y += child_size * blockheight;
+        }
+    }
+    else if (pc->children->isEmpty() && pc->members->size() == 1) // A leaf
+    {
+        int entity = pc->members->at(0);
+        painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+        drawGnomeQtClusterLeaf(painter, QRect(current.x(), current.y(),
+                                              barwidth, barheight),
+                               gnome->partition->events->value(entity), blockwidth,
+                               gnome->partition->min_global_step);
+        drawnPCs[pc] = QRect(current.x(), current.y(),
+                             current.width(), blockheight);
+        pc->extents = drawnPCs[pc];
+    }
+    else // This is open
+    {
+        painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+        QRect clusterRect = QRect(current.x(), current.y(), current.width(),
+                                  blockheight * pc->members->size());
+        if (pc == selected_pc) {
+            painter->fillRect(clusterRect, QBrush(QColor(153, 255, 153)));
+        } else if (alternation) {
+            painter->fillRect(clusterRect, QBrush(QColor(217, 217, 217)));
+        } else {
+            painter->fillRect(clusterRect, QBrush(QColor(189, 189, 189)));
+        }
+        alternation = !alternation;
+        drawGnomeQtClusterEnd(painter, clusterRect, pc,
+                           barwidth, barheight, blockwidth, blockheight,
+                           gnome->partition->min_global_step);
+        drawnPCs[pc] = clusterRect;
+        pc->extents = clusterRect;
+    }
+
+
+}
+
+// If a cluster is a leaf with one entity, draw it similarly to StepVis
+void GnomeDrawer::drawGnomeQtClusterLeaf(QPainter * painter, QRect startxy,
+                                         QList<CommEvent *> * elist, int blockwidth,
+                                         int startStep)
+{
+    int y = startxy.y();
+    int x, w, h, xa, wa;
+    if (options->showAggregateSteps)
+        startStep -= 1;
+    painter->setPen(QPen(Qt::black, 2.0, Qt::SolidLine));
+    for (QList<CommEvent *>::Iterator evt = elist->begin();
+         evt != elist->end(); ++evt)
+    {
+        if (options->showAggregateSteps)
+            x = floor(((*evt)->step - startStep) * blockwidth) + 1
+                + startxy.x();
+        else
+            x = floor(((*evt)->step - startStep) / 2 * blockwidth) + 1
+                + startxy.x();
+        w = startxy.width();
+        h = startxy.height();
+
+        // We know it will be complete in this view because we're not doing
+        // scrolling or anything here.
+
+        // Draw the event
+        if ((*evt)->hasMetric(gnome->metric))
+            painter->fillRect(QRectF(x, y, w, h),
+                              QBrush(options->colormap->color((*evt)->getMetric(gnome->metric))));
+        else
+            painter->fillRect(QRectF(x, y, w, h),
+                              QBrush(QColor(180, 180, 180)));
+
+        // Draw border but only if we're doing spacing, otherwise too messy
+        if (blockwidth != w)
+            painter->drawRect(QRectF(x,y,w,h));
+
+        if (options->showAggregateSteps) {
+            xa = floor(((*evt)->step - startStep - 1) * blockwidth) + 1
+                 + startxy.x();
+            wa = startxy.width();
+
+            if ((*evt)->hasMetric(gnome->metric))
+                painter->fillRect(QRectF(xa, y, wa, h),
+                                  QBrush(options->colormap->color((*evt)->getMetric(gnome->metric,
+                                                                                    true))));
+            else
+                painter->fillRect(QRectF(xa, y, wa, h),
+                                  QBrush(QColor(180, 180, 180)));
+            if (blockwidth != w)
+                painter->drawRect(QRectF(xa, y, wa, h));
+        }
+
+        // Chnage to commBundle method
+        QVector<Message *> * msgs = (*evt)->getMessages();
+        if (msgs)
+            for (QVector<Message *>::Iterator msg = msgs->begin();
+                 msg != msgs->end(); ++msg)
+            {
+                saved_messages.insert(*msg);
+            }
+
+    }
+}
+
+// We have a lot of modifiers on our double click.
+GnomeDrawer::ChangeType GnomeDrawer::handleDoubleClick(QMouseEvent * event)
+{
+    int x = event->x();
+    int y = event->y();
+    // Find the clicked PartitionCluster
+    for (QMap<PartitionCluster *, QRect>::Iterator p = drawnPCs.begin();
+         p != drawnPCs.end(); ++p)
+    {
+        if (p.value().contains(x,y))
+        {
+            PartitionCluster * pc = p.key();
+            if ((Qt::ControlModifier && event->modifiers())
+                && (event->button() == Qt::RightButton))
+            {
+                // Focus entities on centroid of this cluster
+                options->topByCentroid = true;
+                gnome->top_by_centroid = true;
+                gnome->generateTopEntities(pc);
+                return CHANGE_NONE;
+            }
+            else if (Qt::ControlModifier && event->modifiers())
+            {
+                // Focus entities on max metric
+                options->topByCentroid = false;
+                gnome->top_by_centroid = false;
+                gnome->generateTopEntities(pc);
+                return CHANGE_NONE;
+            }
+            else if (event->button() == Qt::RightButton)
+            {
+                // Select a cluster
+                if (selected_pc == pc)
+                {
+                    selected_pc = NULL;
+                }
+                else
+                {
+                    selected_pc = pc;
+                }
+                return CHANGE_SELECTION;
+            }
+            else if (!pc->children->isEmpty())
+            {
+                // Open a cluster if possible
+                pc->open = true;
+                return CHANGE_CLUSTER;
+            }
+        }
+    }
+
+    return CHANGE_NONE;
+}
+
+// Click on tree navigation (close clusters)
+void GnomeDrawer::handleTreeDoubleClick(QMouseEvent * event)
+{
+    int x = event->x();
+    int y = event->y();
+
+    // Figure out which branch this occurs in, open that branch
+    for (QMap<PartitionCluster *, QRect>::Iterator p = drawnNodes.begin();
+         p != drawnNodes.end(); ++p)
+    {
+        if (p.value().contains(x,y))
+        {
+            PartitionCluster * pc = p.key();
+            pc->close();
+            return; // Return so we don't look elsewhere.
+        }
+    }
+}
+
+
+// This is the basic function for drawing a cluster. This should be overriden
+// by child classes that want to change this drawing style.
+void GnomeDrawer::drawGnomeQtClusterEnd(QPainter * painter, QRect clusterRect,
+                                        PartitionCluster * pc,
+                                        int barwidth, int barheight,
+                                        int blockwidth, int blockheight,
+                                        int startStep)
+{
+    bool drawMessages = true;
+    // Find height constraints
+    if (clusterRect.height() > 2 * clusterMaxHeight)
+    {
+        blockheight = 2*(clusterMaxHeight - 20);
+        barheight = blockheight; // - 3;
+    }
+    else
+    {
+        blockheight = clusterRect.height() / 2;
+        if (blockheight < 40)
+            drawMessages = false;
+        else
+            blockheight -= 20; // For message drawing
+        if (barheight > blockheight - 3)
+            barheight = blockheight;
+    }
+
+    // Figure out base values
+    int base_y = clusterRect.y() + clusterRect.height() / 2 - blockheight / 2;
+    int x, ys, yr, yc, w, hs, hr, hc, xa, wa, nsends, nrecvs, ncolls;
+    if (options->showAggregateSteps) {
+        startStep -= 1;
+    }
+
+    // Draw partition cluster events
+    painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+    for (QList<ClusterEvent *>::Iterator evt = pc->events->begin();
+         evt != pc->events->end(); ++evt)
+    {
+        if (options->showAggregateSteps)
+            x = floor(((*evt)->step - startStep) * blockwidth) + 1
+                + clusterRect.x();
+        else
+            x = floor(((*evt)->step - startStep) / 2 * blockwidth) + 1
+                + clusterRect.x();
+        w = barwidth;
+        nsends = (*evt)->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_SEND)
+                 + (*evt)->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_ISEND);
+        nrecvs = (*evt)->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_RECV)
+                 + (*evt)->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_WAITALL);
+        ncolls = (*evt)->getCount(ClusterEvent::CE_EVENT_COMM, ClusterEvent::CE_COMM_COLL);
+
+        int divisor = pc->members->size();
+        if (!options->showInactiveSteps)
+            divisor = nsends + nrecvs;
+
+        hs = blockheight * nsends / 1.0 / divisor;
+        ys = base_y;
+        hr = blockheight * nrecvs / 1.0 / divisor;
+        yr = base_y + blockheight - hr;
+
+        hc = blockheight * ncolls / 1.0 / divisor;
+        yc = base_y + hs;
+
+        // Draw the event
+        if (nsends)
+            painter->fillRect(QRectF(x, ys, w, hs),
+                              QBrush(options->colormap->color(((*evt)->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                                ClusterEvent::CE_COMM_SEND,
+                                                                                ClusterEvent::CE_THRESH_BOTH)
+                                                              + (*evt)->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                                  ClusterEvent::CE_COMM_ISEND,
+                                                                                  ClusterEvent::CE_THRESH_BOTH))
+                                                              / nsends)));
+        if (nrecvs)
+            painter->fillRect(QRectF(x, yr, w, hr),
+                              QBrush(options->colormap->color(((*evt)->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                                 ClusterEvent::CE_COMM_RECV,
+                                                                                 ClusterEvent::CE_THRESH_BOTH)
+                                                              + (*evt)->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                                  ClusterEvent::CE_COMM_WAITALL,
+                                                                                  ClusterEvent::CE_THRESH_BOTH))
+                                                              / nrecvs)));
+        if (ncolls)
+            painter->fillRect(QRectF(x, yc, w, hc),
+                              QBrush(options->colormap->color((*evt)->getMetric(ClusterEvent::CE_EVENT_COMM,
+                                                                                ClusterEvent::CE_COMM_COLL,
+                                                                                ClusterEvent::CE_THRESH_BOTH)
+                                                              / ncolls)));
+
+        // Draw border but only if we're doing spacing, otherwise too messy
+        if (blockwidth != w) {
+            painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+            painter->drawRect(QRect(x, ys, w, blockheight));
+        }
+
+        // Message lines
+        if (drawMessages) {
+            if (nsends)
+            {
+                painter->setPen(QPen(Qt::black, nsends * 2.0 / divisor,
+                                     Qt::SolidLine));
+                painter->drawLine(x + blockwidth / 2, ys, x + barwidth,
+                                  ys - 20);
+            }
+            if (nrecvs)
+            {
+                painter->setPen(QPen(Qt::black, nrecvs * 2.0 / divisor,
+                                     Qt::SolidLine));
+                painter->drawLine(x + blockwidth / 2, ys + blockheight, x + 1,
+                                  ys + blockheight + 20);
+            }
+
+            if (ncolls && hc > 5)
+            {
+                painter->setPen(QPen(Qt::black, 1.0, Qt::DashLine));
+                painter->drawLine(x,yc,x+w,yc+hc);
+                painter->drawLine(x,yc+hc,x+w,yc);
+            }
+            else if (ncolls && hc > 3 && hs > 3)
+            {
+                painter->setPen(QPen(Qt::black, 1.0, Qt::DashLine));
+                painter->drawLine(x,yc,x+w,yc);
+            }
+        }
+        else if (ncolls && nsends && hc > 3 && hs > 3) // Delimit
+        {
+            painter->setPen(QPen(Qt::black, 1.0, Qt::DashLine));
+            painter->drawLine(x,yc,x+w,yc);
+        }
+
+        // Aggregate step
+        if (options->showAggregateSteps) {
+            xa = floor(((*evt)->step - startStep - 1) * blockwidth) + 1
+                 + clusterRect.x();
+            wa = barwidth;
+
+            if (nsends)
+                painter->fillRect(QRectF(xa, ys, wa, hs),
+                                  QBrush(options->colormap->color(((*evt)->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                    ClusterEvent::CE_COMM_SEND,
+                                                                                    ClusterEvent::CE_THRESH_BOTH)
+                                                                  + (*evt)->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                      ClusterEvent::CE_COMM_ISEND,
+                                                                                      ClusterEvent::CE_THRESH_BOTH))
+                                                                  / nsends)));
+            if (nrecvs)
+                painter->fillRect(QRectF(xa, yr, wa, hr),
+                                  QBrush(options->colormap->color(((*evt)->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                     ClusterEvent::CE_COMM_RECV,
+                                                                                     ClusterEvent::CE_THRESH_BOTH)
+                                                                  + (*evt)->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                      ClusterEvent::CE_COMM_WAITALL,
+                                                                                      ClusterEvent::CE_THRESH_BOTH))
+                                                                 / nrecvs)));
+            if (ncolls)
+                painter->fillRect(QRectF(xa, yc, wa, hc),
+                                  QBrush(options->colormap->color((*evt)->getMetric(ClusterEvent::CE_EVENT_AGG,
+                                                                                    ClusterEvent::CE_COMM_COLL,
+                                                                                    ClusterEvent::CE_THRESH_BOTH)
+                                                                  / ncolls)));
+            if (blockwidth != w)
+            {
+                painter->setPen(QPen(Qt::black, 1.0, Qt::SolidLine));
+                painter->drawRect(QRectF(xa, ys, wa, blockheight));
+            }
+        }
+
+
+    }
+}
+
+
+// Divide hover into event and preceding aggregate event in case we want to do
+// something different with it
+bool GnomeDrawer::handleHover(QMouseEvent * event)
+{
+    return false;
+    mousex = event->x();
+    mousey = event->y();
+    QRect evtRect;
+    Event * evt = drawnEvents.find(mousex, mousey, &evtRect);
+    bool aggregate = evt && options->showAggregateSteps
+                     && mousex <= evtRect.x() + stepwidth;
+    if (evt != hover_event || aggregate != hover_aggregate)
+    {
+        hover_event = evt;
+        hover_aggregate = aggregate;
+        return true;
+    }
+    return false;
+}
+
+// Drawing the hover text, no aggregate yet though
+void GnomeDrawer::drawHover(QPainter * painter)
+{
+    if (hover_event == NULL)
+        return;
+
+    painter->setFont(QFont("Helvetica", 10));
+    QFontMetrics font_metrics = painter->fontMetrics();
+
+    QString text = "";
+    if (hover_aggregate)
+    {
+        return;
+        text = "Aggregate for now";
+    }
+    else
+    {
+        // Fall through and draw Event
+        text = gnome->functions->value(hover_event->function)->name;
+    }
+
+    // Determine bounding box of FontMetrics
+    QRect textRect = font_metrics.boundingRect(text);
+
+    // Draw bounding box
+    painter->setPen(QPen(QColor(255, 255, 0, 150), 1.0, Qt::SolidLine));
+    painter->drawRect(QRectF(mousex, mousey,
+                             textRect.width(), textRect.height()));
+    painter->fillRect(QRectF(mousex, mousey,
+                             textRect.width(),textRect.height()),
+                      QBrush(QColor(255, 255, 144, 150)));
+
+    // Draw text
+    painter->setPen(Qt::black);
+    painter->drawText(mousex + 2, mousey + textRect.height() - 2, text);
+}
@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef GNOMEDRAWER_H
+#define GNOMEDRAWER_H
+
+#include "visoptions.h"
+#include "hitgrid.h"
+#include <QPainter>
+#include <QRect>
+#include <QPoint>
+#include <QMap>
+#include <QSet>
+
+class Gnome;
+class Event;
+class CommEvent;
+class Message;
+class PartitionCluster;
+class QMouseEvent;
+
+// Draws a Gnome's clustering in the cluster views and handles interaction
+// with it. Subclasses pair with Gnome subclasses that have a special
+// drawing style, see create().
+class GnomeDrawer
+{
+public:
+    GnomeDrawer(Gnome * _gnome);
+    virtual ~GnomeDrawer() {}
+
+    static GnomeDrawer * create(Gnome * gnome);
+    Gnome * getGnome() { return gnome; }
+
+    enum ChangeType { CHANGE_CLUSTER, CHANGE_SELECTION, CHANGE_NONE };
+
+    // Tree GUI
+    virtual void drawQtTree(QPainter * painter, QRect extents);
+    void drawTopLabels(QPainter * painter, QRect extents);
+    virtual void handleTreeDoubleClick(QMouseEvent * event);
+
+    // Main GUI
+    virtual void drawGnomeQt(QPainter * painter, QRect extents,
+                             VisOptions * _options, int blockwidth);
+    virtual void drawGnomeGL(QRect extents, VisOptions * _options)
+        { Q_UNUSED(extents); options = _options; }
+    virtual ChangeType handleDoubleClick(QMouseEvent * event);
+    PartitionCluster * getSelectedPartitionCluster() { return selected_pc; }
+    void setSelected(bool selected) { is_selected = selected; }
+    void clearSelectedPartitionCluster() { selected_pc = NULL; }
+    bool handleHover(QMouseEvent * event);
+    void drawHover(QPainter * painter);
+    int drawnEventCount() const { return drawnEvents.size(); }
+
+protected:
+    Gnome * gnome;
+    VisOptions * options;
+    int mousex;
+    int mousey;
+
+    class DrawMessage {
+    public:
+        DrawMessage(QPoint _send, QPoint _recv, int _nsends)
+            : send(_send), recv(_recv), nsends(_nsends), nrecvs(0) { }
+
+        QPoint send;
+        QPoint recv;
+        int nsends;
+        int nrecvs;
+    };
+
+    bool alternation; // cluster background
+
+    QSet<Message *> saved_messages;
+    QMap<PartitionCluster *, QRect> drawnPCs;
+    QMap<PartitionCluster *, QRect> drawnNodes;
+    HitGrid drawnEvents;
+    PartitionCluster * selected_pc;
+    bool is_selected;
+    Event * hover_event;
+    bool hover_aggregate;
+    int stepwidth;
+
+    void drawGnomeQtCluster(QPainter * painter, QRect extents, int blockwidth);
+    void drawGnomeQtTopEntities(QPainter * painter, QRect extents,
+                                 int blockwidth, int barwidth);
+    void drawGnomeQtClusterBranch(QPainter * painter, QRect current,
+                                  PartitionCluster * pc,
+                                  float blockheight, int blockwidth, int barheight,
+                                  int barwidth);
+    void drawGnomeQtClusterLeaf(QPainter * painter, QRect startxy,
+                                QList<CommEvent *> *elist,
+                                int blockwidth, int startStep);
+    void drawGnomeQtInterMessages(QPainter * painter, int blockwidth,
+                                  int startStep, int startx);
+    virtual void drawGnomeQtClusterEnd(QPainter * painter, QRect clusterRect,
+                                       PartitionCluster * pc,
+                                       int barwidth, int barheight,
+                                       int blockwidth, int blockheight,
+                                       int startStep); // blockheight not used
+    void drawTreeBranch(QPainter * painter, QRect current,
+                        PartitionCluster * pc,
+                        int branch_length, int labelwidth, float blockheight,
+                        int leafx);
+    int getTopHeight(QRect extents);
+
+    static const int clusterMaxHeight = 76;
+};
+
+#endif // GNOMEDRAWER_H
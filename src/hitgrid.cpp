@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "hitgrid.h"
+
+HitGrid::HitGrid()
+    : bounds(QRect()),
+      columns(0),
+      rows(0),
+      items(QVector<Item>()),
+      heads(QVector<int>()),
+      entry_items(QVector<int>()),
+      entry_next(QVector<int>())
+{
+}
+
+void HitGrid::reset(const QRect &_bounds)
+{
+    bounds = _bounds;
+    columns = 0;
+    rows = 0;
+    if (bounds.isValid())
+    {
+        columns = (bounds.width() + cell_size - 1) / cell_size;
+        rows = (bounds.height() + cell_size - 1) / cell_size;
+    }
+    heads.resize(columns * rows);
+    clear();
+}
+
+// Keeps the capacity so repainting does not reallocate
+void HitGrid::clear()
+{
+    items.resize(0);
+    entry_items.resize(0);
+    entry_next.resize(0);
+    heads.fill(-1);
+}
+
+void HitGrid::insert(Event * evt, const QRect &rect)
+{
+    QRect visible = rect.intersected(bounds);
+    if (visible.isEmpty())
+        return;
+
+    Item item;
+    item.evt = evt;
+    item.rect = rect;
+    int index = items.size();
+    items.append(item);
+
+    int first_column = (visible.left() - bounds.left()) / cell_size;
+    int last_column = (visible.right() - bounds.left()) / cell_size;
+    int first_row = (visible.top() - bounds.top()) / cell_size;
+    int last_row = (visible.bottom() - bounds.top()) / cell_size;
+    for (int r = first_row; r <= last_row; r++)
+    {
+        for (int c = first_column; c <= last_column; c++)
+        {
+            int cell = r * columns + c;
+            entry_next.append(heads[cell]);
+            entry_items.append(index);
+            heads[cell] = entry_items.size() - 1;
+        }
+    }
+}
+
+Event * HitGrid::find(int x, int y, QRect * rect) const
+{
+    if (!bounds.contains(x, y))
+        return NULL;
+
+    int cell = ((y - bounds.top()) / cell_size) * columns
+               + (x - bounds.left()) / cell_size;
+    for (int entry = heads[cell]; entry >= 0; entry = entry_next[entry])
+    {
+        const Item &item = items[entry_items[entry]];
+        if (item.rect.contains(x, y))
+        {
+            if (rect)
+                *rect = item.rect;
+            return item.evt;
+        }
+    }
+    return NULL;
+}
+
+long long HitGrid::memoryBytes() const
+{
+    return items.capacity() * sizeof(Item)
+           + (heads.capacity() + entry_items.capacity()
+              + entry_next.capacity()) * sizeof(int);
+}
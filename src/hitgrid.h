@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef HITGRID_H
+#define HITGRID_H
+
+#include <QRect>
+#include <QVector>
+
+class Event;
+
+// The rectangles events were drawn at, for finding the event under the
+// mouse. Each rectangle is filed under the cells of a uniform grid over the
+// drawing area, newest first, so adding one is constant time for the small
+// boxes the views draw and a lookup only checks the rectangles in one cell.
+// Where rectangles overlap, the one added last, i.e. drawn on top, wins.
+class HitGrid
+{
+public:
+    HitGrid();
+
+    void reset(const QRect &_bounds); // clear and cover a new area
+    void clear();
+    void insert(Event * evt, const QRect &rect);
+    Event * find(int x, int y, QRect * rect = NULL) const;
+    bool isEmpty() const { return items.isEmpty(); }
+    int size() const { return items.size(); }
+    long long memoryBytes() const;
+
+    static const int cell_size = 16; // pixels
+
+private:
+    class Item {
+    public:
+        Event * evt;
+        QRect rect;
+    };
+
+    QRect bounds;
+    int columns;
+    int rows;
+    QVector<Item> items;
+    QVector<int> heads; // per cell, newest entry or -1
+    QVector<int> entry_items;
+    QVector<int> entry_next;
+};
+
+#endif // HITGRID_H
@@ -31,6 +31,7 @@
 #include "otfconverter.h"
 #include "importoptions.h"
 #include "otf2importer.h"
+#include "selfprofiler.h"
 
 ImportFunctor::ImportFunctor(ImportOptions * _options)
     : options(_options),
@@ -40,6 +41,7 @@ ImportFunctor::ImportFunctor(ImportOptions * _options)
 
 void ImportFunctor::doImportCharm(QString dataFileName)
 {
+    SelfProfiler::Span span("doImportCharm");
     std::cout << "Processing " << dataFileName.toStdString().c_str() << std::endl;
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
@@ -49,7 +51,7 @@ void ImportFunctor::doImportCharm(QString dataFileName)
     CharmImporter * importer = new CharmImporter();
     importer->importCharmLog(dataFileName, options);
 
-    Trace* trace = importer->getTrace();
+    trace = importer->getTrace();
     delete importer;
     trace->fullpath = dataFileName;
     //delete converter;
@@ -68,6 +70,7 @@ void ImportFunctor::doImportCharm(QString dataFileName)
 
 void ImportFunctor::doImportOTF2(QString dataFileName)
 {
+    SelfProfiler::Span span("doImportOTF2");
     std::cout << "Processing " << dataFileName.toStdString().c_str() << std::endl;
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
@@ -78,7 +81,7 @@ void ImportFunctor::doImportOTF2(QString dataFileName)
     connect(importer, SIGNAL(finishRead()), this, SLOT(finishInitialRead()));
     connect(importer, SIGNAL(matchingUpdate(int, QString)), this,
             SLOT(updateMatching(int, QString)));
-    Trace* trace = importer->importOTF2(dataFileName, options);
+    trace = importer->importOTF2(dataFileName, options);
     delete importer;
 
     if (trace)
@@ -103,6 +106,7 @@ void ImportFunctor::doImportOTF2(QString dataFileName)
 void ImportFunctor::doImportOTF(QString dataFileName)
 {
     #ifdef OTF1LIB
+    SelfProfiler::Span span("doImportOTF");
     std::cout << "Processing " << dataFileName.toStdString().c_str() << std::endl;
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
@@ -113,7 +117,7 @@ void ImportFunctor::doImportOTF(QString dataFileName)
     connect(importer, SIGNAL(finishRead()), this, SLOT(finishInitialRead()));
     connect(importer, SIGNAL(matchingUpdate(int, QString)), this,
             SLOT(updateMatching(int, QString)));
-    Trace* trace = importer->importOTF(dataFileName, options);
+    trace = importer->importOTF(dataFileName, options);
     delete importer;
 
     if (trace)
@@ -23,6 +23,7 @@
 // Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 //////////////////////////////////////////////////////////////////////////////
 #include "importoptions.h"
+#include <algorithm>
 
 ImportOptions::ImportOptions(bool _waitall, bool _leap, bool _skip,
                              bool _partition, QString _fxn)
@@ -37,6 +38,8 @@ ImportOptions::ImportOptions(bool _waitall, bool _leap, bool _skip,
       enforceMessageSizes(false),
       seedClusters(false),
       clusterSeed(0),
+      maxClusters(20),
+      autoClusters(true),
       advancedStepping(true),
       reorderReceives(false),
       origin(OF_NONE),
@@ -60,6 +63,8 @@ void ImportOptions::saveSettings(QSettings * settings)
     settings->setValue("partitionFunction", partitionFunction);
     settings->setValue("seedClusters", seedClusters);
     settings->setValue("clusterSeed", qlonglong(clusterSeed));
+    settings->setValue("maxClusters", maxClusters);
+    settings->setValue("autoClusters", autoClusters);
     settings->setValue("advancedStepping", advancedStepping);
     settings->setValue("reorderReceives", reorderReceives);
     settings->setValue("isset", true);
@@ -84,12 +89,41 @@ void ImportOptions::readSettings(QSettings * settings)
         partitionFunction = settings->value("partitionFunction").toString();
         seedClusters = settings->value("seedClusters").toBool();
         clusterSeed = settings->value("clusterSeed").toInt();
+        maxClusters = settings->value("maxClusters", 20).toInt();
+        autoClusters = settings->value("autoClusters", true).toBool();
         advancedStepping = settings->value("advancedStepping").toBool();
         reorderReceives = settings->value("reorderReceives").toBool();
     }
     settings->endGroup();
 }
 
+bool ImportOptions::setOriginFromFile(QString filename)
+{
+    if (filename.endsWith("otf", Qt::CaseInsensitive))
+    {
+        origin = OF_OTF;
+    }
+    else if (filename.endsWith("otf2", Qt::CaseInsensitive))
+    {
+        origin = OF_OTF2;
+        waitallMerge = false; // Not applicable
+    }
+    else if (filename.endsWith("sts", Qt::CaseInsensitive))
+    {
+        origin = OF_CHARM;
+        waitallMerge = false; // Not applicable
+        leapMerge = false; // Not applicable across all chare arrays -- perhaps per chare array
+        isendCoalescing = false; // Not applicable
+        callerMerge = false; // Done differently in charm importer
+        advancedStepping = false; // Not for this
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
 QList<QString> ImportOptions::getOptionNames()
 {
     QList<QString> names = QList<QString>();
@@ -105,9 +139,11 @@ QList<QString> ImportOptions::getOptionNames()
     names.append("option_enforceMessageSizes");
     names.append("option_partitionFunction");
     names.append("option_seedClusters");
-    names.append("option.clusterSeed");
-    names.append("option.advancedStepping");
-    names.append("option.reorderReceives");
+    names.append("option_clusterSeed");
+    names.append("option_maxClusters");
+    names.append("option_autoClusters");
+    names.append("option_advancedStepping");
+    names.append("option_reorderReceives");
     return names;
 }
 
@@ -139,44 +175,106 @@ QString ImportOptions::getOptionValue(QString option)
         return seedClusters ? "true" : "";
     else if (option == "option_clusterSeed")
         return QString::number(clusterSeed);
-    else if (option == "option.advancedStepping")
+    else if (option == "option_maxClusters")
+        return QString::number(maxClusters);
+    else if (option == "option_autoClusters")
+        return autoClusters ? "true" : "";
+    else if (option == "option_advancedStepping")
         return advancedStepping ? "true" : "";
-    else if (option == "option.reorderReceives")
+    else if (option == "option_reorderReceives")
         return reorderReceives ? "true" : "";
     else
         return "";
 }
 
-void ImportOptions::setOption(QString option, QString value)
+// Saved traces write false as an empty value, so that is accepted too.
+// The option is left alone if the value is not a boolean.
+static bool parseBool(QString value, bool &option)
 {
+    value = value.trimmed().toLower();
+    if (value == "true" || value == "1")
+        option = true;
+    else if (value == "false" || value == "0" || value.isEmpty())
+        option = false;
+    else
+        return false;
+    return true;
+}
+
+// Returns false and leaves the option as it was if the name is unknown or
+// the value does not parse
+bool ImportOptions::setOption(QString option, QString value, QString * error)
+{
+    bool ok = true;
     if (option == "option_waitallMerge")
-        waitallMerge = value.size();
+        ok = parseBool(value, waitallMerge);
     else if (option == "option_callerMerge")
-        callerMerge = value.size();
+        ok = parseBool(value, callerMerge);
     else if (option == "option_leapMerge")
-        leapMerge = value.size();
+        ok = parseBool(value, leapMerge);
     else if (option == "option_leapSkip")
-        leapSkip = value.size();
+        ok = parseBool(value, leapSkip);
     else if (option == "option_partitionByFunction")
-        partitionByFunction = value.size();
+        ok = parseBool(value, partitionByFunction);
     else if (option == "option_globalMerge")
-        globalMerge = value.size();
+        ok = parseBool(value, globalMerge);
     else if (option == "option_cluster")
-        cluster = value.size();
+        ok = parseBool(value, cluster);
     else if (option == "option_isendCoalescing")
-        isendCoalescing = value.size();
+        ok = parseBool(value, isendCoalescing);
     else if (option == "option_enforceMessageSizes")
-        enforceMessageSizes = value.size();
+        ok = parseBool(value, enforceMessageSizes);
     else if (option == "option_partitionFunction")
         partitionFunction = value;
     else if (option == "option_breakFunctions")
         breakFunctions = value;
     else if (option == "option_seedClusters")
-        seedClusters = value.size();
+        ok = parseBool(value, seedClusters);
     else if (option == "option_clusterSeed")
-        clusterSeed = value.toLong();
+    {
+        long seed = value.toLong(&ok);
+        if (ok)
+            clusterSeed = seed;
+    }
+    else if (option == "option_maxClusters")
+    {
+        int clusters = value.toInt(&ok);
+        ok = ok && clusters >= 1;
+        if (ok)
+            maxClusters = clusters;
+    }
+    else if (option == "option_autoClusters")
+        ok = parseBool(value, autoClusters);
     else if (option == "option_advancedStepping")
-        advancedStepping = value.size();
+        ok = parseBool(value, advancedStepping);
     else if (option == "option_reorderReceives")
-        reorderReceives = value.size();
+        ok = parseBool(value, reorderReceives);
+    else
+    {
+        if (error)
+            *error = "Unknown import option " + option;
+        return false;
+    }
+
+    if (!ok && error)
+        *error = "Bad value \"" + value + "\" for " + option;
+    return ok;
+}
+
+bool ImportOptions::setOptions(const QStringList &arguments, QString * error)
+{
+    for (QStringList::ConstIterator argument = arguments.begin();
+         argument != arguments.end(); ++argument)
+    {
+        int split = argument->indexOf('=');
+        bool ok;
+        if (split < 0)
+            ok = setOption(*argument, "true", error);
+        else
+            ok = setOption(argument->left(split), argument->mid(split + 1),
+                           error);
+        if (!ok)
+            return false;
+    }
+    return true;
 }
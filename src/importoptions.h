@@ -28,6 +28,7 @@
 #include <QString>
 #include <QList>
 #include <QSettings>
+#include <QStringList>
 
 // Container for all the structure extraction options
 class ImportOptions
@@ -40,12 +41,20 @@ public:
     // Annoying stuff for cramming into OTF2 format
     QList<QString> getOptionNames();
     QString getOptionValue(QString option);
-    void setOption(QString option, QString value);
+    bool setOption(QString option, QString value, QString * error = NULL);
+
+    // Set options from "name=value" strings, a bare name meaning true, as
+    // given on the command line. Stops at the first bad one.
+    bool setOptions(const QStringList &arguments, QString * error = NULL);
     void saveSettings(QSettings * settings);
     void readSettings(QSettings * settings);
 
     enum OriginFormat { OF_NONE, OF_SAVE_OTF2, OF_OTF2, OF_OTF, OF_CHARM };
 
+    // Set origin by trace file extension and turn off options that do not
+    // apply to that format. Returns false if the format is not recognized.
+    bool setOriginFromFile(QString filename);
+
     bool waitallMerge; // use waitall heuristic
     bool callerMerge; // merge for common callers
     bool leapMerge; // merge to complete leaps
@@ -58,6 +67,8 @@ public:
 
     bool seedClusters; // seed has been set
     long clusterSeed; // random seed for clustering
+    int maxClusters; // cap on the number of clusters per partition
+    bool autoClusters; // choose the number of clusters up to the cap
 
     bool advancedStepping; // send structure over receives
     bool reorderReceives; // idealized receive order;
@@ -66,6 +66,10 @@ ImportOptionsDialog::ImportOptionsDialog(QWidget *parent,
             SLOT(onRecvReorder(bool)));
     connect(ui->seedEdit, SIGNAL(textChanged(QString)), this,
             SLOT(onSeedEdit(QString)));
+    connect(ui->maxClustersSpin, SIGNAL(valueChanged(int)), this,
+            SLOT(onMaxClusters(int)));
+    connect(ui->autoClustersCheckbox, SIGNAL(clicked(bool)), this,
+            SLOT(onAutoClusters(bool)));
     setUIState();
 }
 
@@ -175,6 +179,16 @@ void ImportOptionsDialog::onSeedEdit(const QString& text)
     }
 }
 
+void ImportOptionsDialog::onMaxClusters(int max_clusters)
+{
+    options->maxClusters = max_clusters;
+}
+
+void ImportOptionsDialog::onAutoClusters(bool choose)
+{
+    options->autoClusters = choose;
+}
+
 // Based on currently operational options, set the UI state to
 // something consistent (e.g., in certain modes other options are
 // unavailable)
@@ -213,6 +227,10 @@ void ImportOptionsDialog::setUIState()
         ui->seedEdit->setText("");
     }
     ui->seedEdit->setEnabled(options->cluster);
+    ui->maxClustersSpin->setValue(options->maxClusters);
+    ui->maxClustersSpin->setEnabled(options->cluster);
+    ui->autoClustersCheckbox->setChecked(options->autoClusters);
+    ui->autoClustersCheckbox->setEnabled(options->cluster);
 
 
     ui->recvReorderCheckbox->setEnabled(!options->cluster);
@@ -60,6 +60,8 @@ public slots:
     void onBreakEdit(const QString& text);
     void onCluster(bool cluster);
     void onSeedEdit(const QString& text);
+    void onMaxClusters(int max_clusters);
+    void onAutoClusters(bool choose);
 
 
 private:
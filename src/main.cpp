@@ -25,10 +25,12 @@
 /* Ravel */
 #include <QApplication>
 #include "mainwindow.h"
+#include "selfprofiler.h"
 
 int main(int argc, char **argv)
 {
     QApplication app(argc, argv);
+    SelfProfiler::startFromEnvironment();
     MainWindow w;
     w.show();
     return app.exec();
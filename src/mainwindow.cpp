@@ -40,9 +40,14 @@
 #include "visoptionsdialog.h"
 #include "importfunctor.h"
 #include "otf2exportfunctor.h"
+#include "memorycensus.h"
+#include "stagetimer.h"
 
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
 #include <QMessageBox>
 #include "qtconcurrentrun.h"
 #include <iostream>
@@ -185,6 +190,12 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionVisualization, SIGNAL(triggered()), this,
             SLOT(launchVisOptions()));
     ui->actionVisualization->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_V));
+    connect(ui->actionMemory_Usage, SIGNAL(triggered()), this,
+            SLOT(showMemoryUsage()));
+    connect(ui->actionFrame_Statistics, SIGNAL(toggled(bool)), this,
+            SLOT(toggleFrameStats(bool)));
+    connect(ui->actionExport_Frame_Times, SIGNAL(triggered()), this,
+            SLOT(exportFrameStats()));
 
 
     connect(ui->actionLogical_Steps, SIGNAL(triggered()), this,
@@ -311,6 +322,62 @@ void MainWindow::launchVisOptions()
         viswidgets[i]->repaint();
 }
 
+// Estimate what the open traces and the views hold in memory
+void MainWindow::showMemoryUsage()
+{
+    MemoryCensus census;
+    for (QList<Trace *>::Iterator trace = traces.begin();
+         trace != traces.end(); ++trace)
+    {
+        census.countTrace(*trace);
+    }
+    for (int i = 0; i < viswidgets.size(); i++)
+        viswidgets[i]->countMemory(&census);
+
+    QMessageBox msgBox;
+    msgBox.setWindowTitle("Memory Usage");
+    msgBox.setText(QString::number(traces.size()) + " open trace(s), peak RSS "
+                   + MemoryCensus::formatBytes(StageTimer::peakRSS()));
+    msgBox.setInformativeText("<pre>" + census.report() + "</pre>");
+    msgBox.exec();
+}
+
+// Draw each view's last frame time and counts over it
+void MainWindow::toggleFrameStats(bool show)
+{
+    for (int i = 0; i < viswidgets.size(); i++)
+    {
+        viswidgets[i]->setShowFrameStats(show);
+        viswidgets[i]->repaint();
+    }
+}
+
+// Write the recent frames of every view to one CSV file
+void MainWindow::exportFrameStats()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    tr("Export Frame Times"),
+                                                    QFileInfo(QDir(dataDirectory),
+                                                              "frames.csv").absoluteFilePath(),
+                                                    tr("CSV Files(*.csv)"));
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        QMessageBox::warning(this, tr("Cannot Export Frame Times"),
+                             tr("Unable to write ") + fileName,
+                             QMessageBox::Ok);
+        return;
+    }
+    QTextStream out(&file);
+    FrameStats::writeCSVHeader(out);
+    for (int i = 0; i < viswidgets.size(); i++)
+        viswidgets[i]->getFrameStats()->writeCSV(out,
+                                                 viswidgets[i]->metaObject()->className());
+}
+
 void MainWindow::saveCurrentTrace()
 {
     // Get save file name
@@ -399,39 +466,30 @@ void MainWindow::importTrace(QString dataFileName){
     importWorker = new ImportFunctor(importoptions);
     importWorker->moveToThread(importThread);
 
-    if (dataFileName.endsWith("otf", Qt::CaseInsensitive))
+    if (!importoptions->setOriginFromFile(dataFileName))
+    {
+        std::cout << "Unrecognized trace format!" << std::endl;
+        progress->close();
+        delete progress;
+        delete importThread;
+        delete importWorker;
+    }
+    else if (importoptions->origin == ImportOptions::OF_OTF)
     {
-        importoptions->origin = ImportOptions::OF_OTF;
         connect(this, SIGNAL(operate(QString)), importWorker,
                 SLOT(doImportOTF(QString)));
     }
-    else if (dataFileName.endsWith("otf2", Qt::CaseInsensitive))
+    else if (importoptions->origin == ImportOptions::OF_OTF2)
     {
-        importoptions->origin = ImportOptions::OF_OTF2;
-        importoptions->waitallMerge = false; // Not applicable
         connect(this, SIGNAL(operate(QString)), importWorker,
                 SLOT(doImportOTF2(QString)));
     }
-    else if (dataFileName.endsWith("sts", Qt::CaseInsensitive))
+    else if (importoptions->origin == ImportOptions::OF_CHARM)
     {
-        importoptions->origin = ImportOptions::OF_CHARM;
-        importoptions->waitallMerge = false; // Not applicable
-        importoptions->leapMerge = false; // Not applicable across all chare arrays -- perhaps per chare array
-        importoptions->isendCoalescing = false; // Not applicable
-        importoptions->callerMerge = false; // Done differently in charm importer
-        importoptions->advancedStepping = false; // Not for this
         visoptions->showAggregateSteps = false;
         connect(this, SIGNAL(operate(QString)), importWorker,
                 SLOT(doImportCharm(QString)));
     }
-    else
-    {
-        std::cout << "Unrecognized trace format!" << std::endl;
-        progress->close();
-        delete progress;
-        delete importThread;
-        delete importWorker;
-    }
 
     connect(importWorker, SIGNAL(switching()), this, SLOT(traceSwitch()));
     connect(importWorker, SIGNAL(done(Trace *)), this,
@@ -611,6 +669,10 @@ void MainWindow::closeTrace()
     Trace * trace = traces[activeTrace];
     traces.removeAt(activeTrace);
     ui->menuTraces->removeAction(ui->menuTraces->actions().at(activeTrace));
+
+    // Views may still be working from the trace in the background
+    for (int i = 0; i < viswidgets.size(); i++)
+        viswidgets[i]->clear();
     delete trace;
 
     int index = -1;
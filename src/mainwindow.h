@@ -67,6 +67,9 @@ public:
 public slots:
     void launchImportOptions();
     void launchVisOptions();
+    void showMemoryUsage();
+    void toggleFrameStats(bool show);
+    void exportFrameStats();
 
     // Signal relays
     void pushSteps(float start, float stop, bool jump = false);
@@ -0,0 +1,412 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "memorycensus.h"
+#include <QThread>
+#include <iostream>
+
+#include "rawtrace.h"
+#include "trace.h"
+#include "eventrecord.h"
+#include "commrecord.h"
+#include "counterrecord.h"
+#include "collectiverecord.h"
+#include "event.h"
+#include "commevent.h"
+#include "p2pevent.h"
+#include "collectiveevent.h"
+#include "message.h"
+#include "metrics.h"
+#include "rpartition.h"
+#include "gnome.h"
+#include "partitioncluster.h"
+#include "clusterentity.h"
+#include "clusterevent.h"
+#include "timeindex.h"
+#include "aggregateprofiles.h"
+#include "aggregatesteptotals.h"
+#include "stephistogram.h"
+#include "tracesummary.h"
+#include "commindex.h"
+
+bool MemoryCensus::reporting = !qgetenv("RAVEL_MEMORY").isEmpty();
+RawTrace * MemoryCensus::watched_raw = NULL;
+Trace * MemoryCensus::watched_trace = NULL;
+QThread * MemoryCensus::watched_thread = NULL;
+
+MemoryCensus::MemoryCensus()
+    : tallies(QVector<Tally>(MC_NUM_CATEGORIES))
+{
+}
+
+void MemoryCensus::add(Category category, long long objects, long long bytes)
+{
+    tallies[category].objects += objects;
+    tallies[category].bytes += bytes;
+}
+
+void MemoryCensus::countRawTrace(RawTrace * rawtrace)
+{
+    if (rawtrace->events)
+    {
+        add(MC_RAW, 0, vectorBytes(rawtrace->events));
+        for (QVector<QVector<EventRecord *> *>::Iterator event_list
+             = rawtrace->events->begin();
+             event_list != rawtrace->events->end(); ++event_list)
+        {
+            add(MC_RAW, (*event_list)->size(), vectorBytes(*event_list)
+                + (*event_list)->size() * (long long) sizeof(EventRecord));
+            for (QVector<EventRecord *>::Iterator er = (*event_list)->begin();
+                 er != (*event_list)->end(); ++er)
+            {
+                if (!(*er)->children.isEmpty())
+                    add(MC_RAW, 0, listBytes(&((*er)->children))
+                        - sizeof(QList<Event *>));
+                add(MC_RAW, 0, mapBytes((*er)->metrics)
+                    + mapBytes((*er)->ravel_info));
+            }
+        }
+    }
+
+    // Each record is in both the sender and receiver lists
+    if (rawtrace->messages)
+    {
+        add(MC_RAW, 0, vectorBytes(rawtrace->messages)
+            + vectorBytes(rawtrace->messages_r));
+        for (int i = 0; i < rawtrace->messages->size(); i++)
+        {
+            QVector<CommRecord *> * sends = rawtrace->messages->at(i);
+            add(MC_RAW, sends->size(), vectorBytes(sends)
+                + sends->size() * (long long) sizeof(CommRecord));
+            if (rawtrace->messages_r)
+                add(MC_RAW, 0, vectorBytes(rawtrace->messages_r->at(i)));
+        }
+    }
+
+    if (rawtrace->counter_records)
+    {
+        add(MC_RAW, 0, vectorBytes(rawtrace->counter_records));
+        for (QVector<QVector<CounterRecord *> *>::Iterator counter_list
+             = rawtrace->counter_records->begin();
+             counter_list != rawtrace->counter_records->end(); ++counter_list)
+        {
+            add(MC_RAW, (*counter_list)->size(), vectorBytes(*counter_list)
+                + (*counter_list)->size() * (long long) sizeof(CounterRecord));
+        }
+    }
+
+    if (rawtrace->collectiveBits)
+    {
+        add(MC_RAW, 0, vectorBytes(rawtrace->collectiveBits));
+        for (QVector<QVector<RawTrace::CollectiveBit *> *>::Iterator bits
+             = rawtrace->collectiveBits->begin();
+             bits != rawtrace->collectiveBits->end(); ++bits)
+        {
+            add(MC_RAW, (*bits)->size(), vectorBytes(*bits)
+                + (*bits)->size() * (long long) sizeof(RawTrace::CollectiveBit));
+        }
+    }
+
+    // Collective records are handed on to the Trace, so only count them
+    // here while it does not have them yet
+    if (rawtrace->collectives && (!watched_trace
+                                  || watched_trace->collectives != rawtrace->collectives))
+    {
+        add(MC_MESSAGES, rawtrace->collectives->size(),
+            mapBytes(rawtrace->collectives)
+            + rawtrace->collectives->size() * (long long) sizeof(CollectiveRecord));
+    }
+}
+
+void MemoryCensus::countTrace(Trace * trace)
+{
+    // Events, with their messages and metrics
+    add(MC_EVENTS, 0, vectorBytes(trace->events) + vectorBytes(trace->roots));
+    for (int i = 0; i < trace->events->size(); i++)
+    {
+        QVector<Event *> * event_list = trace->events->at(i);
+        add(MC_EVENTS, 0, vectorBytes(event_list)
+            + vectorBytes(trace->roots->at(i)));
+        for (QVector<Event *>::Iterator evt = event_list->begin();
+             evt != event_list->end(); ++evt)
+        {
+            long long bytes = sizeof(Event);
+            if ((*evt)->isCommEvent())
+            {
+                CommEvent * comm = static_cast<CommEvent *>(*evt);
+                if (comm->isP2P())
+                {
+                    P2PEvent * p2p = static_cast<P2PEvent *>(comm);
+                    bytes = sizeof(P2PEvent) + listBytes(p2p->subevents);
+                    add(MC_MESSAGES, 0, vectorBytes(p2p->messages));
+                    for (QVector<Message *>::Iterator msg = p2p->messages->begin();
+                         msg != p2p->messages->end(); ++msg)
+                    {
+                        if ((*msg)->sender == p2p)
+                            add(MC_MESSAGES, 1, sizeof(Message));
+                    }
+                }
+                else
+                {
+                    bytes = sizeof(CollectiveEvent);
+                }
+            }
+            add(MC_EVENTS, 1, bytes + vectorBytes((*evt)->callees));
+            countMetrics((*evt)->metrics);
+        }
+    }
+
+    if (trace->collectives)
+    {
+        add(MC_MESSAGES, trace->collectives->size(), mapBytes(trace->collectives));
+        for (QMap<unsigned long long, CollectiveRecord *>::Iterator cr
+             = trace->collectives->begin();
+             cr != trace->collectives->end(); ++cr)
+        {
+            add(MC_MESSAGES, 0, sizeof(CollectiveRecord)
+                + listBytes((*cr)->events));
+        }
+    }
+
+    // Partitions and the clustering done on them
+    add(MC_PARTITIONS, 0, listBytes(trace->partitions)
+        + listBytes(trace->dag_entries) + mapBytes(trace->dag_step_dict));
+    for (QMap<int, QSet<Partition *> *>::Iterator leap
+         = trace->dag_step_dict->begin();
+         leap != trace->dag_step_dict->end(); ++leap)
+    {
+        add(MC_PARTITIONS, 0, setBytes(leap.value()));
+    }
+    QSet<QSet<Partition *> *> groups = QSet<QSet<Partition *> *>();
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part)
+    {
+        Partition * p = *part;
+        long long bytes = sizeof(Partition) + mapBytes(p->events)
+                + setBytes(p->parents) + setBytes(p->children)
+                + setBytes(p->old_parents) + setBytes(p->old_children);
+        if (p->group && !groups.contains(p->group))
+        {
+            // Partitions being merged share one group
+            groups.insert(p->group);
+            bytes += setBytes(p->group);
+        }
+        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
+             = p->events->begin(); event_list != p->events->end(); ++event_list)
+        {
+            bytes += listBytes(event_list.value());
+        }
+        add(MC_PARTITIONS, 1, bytes);
+        countMetrics(p->metrics);
+
+        if (p->cluster_entities)
+        {
+            add(MC_CLUSTERS, p->cluster_entities->size(),
+                vectorBytes(p->cluster_entities));
+            for (QVector<ClusterEntity *>::Iterator ce
+                 = p->cluster_entities->begin();
+                 ce != p->cluster_entities->end(); ++ce)
+            {
+                add(MC_CLUSTERS, 0, sizeof(ClusterEntity)
+                    + vectorBytes((*ce)->metric_events));
+            }
+        }
+        if (p->cluster_matrix)
+            add(MC_CLUSTERS, 1, p->cluster_matrix->memoryBytes());
+        if (p->gnome)
+        {
+            add(MC_CLUSTERS, 1, sizeof(Gnome) + mapBytes(p->gnome->cluster_leaves)
+                + mapBytes(p->gnome->cluster_map));
+            if (p->gnome->cluster_root)
+                countClusterTree(p->gnome->cluster_root);
+        }
+    }
+
+    // Lookup structures kept for the views
+    if (trace->time_indices)
+    {
+        add(MC_VIS, trace->time_indices->size(), vectorBytes(trace->time_indices));
+        for (QVector<TimeIndex *>::Iterator index = trace->time_indices->begin();
+             index != trace->time_indices->end(); ++index)
+        {
+            add(MC_VIS, 0, sizeof(TimeIndex) + vectorBytes((*index)->roots)
+                + vectorBytes((*index)->max_exits));
+        }
+    }
+    if (trace->aggregate_profiles)
+    {
+        add(MC_VIS, trace->aggregate_profiles->size(),
+            vectorBytes(trace->aggregate_profiles));
+        for (QVector<AggregateProfiles *>::Iterator profiles
+             = trace->aggregate_profiles->begin();
+             profiles != trace->aggregate_profiles->end(); ++profiles)
+        {
+            add(MC_VIS, 0, sizeof(AggregateProfiles)
+                + vectorBytes(&((*profiles)->events))
+                + vectorBytes(&((*profiles)->offsets))
+                + vectorBytes(&((*profiles)->functions))
+                + vectorBytes(&((*profiles)->times))
+                - 4 * (long long) sizeof(QVector<int>));
+        }
+    }
+    if (trace->aggregate_totals)
+        add(MC_VIS, trace->aggregate_totals->size(),
+            trace->aggregate_totals->memoryBytes());
+    if (trace->step_histograms)
+    {
+        add(MC_VIS, trace->step_histograms->size(),
+            mapBytes(trace->step_histograms));
+        for (QMap<QString, StepHistogram *>::Iterator histogram
+             = trace->step_histograms->begin();
+             histogram != trace->step_histograms->end(); ++histogram)
+        {
+            add(MC_VIS, 0, histogram.value()->memoryBytes());
+        }
+    }
+    if (trace->summary)
+        add(MC_VIS, 1, trace->summary->memoryBytes());
+    if (trace->comm_index)
+        add(MC_VIS, trace->comm_index->size(),
+            trace->comm_index->memoryBytes());
+}
+
+void MemoryCensus::countMetrics(Metrics * metrics)
+{
+    if (!metrics)
+        return;
+
+    add(MC_METRICS, 1, sizeof(Metrics) + mapBytes(metrics->metrics)
+        + metrics->metrics->size() * (long long) sizeof(Metrics::MetricPair));
+}
+
+void MemoryCensus::countClusterTree(PartitionCluster * pc)
+{
+    add(MC_CLUSTERS, 1, sizeof(PartitionCluster) + listBytes(pc->children)
+        + listBytes(pc->members) + listBytes(pc->events)
+        + pc->events->size() * (long long) sizeof(ClusterEvent)
+        + vectorBytes(pc->cluster_vector));
+    for (QList<PartitionCluster *>::Iterator child = pc->children->begin();
+         child != pc->children->end(); ++child)
+    {
+        countClusterTree(*child);
+    }
+}
+
+long long MemoryCensus::totalBytes() const
+{
+    long long total = 0;
+    for (int i = 0; i < MC_NUM_CATEGORIES; i++)
+        total += tallies.at(i).bytes;
+    return total;
+}
+
+QString MemoryCensus::report() const
+{
+    QString text = "";
+    for (int i = 0; i < MC_NUM_CATEGORIES; i++)
+    {
+        text += "  " + categoryName(static_cast<Category>(i)).leftJustified(14)
+                + QString::number(tallies.at(i).objects).rightJustified(12)
+                + " objects  "
+                + formatBytes(tallies.at(i).bytes).rightJustified(10) + "\n";
+    }
+    text += "  " + QString("total").leftJustified(14)
+            + formatBytes(totalBytes()).rightJustified(32) + "\n";
+    return text;
+}
+
+QString MemoryCensus::categoryName(Category category)
+{
+    switch (category)
+    {
+    case MC_RAW:
+        return "raw records";
+    case MC_EVENTS:
+        return "events";
+    case MC_MESSAGES:
+        return "messages";
+    case MC_PARTITIONS:
+        return "partitions";
+    case MC_METRICS:
+        return "metrics";
+    case MC_CLUSTERS:
+        return "cluster data";
+    case MC_VIS:
+        return "vis caches";
+    default:
+        return "";
+    }
+}
+
+QString MemoryCensus::formatBytes(long long bytes)
+{
+    if (bytes < 1024)
+        return QString::number(bytes) + " B";
+    if (bytes < 1024LL * 1024)
+        return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+    if (bytes < 1024LL * 1024 * 1024)
+        return QString::number(bytes / 1024.0 / 1024.0, 'f', 1) + " MB";
+    return QString::number(bytes / 1024.0 / 1024.0 / 1024.0, 'f', 2) + " GB";
+}
+
+void MemoryCensus::watch(RawTrace * rawtrace)
+{
+    watched_raw = rawtrace;
+    watched_thread = QThread::currentThread();
+}
+
+void MemoryCensus::watch(Trace * trace)
+{
+    watched_trace = trace;
+    watched_thread = QThread::currentThread();
+}
+
+void MemoryCensus::unwatch(RawTrace * rawtrace)
+{
+    if (watched_raw == rawtrace)
+        watched_raw = NULL;
+}
+
+void MemoryCensus::unwatch(Trace * trace)
+{
+    if (watched_trace == trace)
+        watched_trace = NULL;
+}
+
+// Called by StageTimer as each stage finishes
+void MemoryCensus::reportStage(const char * stage, long long peak_rss)
+{
+    if (QThread::currentThread() != watched_thread)
+        return;
+
+    MemoryCensus census;
+    if (watched_raw)
+        census.countRawTrace(watched_raw);
+    if (watched_trace)
+        census.countTrace(watched_trace);
+
+    std::cout << "Memory after " << stage << " (peak RSS "
+              << formatBytes(peak_rss).toStdString().c_str() << "):" << std::endl;
+    std::cout << census.report().toStdString().c_str() << std::flush;
+}
@@ -0,0 +1,134 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef MEMORYCENSUS_H
+#define MEMORYCENSUS_H
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QMap>
+#include <QSet>
+
+class RawTrace;
+class Trace;
+class Metrics;
+class PartitionCluster;
+class QThread;
+
+// Counts the objects and estimates the bytes held by a trace, by category.
+// Bytes are the object sizes plus the container storage they own, so they
+// are lower than what the allocator actually uses but show which parts of
+// the pipeline hold the memory.
+//
+// Set RAVEL_MEMORY (or use setReporting) to print a census of the trace
+// being processed after every outermost StageTimer stage, with the stage's
+// peak RSS.
+class MemoryCensus
+{
+public:
+    MemoryCensus();
+
+    enum Category { MC_RAW, MC_EVENTS, MC_MESSAGES, MC_PARTITIONS,
+                    MC_METRICS, MC_CLUSTERS, MC_VIS, MC_NUM_CATEGORIES };
+
+    class Tally {
+    public:
+        Tally() : objects(0), bytes(0) {}
+
+        long long objects;
+        long long bytes;
+    };
+
+    void add(Category category, long long objects, long long bytes);
+    void countRawTrace(RawTrace * rawtrace);
+    void countTrace(Trace * trace);
+
+    Tally tally(Category category) const { return tallies.at(category); }
+    long long totalBytes() const;
+    QString report() const;
+
+    // Approximate storage of the Qt containers on a 64-bit build: the
+    // shared header plus the elements, and for QMap/QSet a node per element
+    template <class T>
+    static long long vectorBytes(const QVector<T> * vector)
+    {
+        if (!vector)
+            return 0;
+        return sizeof(QVector<T>) + 24 + vector->capacity() * (long long) sizeof(T);
+    }
+
+    template <class T>
+    static long long listBytes(const QList<T> * list)
+    {
+        if (!list)
+            return 0;
+        return sizeof(QList<T>) + 24 + list->size() * (long long) sizeof(void *);
+    }
+
+    template <class K, class V>
+    static long long mapBytes(const QMap<K, V> * map)
+    {
+        if (!map)
+            return 0;
+        return sizeof(QMap<K, V>) + 24
+                + map->size() * (long long) (24 + sizeof(K) + sizeof(V));
+    }
+
+    template <class T>
+    static long long setBytes(const QSet<T> * set)
+    {
+        if (!set)
+            return 0;
+        return sizeof(QSet<T>) + 24 + set->capacity() * (long long) sizeof(void *)
+                + set->size() * (long long) (16 + sizeof(T));
+    }
+
+    static QString categoryName(Category category);
+    static QString formatBytes(long long bytes);
+
+    static void setReporting(bool report) { reporting = report; }
+    static bool isReporting() { return reporting; }
+
+    // The traces currently being built, set by their constructors. Stages
+    // are only reported on the thread building them.
+    static void watch(RawTrace * rawtrace);
+    static void watch(Trace * trace);
+    static void unwatch(RawTrace * rawtrace);
+    static void unwatch(Trace * trace);
+    static void reportStage(const char * stage, long long peak_rss);
+
+private:
+    void countMetrics(Metrics * metrics);
+    void countClusterTree(PartitionCluster * pc);
+
+    QVector<Tally> tallies;
+
+    static bool reporting;
+    static RawTrace * watched_raw;
+    static Trace * watched_trace;
+    static QThread * watched_thread;
+};
+
+#endif // MEMORYCENSUS_H
@@ -25,7 +25,6 @@
 #include "message.h"
 #include "commevent.h"
 #include "p2pevent.h"
-#include "viswidget.h"
 
 Message::Message(unsigned long long send, unsigned long long recv, int group)
     : CommBundle(), sender(NULL), receiver(NULL),
@@ -63,8 +62,3 @@ CommEvent * Message::getDesignee()
 {
     return sender;
 }
-
-void Message::draw(QPainter * painter, CommDrawInterface *vis)
-{
-    vis->drawMessage(painter, this);
-}
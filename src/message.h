@@ -52,7 +52,7 @@ public:
     bool operator>=(const Message &);
     bool operator==(const Message &);
 
-    void draw(QPainter * painter, CommDrawInterface * vis);
+    bool isMessage() { return true; }
 };
 
 #endif // MESSAGE_H
@@ -31,6 +31,7 @@
 #include "function.h"
 #include "rpartition.h"
 #include "primaryentitygroup.h"
+#include "stagetimer.h"
 #include <climits>
 #include <cmath>
 #include <iostream>
@@ -56,6 +57,7 @@ OTF2Exporter::~OTF2Exporter()
 
 void OTF2Exporter::exportTrace(QString path, QString filename)
 {
+    StageTimer stageTimer("exportTrace");
     // Setup the IDs for partition identification
     for (int i = 0; i < trace->partitions->size(); i++)
     {
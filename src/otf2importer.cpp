@@ -38,6 +38,7 @@
 #include "entity.h"
 #include "importoptions.h"
 #include "primaryentitygroup.h"
+#include "stagetimer.h"
 
 OTF2Importer::OTF2Importer()
     : from_saved_version(""),
@@ -251,6 +252,7 @@ OTF2Importer::~OTF2Importer()
 
 RawTrace * OTF2Importer::importOTF2(const char* otf_file, bool _enforceMessageSize)
 {
+    StageTimer stageTimer("importOTF2");
     enforceMessageSize = _enforceMessageSize;
     entercount = 0;
     exitcount = 0;
@@ -593,9 +595,16 @@ void OTF2Importer::processDefinitions()
         {
             phaseRef = attr.key();
         }
-        else if (name.startsWith("option_")) // Import Options
+        else if (name.startsWith("option_") || name.startsWith("option."))
         {
-            options->setOption(name, stringMap->value(attribute->description));
+            // Import Options; older saves spelled a few with a dot
+            QString error;
+            name.replace(6, 1, '_');
+            if (!options->setOption(name,
+                                    stringMap->value(attribute->description),
+                                    &error))
+                std::cout << "Ignoring saved " << error.toStdString().c_str()
+                          << std::endl;
         }
         else
         {
@@ -54,6 +54,8 @@
 #include "collectiveevent.h"
 #include "primaryentitygroup.h"
 #include "metrics.h"
+#include "stagetimer.h"
+#include "selfprofiler.h"
 
 
 const QString OTFConverter::collectives_string
@@ -125,6 +127,7 @@ Trace * OTFConverter::importCharm(RawTrace * rt, ImportOptions *_options)
 
 void OTFConverter::convert()
 {
+    SelfProfiler::Span span("convert");
     // Time the rest of this
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
@@ -233,6 +236,7 @@ void OTFConverter::makeSingletonPartition(CommEvent * evt)
 // link them into a call tree
 void OTFConverter::matchEvents()
 {
+    StageTimer stageTimer("matchEvents");
     // We can handle each set of events separately
     QStack<EventRecord *> * stack = new QStack<EventRecord *>();
 
@@ -289,6 +293,7 @@ void OTFConverter::matchEvents()
     }
 
     int spartcounter = 0, rpartcounter = 0, cpartcounter = 0;
+    long long events_matched = 0;
     for (int i = 0; i < rawtrace->events->size(); i++)
     {
         QVector<EventRecord *> * event_list = rawtrace->events->at(i);
@@ -300,8 +305,10 @@ void OTFConverter::matchEvents()
         {
             ++currentPortion;
             emit(matchingUpdate(1 + currentPortion, "Constructing events..."));
+            SelfProfiler::counter("events matched", events_matched);
         }
         ++currentIter;
+        events_matched += event_list->size();
 
         QVector<CounterRecord *> * counters = rawtrace->counter_records->at(i);
         lastcounters->clear();
@@ -797,6 +804,8 @@ void OTFConverter::matchEvents()
         delete *ac;
     }
     delete allcomms;
+    SelfProfiler::counter("events matched", events_matched);
+    SelfProfiler::counter("partitions", trace->partitions->size());
 }
 
 // We only do this with comm events right now, so we know we won't have nesting
@@ -977,6 +986,7 @@ void OTFConverter::mergeContiguous(QList<QList<Partition * > *> * groups)
 // link them into a call tree - from saved Ravel OTF2 to re-read faster
 void OTFConverter::matchEventsSaved()
 {
+    StageTimer stageTimer("matchEventsSaved");
     // We can handle each set of events separately
     QStack<EventRecord *> * stack = new QStack<EventRecord *>();
 
@@ -1007,6 +1017,7 @@ void OTFConverter::matchEventsSaved()
     // If isend index, we put this at the depth of the isend. Then we will
     // collect subevents until the depth matches this value.
     int coalesceflag;
+    long long events_matched = 0;
     bool coalesced_event;
 
     for (int i = 0; i < rawtrace->events->size(); i++)
@@ -1019,8 +1030,10 @@ void OTFConverter::matchEventsSaved()
         {
             ++currentPortion;
             emit(matchingUpdate(1 + currentPortion, "Constructing events..."));
+            SelfProfiler::counter("events matched", events_matched);
         }
         ++currentIter;
+        events_matched += event_list->size();
 
         QVector<RawTrace::CollectiveBit *> * collective_bits = rawtrace->collectiveBits->at(i);
         int collective_index = 0;
@@ -1268,6 +1281,7 @@ void OTFConverter::matchEventsSaved()
         sendgroup->clear();
         delete isends;
     }
+    SelfProfiler::counter("events matched", events_matched);
     delete stack;
     delete sendgroup;
 }
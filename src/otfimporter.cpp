@@ -39,6 +39,7 @@
 #include "entitygroup.h"
 #include "otfcollective.h"
 #include "primaryentitygroup.h"
+#include "stagetimer.h"
 #include "otf.h"
 
 OTFImporter::OTFImporter()
@@ -105,6 +106,7 @@ OTFImporter::~OTFImporter()
 
 RawTrace * OTFImporter::importOTF(const char* otf_file, bool _enforceMessageSize)
 {
+    StageTimer stageTimer("importOTF");
     enforceMessageSize = _enforceMessageSize;
     entercount = 0;
     exitcount = 0;
@@ -27,10 +27,11 @@
 #include <cfloat>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include "trace.h"
-#include "rpartition.h"
-#include "event.h"
-#include "commevent.h"
+#include "stephistogram.h"
+#include "tracesummary.h"
+#include "memorycensus.h"
 
 OverviewVis::OverviewVis(QWidget *parent, VisOptions * _options)
     : VisWidget(parent = parent, _options = _options)
@@ -169,6 +170,13 @@ void OverviewVis::mouseReleaseEvent(QMouseEvent * event) {
     emit stepsChanged(startStep, stopStep, true);
 }
 
+void OverviewVis::countMemory(MemoryCensus * census)
+{
+    VisWidget::countMemory(census);
+    census->add(MemoryCensus::MC_VIS, 0,
+                MemoryCensus::vectorBytes(&heights) - sizeof(heights)
+                + MemoryCensus::vectorBytes(&stepPositions) - sizeof(stepPositions));
+}
 
 // Upon setting the trace, we determine the min and max that don't change
 // We also set the initial cursorStep
@@ -177,8 +185,8 @@ void OverviewVis::setTrace(Trace * t)
     VisWidget::setTrace(t);
     cacheMetric = options->metric;
     maxStep = trace->global_max_step;
-    minTime = ULLONG_MAX;
-    maxTime = 0;
+    minTime = trace->summary->time.start;
+    maxTime = trace->summary->time.stop;
     //unsigned long long init_time = ULLONG_MAX;
     //unsigned long long finalize_time = 0;
     // Maybe we should have this be by step instead? We'll see. Right now it
@@ -232,9 +240,8 @@ void OverviewVis::setTrace(Trace * t)
 }
 
 
-// Calculate what the heights should be for the metrics
-// TODO: Save this stuff per step somewhere and have that be accessed as needed
-// rather than iterating through everything
+// Calculate what the heights should be for the metrics. The per step sums
+// are kept on the trace, so this only rebins them to the current width.
 void OverviewVis::processVis()
 {
     // Don't do anything if there's no trace available
@@ -244,69 +251,16 @@ void OverviewVis::processVis()
     heights = QVector<float>(width, 0);
     int stepspan = maxStep + 1;
     stepWidth = width / 1.0 / stepspan;
-    int start_int, stop_int;
-    QString metric = options->metric;
-    //stepPositions = QVector<std::pair<int, int> >(maxStep+1, std::pair<int, int>(width + 1, -1));
-    for (QList<Partition *>::Iterator part = trace->partitions->begin();
-         part != trace->partitions->end(); ++part)
+    StepHistogram * histogram = trace->getStepHistogram(options->metric);
+
+    // Step s starts at pixel (width - 1) * s / stepspan
+    double stepsPerPixel = stepspan / 1.0 / std::max(width - 1, 1);
+    for (int i = 0; i < width; i++)
     {
-        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
-             = (*part)->events->begin();
-             event_list != (*part)->events->end(); ++event_list)
-        {
-            // For each event, we figure out which steps it spans and then we
-            // accumulate height over those steps based on the event's metric
-            // value
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                // start and stop are the cursor positions
-                float start = (width - 1) * (((*evt)->step) / 1.0 / stepspan);
-                float stop = start + stepWidth;
-                start_int = static_cast<int>(start);
-                stop_int = static_cast<int>(stop);
-
-                if ((*evt)->hasMetric(metric) && (*evt)->getMetric(metric)> 0)
-                {
-                    heights[start_int] += (*evt)->getMetric(metric)
-                                          * (start - start_int);
-                    if (stop_int != start_int) {
-                        heights[stop_int] += (*evt)->getMetric(metric)
-                                             * (stop - stop_int);
-                    }
-                    for (int i = start_int + 1; i < stop_int; i++)
-                    {
-                        heights[i] += (*evt)->getMetric(metric);
-                    }
-
-                }
-
-                // again for the aggregate
-                if ((*evt)->step == 0)
-                    continue;
-                start = (width - 1) * (((*evt)->step - 1) / 1.0 / stepspan);
-                stop = start + stepWidth;
-                start_int = static_cast<int>(start);
-                stop_int = static_cast<int>(stop); // start_int + i_step_width;
-
-                if ((*evt)->hasMetric(metric)
-                        && (*evt)->getMetric(metric, true)> 0)
-                {
-                    heights[start_int] += (*evt)->getMetric(metric, true)
-                                          * (start - start_int);
-                    if (stop_int != start_int)
-                    {
-                        heights[stop_int] += (*evt)->getMetric(metric, true)
-                                             * (stop - stop_int);
-                    }
-                    for (int i = start_int + 1; i < stop_int; i++)
-                    {
-                        heights[i] += (*evt)->getMetric(metric, true);
-                    }
-                }
-            }
-        }
+        heights[i] = histogram->total(i * stepsPerPixel,
+                                      (i + 1) * stepsPerPixel);
     }
+
     float minMetric = FLT_MAX;
     float maxMetric = 0;
     for (int i = 0; i < width; i++) {
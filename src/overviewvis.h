@@ -42,6 +42,7 @@ public:
     OverviewVis(QWidget *parent = 0, VisOptions *_options = new VisOptions());
     void setTrace(Trace * t);
     void processVis();
+    void countMemory(MemoryCensus * census);
     void resizeEvent(QResizeEvent * event);
     void mousePressEvent(QMouseEvent * event);
     void mouseReleaseEvent(QMouseEvent * event);
@@ -27,7 +27,6 @@
 #include "message.h"
 #include "clusterevent.h"
 #include "metrics.h"
-#include "commdrawinterface.h"
 #include <iostream>
 
 P2PEvent::P2PEvent(unsigned long long _enter, unsigned long long _exit,
@@ -283,24 +282,30 @@ void P2PEvent::initialize_basic_strides(QSet<CollectiveRecord *> * collectives)
 void P2PEvent::update_basic_strides()
 {
     if (comm_prev && comm_prev->partition == partition)
-        last_stride = comm_prev;
+        stride_info->last_stride = comm_prev;
 
-    // Set last_stride based on entity
-    while (last_stride && last_stride->stride < 0)
+    // Set last_stride based on entity. Stride info only exists for events
+    // in this partition, so we stop as soon as we leave it.
+    CommEvent * last_stride = stride_info->last_stride;
+    while (last_stride && last_stride->partition == partition
+           && last_stride->stride_info->stride < 0)
     {
         last_stride = last_stride->comm_prev;
     }
     if (last_stride && last_stride->partition != partition)
         last_stride = NULL;
+    stride_info->last_stride = last_stride;
 
-    next_stride = comm_next;
+    CommEvent * next_stride = comm_next;
     // Set next_stride based on entity
-    while (next_stride && next_stride->stride < 0)
+    while (next_stride && next_stride->partition == partition
+           && next_stride->stride_info->stride < 0)
     {
         next_stride = next_stride->comm_next;
     }
     if (next_stride && next_stride->partition != partition)
         next_stride = NULL;
+    stride_info->next_stride = next_stride;
 }
 
 void P2PEvent::initialize_strides(QList<CommEvent *> * stride_events,
@@ -324,6 +329,7 @@ void P2PEvent::initialize_strides(QList<CommEvent *> * stride_events,
     else // Setup receives
     {
         recv_events->append(this);
+        CommEvent * last_stride = stride_info->last_stride;
         if (comm_prev && comm_prev->partition == partition)
             last_stride = comm_prev;
         // Set last_stride based on entity
@@ -333,8 +339,9 @@ void P2PEvent::initialize_strides(QList<CommEvent *> * stride_events,
         }
         if (last_stride && last_stride->partition != partition)
             last_stride = NULL;
+        stride_info->last_stride = last_stride;
 
-        next_stride = comm_next;
+        CommEvent * next_stride = comm_next;
         // Set next_stride based on entity
         while (next_stride && next_stride->isReceive())
         {
@@ -342,6 +349,7 @@ void P2PEvent::initialize_strides(QList<CommEvent *> * stride_events,
         }
         if (next_stride && next_stride->partition != partition)
             next_stride = NULL;
+        stride_info->next_stride = next_stride;
     }
 }
 
@@ -358,8 +366,8 @@ void P2PEvent::set_stride_relationships(CommEvent * base)
 
     if (entity_next && entity_next->partition == partition)
     {
-        stride_children->insert(entity_next);
-        entity_next->stride_parents->insert(this);
+        stride_info->stride_children.insert(entity_next);
+        entity_next->stride_info->stride_parents.insert(this);
     }
 }
 
@@ -374,10 +382,11 @@ void P2PEvent::update_strides()
     for (QVector<Message *>::Iterator msg = messages->begin();
          msg != messages->end(); ++msg)
     {
-        if (!last_stride
-                || (*msg)->sender->stride > last_stride->stride)
+        if (!stride_info->last_stride
+                || (*msg)->sender->stride_info->stride
+                   > stride_info->last_stride->stride_info->stride)
         {
-            last_stride = (*msg)->sender;
+            stride_info->last_stride = (*msg)->sender;
         }
     }
 }
@@ -387,10 +396,12 @@ void P2PEvent::set_reorder_strides(QMap<unsigned long, QList<CommEvent *> *> *st
 {
     Q_UNUSED(last);
     offset = 1;
+    int stride = stride_info->stride;
     for (QVector<Message *>::Iterator msg = messages->begin();
          msg != messages->end(); ++msg)
     {
-        (*msg)->receiver->stride = stride + offset;
+        StrideInfo * recv_info = (*msg)->receiver->stride_info;
+        recv_info->stride = stride + offset;
 
         if (!stride_map->contains(stride + offset))
         {
@@ -402,10 +413,10 @@ void P2PEvent::set_reorder_strides(QMap<unsigned long, QList<CommEvent *> *> *st
         stride_map->value(stride + offset)->append((*msg)->receiver);
 
         // Last stride to self for ordering
-        (*msg)->receiver->last_stride = (*msg)->receiver; //this;
+        recv_info->last_stride = (*msg)->receiver; //this;
 
         // next stride for tie-breaking so we know what entity it is
-        (*msg)->receiver->next_stride = this;
+        recv_info->next_stride = this;
     }
 }
 
@@ -491,11 +502,6 @@ void P2PEvent::addToClusterEvent(ClusterEvent * ce, QString metric,
                   commtype, aggthreshhold);
 }
 
-void P2PEvent::track_delay(QPainter *painter, CommDrawInterface *vis)
-{
-    vis->drawDelayTracking(painter, this);
-}
-
 // What is the cause of the delay, this sender, or the pe_prev
 // that is the input parameter?
 CommEvent * P2PEvent::compare_to_sender(CommEvent * prev)
@@ -27,9 +27,6 @@
 
 #include "commevent.h"
 
-class QPainter;
-class CommDrawInterface;
-
 class P2PEvent : public CommEvent
 {
 public:
@@ -64,7 +61,6 @@ public:
                                        bool aggregates);
     void writeToOTF2(OTF2_EvtWriter * writer, QMap<QString, int> * attributeMap);
 
-    void track_delay(QPainter *painter, CommDrawInterface * vis);
     CommEvent * compare_to_sender(CommEvent * prev);
 
     void addComms(QSet<CommBundle *> * bundleset);
@@ -0,0 +1,185 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "perfcounters.h"
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+static int openCounter(unsigned int type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // This thread, any CPU, no group
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+int PerfCounters::available = -1;
+QString PerfCounters::reason = QString();
+
+PerfCounters::PerfCounters()
+{
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    {
+        fds[i] = -1;
+        values[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+bool PerfCounters::start()
+{
+    close();
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+        values[i] = -1;
+    if (!isAvailable())
+        return false;
+
+#ifdef Q_OS_LINUX
+    fds[PC_CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[PC_INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE,
+                                       PERF_COUNT_HW_INSTRUCTIONS);
+    fds[PC_LLC_MISSES] = openCounter(PERF_TYPE_HW_CACHE,
+                                     PERF_COUNT_HW_CACHE_LL
+                                     | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                     | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    if (fds[PC_LLC_MISSES] < 0) // Generic cache misses are usually the LLC
+        fds[PC_LLC_MISSES] = openCounter(PERF_TYPE_HARDWARE,
+                                         PERF_COUNT_HW_CACHE_MISSES);
+    fds[PC_BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE,
+                                        PERF_COUNT_HW_BRANCH_MISSES);
+
+    bool opened = false;
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    {
+        if (fds[i] < 0)
+            continue;
+        ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        opened = true;
+    }
+    return opened;
+#else
+    return false;
+#endif
+}
+
+void PerfCounters::stop()
+{
+#ifdef Q_OS_LINUX
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    {
+        if (fds[i] < 0)
+            continue;
+        ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        // value, time enabled, time running
+        unsigned long long data[3];
+        if (read(fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+            continue;
+        if (data[2] < data[1])
+            values[i] = (long long) (data[0] * ((double) data[1] / data[2]));
+        else
+            values[i] = data[0];
+    }
+#endif
+    close();
+}
+
+void PerfCounters::close()
+{
+#ifdef Q_OS_LINUX
+    for (int i = 0; i < PC_NUM_COUNTERS; i++)
+    {
+        if (fds[i] >= 0)
+            ::close(fds[i]);
+        fds[i] = -1;
+    }
+#endif
+}
+
+QString PerfCounters::counterName(Counter counter)
+{
+    switch (counter)
+    {
+    case PC_CYCLES:
+        return "cycles";
+    case PC_INSTRUCTIONS:
+        return "instructions";
+    case PC_LLC_MISSES:
+        return "llc_misses";
+    case PC_BRANCH_MISSES:
+        return "branch_misses";
+    default:
+        return "";
+    }
+}
+
+bool PerfCounters::isAvailable()
+{
+    if (available >= 0)
+        return available;
+
+#ifdef Q_OS_LINUX
+    int fd = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    if (fd < 0)
+    {
+        reason = QString("perf_event_open failed: ") + strerror(errno);
+        if (errno == EACCES || errno == EPERM)
+            reason += " (see /proc/sys/kernel/perf_event_paranoid)";
+        else if (errno == ENOENT || errno == EOPNOTSUPP)
+            reason += " (no hardware counters, e.g. in a virtual machine)";
+        available = 0;
+    }
+    else
+    {
+        ::close(fd);
+        available = 1;
+    }
+#else
+    reason = "hardware counters need Linux perf_event_open";
+    available = 0;
+#endif
+    return available;
+}
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QString>
+
+// Hardware performance counters for the calling thread, read with Linux
+// perf_event_open. Each counter is opened on its own so a machine missing
+// one (e.g. cache misses in a VM) still reports the others, and values are
+// scaled when the kernel had to multiplex them. Work done on other threads,
+// such as QtConcurrent workers, is not counted.
+//
+// Where counters cannot be opened (other platforms, perf_event_paranoid,
+// containers) start returns false and every value is -1.
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    enum Counter { PC_CYCLES, PC_INSTRUCTIONS, PC_LLC_MISSES,
+                   PC_BRANCH_MISSES, PC_NUM_COUNTERS };
+
+    bool start();
+    void stop();
+    long long value(Counter counter) const { return values[counter]; }
+
+    static QString counterName(Counter counter);
+
+    // Whether any counter can be opened, checked once
+    static bool isAvailable();
+    static QString unavailableReason() { return reason; }
+
+private:
+    void close();
+
+    int fds[PC_NUM_COUNTERS];
+    long long values[PC_NUM_COUNTERS];
+
+    static int available; // -1 until checked
+    static QString reason;
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,155 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "pixellines.h"
+#include <QPainter>
+#include <QPen>
+#include <QLineF>
+#include <algorithm>
+#include <cmath>
+
+static quint64 pixelKey(qreal coordinate)
+{
+    long long pixel = static_cast<long long>(floor(coordinate + 0.5));
+    pixel = std::max(-32768LL, std::min(32767LL, pixel));
+    return static_cast<quint64>(pixel + 32768);
+}
+
+static qreal pixelValue(quint64 key)
+{
+    return static_cast<long long>(key & 0xffff) - 32768;
+}
+
+bool PixelLines::Line::operator<(const Line &other) const
+{
+    if (color != other.color)
+        return color < other.color;
+    if (width != other.width)
+        return width < other.width;
+    return endpoints < other.endpoints;
+}
+
+PixelLines::PixelLines()
+    : lines(QVector<Line>()),
+      clip(QRectF())
+{
+}
+
+// Liang-Barsky: the part of the segment inside the clip rectangle, false if
+// there is none
+bool PixelLines::clipLine(QPointF &p1, QPointF &p2) const
+{
+    qreal dx = p2.x() - p1.x();
+    qreal dy = p2.y() - p1.y();
+    qreal p[4] = { -dx, dx, -dy, dy };
+    qreal q[4] = { p1.x() - clip.left(), clip.right() - p1.x(),
+                   p1.y() - clip.top(), clip.bottom() - p1.y() };
+    qreal t0 = 0, t1 = 1;
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+                return false;
+            continue;
+        }
+        qreal t = q[i] / p[i];
+        if (p[i] < 0)
+            t0 = std::max(t0, t);
+        else
+            t1 = std::min(t1, t);
+        if (t0 > t1)
+            return false;
+    }
+
+    QPointF start = p1;
+    p1 = QPointF(start.x() + t0 * dx, start.y() + t0 * dy);
+    p2 = QPointF(start.x() + t1 * dx, start.y() + t1 * dy);
+    return true;
+}
+
+void PixelLines::add(const QPointF &p1, const QPointF &p2,
+                     const QColor &color, qreal width)
+{
+    QPointF a = p1, b = p2;
+    if (!clip.isNull() && !clipLine(a, b))
+        return;
+
+    Line line;
+    line.endpoints = (pixelKey(a.x()) << 48) | (pixelKey(a.y()) << 32)
+                     | (pixelKey(b.x()) << 16) | pixelKey(b.y());
+    line.color = color.rgba();
+    line.width = width;
+    lines.append(line);
+}
+
+// Sorting brings equal lines together. Each distinct line then gets the
+// width for its count, and sorting again groups them by pen so that each
+// pen is a single drawLines call.
+void PixelLines::draw(QPainter * painter)
+{
+    if (lines.isEmpty())
+        return;
+
+    std::sort(lines.begin(), lines.end());
+    QVector<Line> merged;
+    int i = 0;
+    while (i < lines.size())
+    {
+        int count = 1;
+        while (i + count < lines.size()
+               && lines.at(i + count).samePen(lines.at(i))
+               && lines.at(i + count).endpoints == lines.at(i).endpoints)
+        {
+            count++;
+        }
+
+        Line line = lines.at(i);
+        line.width = std::max<float>(line.width, 1)
+                     * std::min<float>(1 + log2(count) / 2, max_width_factor);
+        merged.append(line);
+        i += count;
+    }
+    std::sort(merged.begin(), merged.end());
+
+    painter->save();
+    QVector<QLineF> batch;
+    for (int first = 0; first < merged.size(); first += batch.size())
+    {
+        const Line &pen = merged.at(first);
+        batch.resize(0);
+        for (int j = first; j < merged.size() && merged.at(j).samePen(pen); j++)
+        {
+            quint64 endpoints = merged.at(j).endpoints;
+            batch.append(QLineF(pixelValue(endpoints >> 48),
+                                pixelValue(endpoints >> 32),
+                                pixelValue(endpoints >> 16),
+                                pixelValue(endpoints)));
+        }
+        painter->setPen(QPen(QColor::fromRgba(pen.color), pen.width,
+                             Qt::SolidLine));
+        painter->drawLines(batch);
+    }
+    painter->restore();
+}
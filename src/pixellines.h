@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef PIXELLINES_H
+#define PIXELLINES_H
+
+#include <QVector>
+#include <QColor>
+#include <QPointF>
+#include <QRectF>
+
+class QPainter;
+
+// Lines collected by their endpoints rounded to pixels and by pen, so that
+// many lines landing on the same pixels are drawn once. A merged line is
+// drawn wider the more lines it stands for.
+class PixelLines
+{
+public:
+    PixelLines();
+
+    void clear() { lines.resize(0); }
+    // Lines are cut to this rectangle before rounding, so that endpoints far
+    // outside it fit the 16 bit keys without changing the slope
+    void setClip(const QRectF &rect) { clip = rect; }
+    void add(const QPointF &p1, const QPointF &p2, const QColor &color,
+             qreal width);
+    void draw(QPainter * painter);
+    int size() const { return lines.size(); }
+
+    static const int max_width_factor = 4;
+
+private:
+    bool clipLine(QPointF &p1, QPointF &p2) const;
+
+    class Line {
+    public:
+        bool operator<(const Line &other) const;
+        bool samePen(const Line &other) const
+            { return color == other.color && width == other.width; }
+
+        quint64 endpoints; // x1, y1, x2, y2 as 16 bit offsets
+        QRgb color;
+        float width;
+    };
+
+    QVector<Line> lines;
+    QRectF clip;
+};
+
+#endif // PIXELLINES_H
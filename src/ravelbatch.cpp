@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+/* Ravel batch processing */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QFileInfo>
+#include <QDir>
+#include <QElapsedTimer>
+#include <iostream>
+
+#include "trace.h"
+#include "importoptions.h"
+#include "importfunctor.h"
+#include "otf2exporter.h"
+#include "selfprofiler.h"
+#include "memorycensus.h"
+#include "ravelutils.h"
+
+// Process a trace without a display: import it, extract structure and
+// clustering with the given options, then save the result so the GUI can
+// open it without reprocessing.
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ravel-batch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Process a trace for later viewing in Ravel.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "Trace to process (.otf2, .otf or .sts).");
+
+    QCommandLineOption settingsOption(QStringList() << "s" << "settings",
+                                      "Read import options from the [Import] "
+                                      "group of an ini file.", "file");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Name of the saved OTF2 trace.", "file");
+    QCommandLineOption clusterOption(QStringList() << "c" << "cluster",
+                                     "Cluster entities.");
+    QCommandLineOption seedOption("seed", "Random seed for clustering.",
+                                  "seed");
+    QCommandLineOption setOption("option",
+                                 "Set an import option by its saved name, e.g. "
+                                 "option_leapMerge=false. Booleans take true, "
+                                 "false, 1 or 0; a bare name means true. "
+                                 "May be repeated.", "name=value");
+    QCommandLineOption noSaveOption("no-save", "Process only, do not save.");
+    QCommandLineOption profileOption("profile",
+                                     "Write a Chrome trace-event profile of "
+                                     "the processing. Overrides RAVEL_PROFILE.",
+                                     "file");
+    QCommandLineOption memoryOption("memory",
+                                    "Print the memory held by each part of the "
+                                    "trace after each top-level processing stage.");
+    parser.addOption(settingsOption);
+    parser.addOption(outputOption);
+    parser.addOption(clusterOption);
+    parser.addOption(seedOption);
+    parser.addOption(setOption);
+    parser.addOption(profileOption);
+    parser.addOption(memoryOption);
+    parser.addOption(noSaveOption);
+    parser.process(app);
+
+    if (parser.isSet(profileOption))
+        SelfProfiler::start(parser.value(profileOption));
+    else
+        SelfProfiler::startFromEnvironment();
+    if (parser.isSet(memoryOption))
+        MemoryCensus::setReporting(true);
+
+    QStringList args = parser.positionalArguments();
+    if (args.size() != 1)
+        parser.showHelp(1);
+    QString dataFileName = QFileInfo(args.at(0)).absoluteFilePath();
+
+    ImportOptions * options = new ImportOptions();
+    if (parser.isSet(settingsOption))
+    {
+        QSettings settings(parser.value(settingsOption), QSettings::IniFormat);
+        options->readSettings(&settings);
+    }
+    if (parser.isSet(clusterOption))
+        options->cluster = true;
+    if (parser.isSet(seedOption))
+    {
+        options->seedClusters = true;
+        options->clusterSeed = parser.value(seedOption).toLong();
+    }
+    QString optionError;
+    if (!options->setOptions(parser.values(setOption), &optionError))
+    {
+        std::cout << optionError.toStdString().c_str() << std::endl;
+        delete options;
+        return 1;
+    }
+
+    // Same format handling as opening a trace in the GUI
+    if (!options->setOriginFromFile(dataFileName))
+    {
+        std::cout << "Unrecognized trace format!" << std::endl;
+        delete options;
+        return 1;
+    }
+
+    QElapsedTimer batchTimer;
+    qint64 batchElapsed;
+
+    batchTimer.start();
+
+    ImportFunctor * importer = new ImportFunctor(options);
+    if (options->origin == ImportOptions::OF_OTF)
+        importer->doImportOTF(dataFileName);
+    else if (options->origin == ImportOptions::OF_OTF2)
+        importer->doImportOTF2(dataFileName);
+    else
+        importer->doImportCharm(dataFileName);
+    Trace * trace = importer->getTrace();
+    delete importer;
+
+    if (!trace)
+    {
+        std::cout << "Unable to process " << dataFileName.toStdString().c_str()
+                  << std::endl;
+        delete options;
+        return 1;
+    }
+
+    batchElapsed = batchTimer.nsecsElapsed();
+    RavelUtils::gu_printTime(batchElapsed, "Batch Import + Processing: ");
+
+    int ret = 0;
+    if (parser.isSet(noSaveOption))
+    {
+        // Nothing to write
+    }
+    else if (trace->options.origin == ImportOptions::OF_CHARM)
+    {
+        std::cout << "Exporting to OTF2 not currently supported for Charm++ traces."
+                  << std::endl;
+        ret = 1;
+    }
+    else
+    {
+        QFileInfo traceInfo = QFileInfo(dataFileName);
+        QFileInfo saveFile = QFileInfo(traceInfo.absoluteDir(),
+                                       traceInfo.baseName() + ".save");
+        if (parser.isSet(outputOption))
+            saveFile = QFileInfo(parser.value(outputOption));
+
+        std::cout << "Exporting " << saveFile.absoluteFilePath().toStdString().c_str()
+                  << std::endl;
+        batchTimer.restart();
+        OTF2Exporter * exporter = new OTF2Exporter(trace);
+        exporter->exportTrace(saveFile.absolutePath(), saveFile.fileName());
+        delete exporter;
+
+        batchElapsed = batchTimer.nsecsElapsed();
+        RavelUtils::gu_printTime(batchElapsed, "Batch Export: ");
+    }
+
+    delete trace;
+    delete options;
+    return ret;
+}
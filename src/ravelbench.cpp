@@ -0,0 +1,378 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+/* Ravel pipeline benchmark */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QFileInfo>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <iostream>
+
+#include "trace.h"
+#include "importoptions.h"
+#include "importfunctor.h"
+#include "otf2exporter.h"
+#include "selfprofiler.h"
+#include "tracegenerator.h"
+#include "stagetimer.h"
+#include "perfcounters.h"
+#include "clustermatrix.h"
+
+// Timings of one stage over all measured repetitions
+class StageStats
+{
+public:
+    StageStats() : nanos(QList<qint64>()), calls(0), peak_rss(0),
+        counters(QVector<QList<qint64> >(PerfCounters::PC_NUM_COUNTERS)) {}
+
+    QList<qint64> nanos;
+    int calls;
+    long long peak_rss;
+    QVector<QList<qint64> > counters; // Only the runs that counted
+};
+
+// Import and process the trace, then save it, as ravel-batch would. Every
+// stage reports to the StageTimer records. Returns the number of events.
+static long long runPipeline(ImportOptions * options, QString dataFileName,
+                             QString exportPath)
+{
+    Trace * trace = NULL;
+    {
+        StageTimer stageTimer("pipeline");
+        ImportFunctor * importer = new ImportFunctor(options);
+        if (options->origin == ImportOptions::OF_OTF)
+            importer->doImportOTF(dataFileName);
+        else if (options->origin == ImportOptions::OF_OTF2)
+            importer->doImportOTF2(dataFileName);
+        else
+            importer->doImportCharm(dataFileName);
+        trace = importer->getTrace();
+        delete importer;
+    }
+    if (!trace)
+        return -1;
+
+    long long num_events = 0;
+    for (QVector<QVector<Event *> *>::Iterator events = trace->events->begin();
+         events != trace->events->end(); ++events)
+    {
+        num_events += (*events)->size();
+    }
+
+    if (trace->options.origin != ImportOptions::OF_CHARM)
+    {
+        OTF2Exporter * exporter = new OTF2Exporter(trace);
+        exporter->exportTrace(exportPath, "bench");
+        delete exporter;
+    }
+
+    delete trace;
+    return num_events;
+}
+
+static qint64 median(QList<qint64> values)
+{
+    qSort(values);
+    int mid = values.size() / 2;
+    if (values.size() % 2)
+        return values.at(mid);
+    return (values.at(mid - 1) + values.at(mid)) / 2;
+}
+
+// Run every stage of the pipeline repeatedly and report the timings, peak
+// memory and throughput per stage as JSON.
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ravel-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark the Ravel processing pipeline.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "Trace to process (.otf2, .otf or "
+                                 ".sts), unless --generate is given.", "[trace]");
+
+    QCommandLineOption generateOption(QStringList() << "g" << "generate",
+                                      "Benchmark a generated OTF2 trace of the "
+                                      "given size, e.g. 1024x100.",
+                                      "ranksxiterations");
+    QCommandLineOption patternOption(QStringList() << "p" << "pattern",
+                                     "Pattern of the generated trace.",
+                                     "pattern", "halo");
+    QCommandLineOption repeatOption(QStringList() << "r" << "repetitions",
+                                    "Measured runs.", "count", "5");
+    QCommandLineOption warmupOption(QStringList() << "w" << "warmup",
+                                    "Unmeasured runs first.", "count", "1");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "JSON report to write.", "file",
+                                    "ravel-bench.json");
+    QCommandLineOption settingsOption(QStringList() << "s" << "settings",
+                                      "Read import options from the [Import] "
+                                      "group of an ini file.", "file");
+    QCommandLineOption clusterOption(QStringList() << "c" << "cluster",
+                                     "Cluster entities.");
+    QCommandLineOption setOption("option",
+                                 "Set an import option by its saved name. "
+                                 "May be repeated.", "name=value");
+    QCommandLineOption countersOption("counters",
+                                      "Also measure cycles, instructions, "
+                                      "last level cache misses and branch "
+                                      "misses per stage (Linux).");
+    QCommandLineOption profileOption("profile",
+                                     "Write a Chrome trace-event profile of "
+                                     "the processing. Overrides RAVEL_PROFILE.",
+                                     "file");
+    parser.addOption(generateOption);
+    parser.addOption(patternOption);
+    parser.addOption(repeatOption);
+    parser.addOption(warmupOption);
+    parser.addOption(outputOption);
+    parser.addOption(settingsOption);
+    parser.addOption(clusterOption);
+    parser.addOption(setOption);
+    parser.addOption(profileOption);
+    parser.addOption(countersOption);
+    parser.process(app);
+
+    if (parser.isSet(profileOption))
+        SelfProfiler::start(parser.value(profileOption));
+    else
+        SelfProfiler::startFromEnvironment();
+
+    QStringList args = parser.positionalArguments();
+    if (args.size() != (parser.isSet(generateOption) ? 0 : 1))
+        parser.showHelp(1);
+
+    int repetitions = parser.value(repeatOption).toInt();
+    int warmup = parser.value(warmupOption).toInt();
+    if (repetitions < 1 || warmup < 0)
+    {
+        std::cout << "Need at least one measured run." << std::endl;
+        return 1;
+    }
+
+    QTemporaryDir scratch;
+    if (!scratch.isValid())
+    {
+        std::cout << "Unable to create a scratch directory." << std::endl;
+        return 1;
+    }
+
+    // Always cluster with the same seed so runs are comparable
+    ImportOptions * options = new ImportOptions();
+    if (parser.isSet(settingsOption))
+    {
+        QSettings settings(parser.value(settingsOption), QSettings::IniFormat);
+        options->readSettings(&settings);
+    }
+    if (parser.isSet(clusterOption))
+        options->cluster = true;
+    options->seedClusters = true;
+    QString optionError;
+    if (!options->setOptions(parser.values(setOption), &optionError))
+    {
+        std::cout << optionError.toStdString().c_str() << std::endl;
+        delete options;
+        return 1;
+    }
+
+    QString dataFileName;
+    QJsonObject generated;
+    if (parser.isSet(generateOption))
+    {
+        QStringList size = parser.value(generateOption).split("x");
+        TraceGenerator generator;
+        if (size.size() != 2 || !generator.setPattern(parser.value(patternOption)))
+        {
+            std::cout << "Unable to generate "
+                      << parser.value(generateOption).toStdString().c_str()
+                      << std::endl;
+            delete options;
+            return 1;
+        }
+        generator.entities = size.at(0).toInt();
+        generator.iterations = size.at(1).toInt();
+        generator.generateTrace(scratch.path(), "generated");
+        dataFileName = scratch.path() + "/generated.otf2";
+
+        generated["ranks"] = generator.entities;
+        generated["iterations"] = generator.iterations;
+        generated["pattern"] = generator.getPatternName();
+    }
+    else
+    {
+        dataFileName = QFileInfo(args.at(0)).absoluteFilePath();
+    }
+
+    if (!options->setOriginFromFile(dataFileName))
+    {
+        std::cout << "Unrecognized trace format!" << std::endl;
+        delete options;
+        return 1;
+    }
+
+    QList<QString> order;
+    QMap<QString, StageStats> stats;
+    long long num_events = 0;
+    bool counting = parser.isSet(countersOption);
+    if (counting && !PerfCounters::isAvailable())
+    {
+        std::cout << "Hardware counters unavailable, timing only: "
+                  << PerfCounters::unavailableReason().toStdString().c_str()
+                  << std::endl;
+        counting = false;
+    }
+    StageTimer::setCounting(counting);
+    StageTimer::setRecording(true);
+    for (int run = 0; run < warmup + repetitions; run++)
+    {
+        num_events = runPipeline(options, dataFileName, scratch.path());
+        if (num_events < 0)
+        {
+            std::cout << "Unable to process " << dataFileName.toStdString().c_str()
+                      << std::endl;
+            delete options;
+            return 1;
+        }
+
+        QList<QPair<QString, StageTimer::Record> > records = StageTimer::takeRecords();
+        if (run < warmup)
+            continue;
+
+        for (QList<QPair<QString, StageTimer::Record> >::Iterator record = records.begin();
+             record != records.end(); ++record)
+        {
+            if (!stats.contains(record->first))
+                order.append(record->first);
+            StageStats & stage = stats[record->first];
+            stage.nanos.append(record->second.nanos);
+            stage.calls = record->second.calls;
+            stage.peak_rss = qMax(stage.peak_rss, record->second.peak_rss);
+            for (int i = 0; i < PerfCounters::PC_NUM_COUNTERS; i++)
+            {
+                if (record->second.counters[i] >= 0)
+                    stage.counters[i].append(record->second.counters[i]);
+            }
+        }
+    }
+    StageTimer::setRecording(false);
+    StageTimer::setCounting(false);
+
+    QJsonArray stages;
+    for (QList<QString>::Iterator name = order.begin(); name != order.end(); ++name)
+    {
+        StageStats stage = stats.value(*name);
+        qint64 mid = median(stage.nanos);
+        qint64 total = 0;
+        for (QList<qint64>::Iterator nanos = stage.nanos.begin();
+             nanos != stage.nanos.end(); ++nanos)
+        {
+            total += *nanos;
+        }
+
+        QJsonObject wall;
+        wall["min"] = *std::min_element(stage.nanos.begin(), stage.nanos.end());
+        wall["median"] = mid;
+        wall["mean"] = (double) total / stage.nanos.size();
+        wall["max"] = *std::max_element(stage.nanos.begin(), stage.nanos.end());
+
+        QJsonObject entry;
+        entry["name"] = *name;
+        entry["runs"] = stage.nanos.size();
+        entry["calls_per_run"] = stage.calls;
+        entry["wall_ns"] = wall;
+        entry["peak_rss_bytes"] = stage.peak_rss;
+        entry["events_per_sec"] = mid > 0 ? num_events / (mid * 1e-9) : 0;
+
+        // Medians over the runs, for the stage's own thread
+        if (counting)
+        {
+            QJsonObject counters;
+            for (int i = 0; i < PerfCounters::PC_NUM_COUNTERS; i++)
+            {
+                if (!stage.counters.at(i).isEmpty())
+                    counters[PerfCounters::counterName(static_cast<PerfCounters::Counter>(i))]
+                        = median(stage.counters.at(i));
+            }
+            if (!stage.counters.at(PerfCounters::PC_CYCLES).isEmpty()
+                && !stage.counters.at(PerfCounters::PC_INSTRUCTIONS).isEmpty())
+            {
+                qint64 cycles = median(stage.counters.at(PerfCounters::PC_CYCLES));
+                if (cycles > 0)
+                    counters["ipc"] = (double) median(stage.counters.at(PerfCounters::PC_INSTRUCTIONS))
+                                      / cycles;
+            }
+            entry["counters"] = counters;
+        }
+        stages.append(entry);
+    }
+
+    QJsonObject machine;
+    machine["host"] = QSysInfo::machineHostName();
+    machine["os"] = QSysInfo::prettyProductName();
+    machine["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    machine["threads"] = QThread::idealThreadCount();
+    machine["distance_kernel"] = QString(ClusterMatrix::kernelName());
+
+    QJsonObject report;
+    report["trace"] = parser.isSet(generateOption) ? QString("generated")
+                                                   : dataFileName;
+    if (parser.isSet(generateOption))
+        report["generated"] = generated;
+    report["events"] = num_events;
+    report["warmup"] = warmup;
+    report["repetitions"] = repetitions;
+    report["qt_version"] = QString(qVersion());
+    report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["machine"] = machine;
+    if (parser.isSet(countersOption))
+        report["counters"] = counting ? QString("available")
+                                      : PerfCounters::unavailableReason();
+    report["stages"] = stages;
+
+    QFile output(parser.value(outputOption));
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        std::cout << "Unable to write " << output.fileName().toStdString().c_str()
+                  << std::endl;
+        delete options;
+        return 1;
+    }
+    output.write(QJsonDocument(report).toJson());
+    output.close();
+    std::cout << "Wrote " << output.fileName().toStdString().c_str() << std::endl;
+
+    delete options;
+    return 0;
+}
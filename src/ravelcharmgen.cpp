@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+/* Ravel synthetic Charm++ log generator */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <climits>
+#include <iostream>
+
+#include "charmgenerator.h"
+#include "ravelutils.h"
+
+// Write synthetic Projections logs so the Charm++ import can be timed on
+// inputs anyone can recreate.
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ravel-charmgen");
+
+    CharmGenerator * generator = new CharmGenerator();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generate synthetic Charm++ Projections logs.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("output", "Logs to write, e.g. /path/to/jacobi "
+                                 "creates /path/to/jacobi.sts and "
+                                 "/path/to/jacobi.<pe>.log.");
+
+    QCommandLineOption pesOption(QStringList() << "n" << "pes",
+                                 "Number of PEs.", "count",
+                                 QString::number(generator->pes));
+    QCommandLineOption iterationsOption(QStringList() << "i" << "iterations",
+                                        "Number of iterations.", "count",
+                                        QString::number(generator->iterations));
+    QCommandLineOption dimsOption(QStringList() << "d" << "dims",
+                                  "Chare array extents, one to four "
+                                  "dimensions, e.g. 16x16x4.", "extents",
+                                  generator->getDimensionString());
+    QCommandLineOption arraysOption("arrays", "Number of chare arrays.",
+                                    "count", QString::number(generator->arrays));
+    QCommandLineOption entriesOption("entries",
+                                     "Compute entry methods, used in turn "
+                                     "each iteration.", "count",
+                                     QString::number(generator->entries));
+    QCommandLineOption migrateOption("migrate-every",
+                                     "Iterations between migrations, 0 for "
+                                     "none.", "count",
+                                     QString::number(generator->migration_period));
+    QCommandLineOption migrationOption("migration",
+                                       "Fraction of elements moving to the next "
+                                       "PE at each migration.", "fraction",
+                                       QString::number(generator->migration));
+    QCommandLineOption reduceOption("reduce-every",
+                                    "Iterations between reductions, 0 for "
+                                    "none.", "count",
+                                    QString::number(generator->reduction_period));
+    QCommandLineOption noIdleOption("no-idle", "Do not write idle records.");
+    QCommandLineOption gzipOption(QStringList() << "z" << "gzip",
+                                  "Write .log.gz files.");
+    QCommandLineOption imbalanceOption("imbalance",
+                                       "Persistent per-element slowdown as a "
+                                       "fraction of compute time.", "fraction",
+                                       QString::number(generator->imbalance));
+    QCommandLineOption noiseOption("noise",
+                                   "Per-iteration jitter as a fraction of "
+                                   "compute time.", "fraction",
+                                   QString::number(generator->noise));
+    QCommandLineOption computeOption("compute",
+                                     "Base compute time per element and "
+                                     "iteration.", "time",
+                                     QString::number(generator->compute));
+    QCommandLineOption sizeOption("size", "Message size in bytes.", "bytes",
+                                  QString::number(generator->message_size));
+    QCommandLineOption seedOption("seed", "Random seed.", "seed",
+                                  QString::number(generator->seed));
+    parser.addOption(pesOption);
+    parser.addOption(iterationsOption);
+    parser.addOption(dimsOption);
+    parser.addOption(arraysOption);
+    parser.addOption(entriesOption);
+    parser.addOption(migrateOption);
+    parser.addOption(migrationOption);
+    parser.addOption(reduceOption);
+    parser.addOption(noIdleOption);
+    parser.addOption(gzipOption);
+    parser.addOption(imbalanceOption);
+    parser.addOption(noiseOption);
+    parser.addOption(computeOption);
+    parser.addOption(sizeOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    QStringList args = parser.positionalArguments();
+    if (args.size() != 1)
+        parser.showHelp(1);
+
+    generator->pes = parser.value(pesOption).toInt();
+    generator->iterations = parser.value(iterationsOption).toInt();
+    generator->arrays = parser.value(arraysOption).toInt();
+    generator->entries = parser.value(entriesOption).toInt();
+    generator->migration_period = parser.value(migrateOption).toInt();
+    generator->migration = parser.value(migrationOption).toDouble();
+    generator->reduction_period = parser.value(reduceOption).toInt();
+    generator->idle = !parser.isSet(noIdleOption);
+    generator->gzip = parser.isSet(gzipOption);
+    generator->imbalance = parser.value(imbalanceOption).toDouble();
+    generator->noise = parser.value(noiseOption).toDouble();
+    generator->compute = parser.value(computeOption).toLongLong();
+    generator->message_size = parser.value(sizeOption).toLongLong();
+    generator->seed = parser.value(seedOption).toULong();
+    if (!generator->setDimensions(parser.value(dimsOption)))
+    {
+        std::cout << "Dimensions must be one to four positive extents separated "
+                  << "by x." << std::endl;
+        delete generator;
+        return 1;
+    }
+    if (generator->pes < 1 || generator->iterations < 1
+        || generator->arrays < 1 || generator->entries < 1
+        || generator->migration_period < 0 || generator->reduction_period < 0
+        || generator->migration < 0 || generator->imbalance < 0
+        || generator->noise < 0
+        || generator->getElementCount() * 8 > INT_MAX)
+    {
+        std::cout << "Invalid generator parameters." << std::endl;
+        delete generator;
+        return 1;
+    }
+
+    QFileInfo output = QFileInfo(args.at(0));
+    QString basename = output.fileName();
+    if (basename.endsWith(".sts"))
+        basename.chop(4);
+
+    std::cout << "Generating " << generator->getElementCount() << " elements on "
+              << generator->pes << " PEs x " << generator->iterations
+              << " iterations" << std::endl;
+
+    QElapsedTimer generateTimer;
+    generateTimer.start();
+
+    generator->generateTrace(output.absolutePath(), basename);
+
+    RavelUtils::gu_printTime(generateTimer.nsecsElapsed(), "Log Generation: ");
+
+    delete generator;
+    return 0;
+}
@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+/* Ravel synthetic trace generator */
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <iostream>
+
+#include "tracegenerator.h"
+#include "ravelutils.h"
+
+// Write a synthetic MPI trace of a given size so the processing and
+// rendering of traces can be timed on inputs anyone can recreate.
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ravel-tracegen");
+
+    TraceGenerator * generator = new TraceGenerator();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generate a synthetic OTF2 trace.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("output", "Archive to write, e.g. "
+                                 "/path/to/halo creates /path/to/halo.otf2.");
+
+    QCommandLineOption ranksOption(QStringList() << "n" << "ranks",
+                                   "Number of MPI ranks.", "count",
+                                   QString::number(generator->entities));
+    QCommandLineOption iterationsOption(QStringList() << "i" << "iterations",
+                                        "Number of iterations.", "count",
+                                        QString::number(generator->iterations));
+    QCommandLineOption patternOption(QStringList() << "p" << "pattern",
+                                     "Communication pattern: "
+                                     + QStringList(TraceGenerator::getPatternNames()).join(", ")
+                                     + ".", "pattern",
+                                     generator->getPatternName());
+    QCommandLineOption depthOption(QStringList() << "d" << "depth",
+                                   "Nested compute regions per iteration.",
+                                   "depth", QString::number(generator->depth));
+    QCommandLineOption countersOption("counters",
+                                      "Number of counters to record (max 255).",
+                                      "count",
+                                      QString::number(generator->counters));
+    QCommandLineOption fanoutOption("fanout",
+                                    "Partners per rank in the burst and "
+                                    "all-to-all patterns.", "count",
+                                    QString::number(generator->fanout));
+    QCommandLineOption imbalanceOption("imbalance",
+                                       "Persistent per-rank slowdown as a "
+                                       "fraction of compute time.", "fraction",
+                                       QString::number(generator->imbalance));
+    QCommandLineOption noiseOption("noise",
+                                   "Per-iteration jitter as a fraction of "
+                                   "compute time.", "fraction",
+                                   QString::number(generator->noise));
+    QCommandLineOption computeOption("compute",
+                                     "Base compute time per iteration in ns.",
+                                     "ns", QString::number(generator->compute));
+    QCommandLineOption sizeOption("size", "Message size in bytes.", "bytes",
+                                  QString::number(generator->message_size));
+    QCommandLineOption seedOption("seed", "Random seed.", "seed",
+                                  QString::number(generator->seed));
+    parser.addOption(ranksOption);
+    parser.addOption(iterationsOption);
+    parser.addOption(patternOption);
+    parser.addOption(depthOption);
+    parser.addOption(countersOption);
+    parser.addOption(fanoutOption);
+    parser.addOption(imbalanceOption);
+    parser.addOption(noiseOption);
+    parser.addOption(computeOption);
+    parser.addOption(sizeOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+
+    QStringList args = parser.positionalArguments();
+    if (args.size() != 1)
+        parser.showHelp(1);
+
+    generator->entities = parser.value(ranksOption).toInt();
+    generator->iterations = parser.value(iterationsOption).toInt();
+    generator->depth = parser.value(depthOption).toInt();
+    generator->counters = parser.value(countersOption).toInt();
+    generator->fanout = parser.value(fanoutOption).toInt();
+    generator->imbalance = parser.value(imbalanceOption).toDouble();
+    generator->noise = parser.value(noiseOption).toDouble();
+    generator->compute = parser.value(computeOption).toULongLong();
+    generator->message_size = parser.value(sizeOption).toULongLong();
+    generator->seed = parser.value(seedOption).toULong();
+    if (!generator->setPattern(parser.value(patternOption)))
+    {
+        std::cout << "Unknown pattern "
+                  << parser.value(patternOption).toStdString().c_str()
+                  << std::endl;
+        delete generator;
+        return 1;
+    }
+    if (generator->entities < 1 || generator->iterations < 1
+        || generator->depth < 0 || generator->counters < 0
+        || generator->counters > 255 || generator->imbalance < 0
+        || generator->noise < 0)
+    {
+        std::cout << "Invalid generator parameters." << std::endl;
+        delete generator;
+        return 1;
+    }
+
+    QFileInfo output = QFileInfo(args.at(0));
+    QString filename = output.fileName();
+    if (filename.endsWith(".otf2"))
+        filename.chop(5);
+
+    std::cout << "Generating " << generator->entities << " ranks x "
+              << generator->iterations << " iterations of "
+              << generator->getPatternName().toStdString().c_str()
+              << std::endl;
+
+    QElapsedTimer generateTimer;
+    generateTimer.start();
+
+    generator->generateTrace(output.absolutePath(), filename);
+
+    RavelUtils::gu_printTime(generateTimer.nsecsElapsed(), "Trace Generation: ");
+
+    delete generator;
+    return 0;
+}
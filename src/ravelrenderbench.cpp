@@ -0,0 +1,514 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+/* Ravel rendering benchmark */
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QFileInfo>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtAlgorithms>
+#include <cmath>
+#include <iostream>
+
+#include "trace.h"
+#include "importoptions.h"
+#include "importfunctor.h"
+#include "tracegenerator.h"
+#include "visoptions.h"
+#include "overviewvis.h"
+#include "stepvis.h"
+#include "traditionalvis.h"
+#include "clustervis.h"
+#include "clustertreevis.h"
+
+// One scripted frame: either a step range to show or a point to hover
+class Frame
+{
+public:
+    Frame(float _start, float _stop)
+        : start(_start), stop(_stop), hover(QPoint()), hovering(false) {}
+    Frame(QPoint _hover)
+        : start(0), stop(0), hover(_hover), hovering(true) {}
+
+    float start;
+    float stop;
+    QPoint hover;
+    bool hovering;
+};
+
+// Frames of one viewport script, after a full paint of the setup range
+// that is not measured
+class Scenario
+{
+public:
+    Scenario(QString _name = "", Frame _setup = Frame(0, 0))
+        : name(_name), setup(_setup), frames(QList<Frame>()) {}
+
+    QString name;
+    Frame setup;
+    QList<Frame> frames;
+};
+
+// A view under test. Views that do not follow the step range (the cluster
+// tree) are just repainted for range frames.
+class BenchView
+{
+public:
+    BenchView(QString _name = "", VisWidget * _vis = NULL, bool _steps = true)
+        : name(_name), vis(_vis), steps(_steps) {}
+
+    QString name;
+    VisWidget * vis;
+    bool steps;
+};
+
+static QList<Scenario> makeScenarios(int maxStep, int frames, QSize size)
+{
+    // The views open on this many steps
+    const float deepSpan = 15;
+    float midSpan = qMax(deepSpan, maxStep / 8.0f);
+    float midStart = qMax(0.0f, (maxStep - midSpan) / 2);
+
+    QList<Scenario> scenarios;
+    Scenario full("full", Frame(0, maxStep));
+    Scenario mid("mid", Frame(midStart, midStart + midSpan));
+    Scenario deep("deep", Frame(0, deepSpan));
+    for (int i = 0; i < frames; i++)
+    {
+        full.frames.append(Frame(0, maxStep));
+        mid.frames.append(Frame(midStart, midStart + midSpan));
+        deep.frames.append(Frame(0, deepSpan));
+    }
+    scenarios.append(full);
+    scenarios.append(mid);
+    scenarios.append(deep);
+
+    // Drag right by a quarter of the view each frame, bouncing off the ends
+    Scenario pan("pan", Frame(0, midSpan));
+    float start = 0;
+    float step = midSpan / 4;
+    for (int i = 0; i < frames; i++)
+    {
+        pan.frames.append(Frame(start, start + midSpan));
+        if (start + step + midSpan > maxStep || start + step < 0)
+            step = -step;
+        start = qMax(0.0f, start + step);
+    }
+    scenarios.append(pan);
+
+    // Sweep the mouse along the diagonal over the mid zoom
+    Scenario hover("hover", Frame(midStart, midStart + midSpan));
+    for (int i = 0; i < frames; i++)
+    {
+        double fraction = (i + 0.5) / frames;
+        hover.frames.append(Frame(QPoint(fraction * size.width(),
+                                         fraction * size.height())));
+    }
+    scenarios.append(hover);
+
+    return scenarios;
+}
+
+// Show or hover one frame and wait for GL to finish drawing it
+static qint64 renderFrame(BenchView &view, const Frame &frame)
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (frame.hovering)
+    {
+        QMouseEvent move(QEvent::MouseMove, frame.hover, Qt::NoButton,
+                         Qt::NoButton, Qt::NoModifier);
+        QApplication::sendEvent(view.vis, &move);
+    }
+    else if (view.steps)
+    {
+        view.vis->setSteps(frame.start, frame.stop, false);
+    }
+    else
+    {
+        view.vis->repaint();
+    }
+    view.vis->makeCurrent();
+    glFinish();
+    return timer.nsecsElapsed();
+}
+
+static qint64 percentile(QList<qint64> values, double fraction)
+{
+    qSort(values);
+    int index = qBound(0, (int) ceil(fraction * values.size()) - 1,
+                       values.size() - 1);
+    return values.at(index);
+}
+
+static QJsonObject countSummary(const QList<qint64> &counts)
+{
+    QJsonObject summary;
+    if (counts.isEmpty())
+        return summary;
+    summary["median"] = percentile(counts, 0.5);
+    summary["max"] = percentile(counts, 1);
+    return summary;
+}
+
+// Run every scenario on one view
+static QJsonArray runView(BenchView &view, const QList<Scenario> &scenarios,
+                          bool reuse)
+{
+    QJsonArray results;
+    for (QList<Scenario>::ConstIterator scenario = scenarios.begin();
+         scenario != scenarios.end(); ++scenario)
+    {
+        view.vis->setFrameReuse(false);
+        renderFrame(view, scenario->setup);
+        view.vis->setFrameReuse(reuse);
+
+        // Counts come from the view's own frame statistics, taken only for
+        // frames that painted; a hover over the same event does not
+        QList<qint64> nanos;
+        QList<qint64> visited, drawn, messages;
+        int reused = 0;
+        FrameStats * stats = view.vis->getFrameStats();
+        for (QList<Frame>::ConstIterator frame = scenario->frames.begin();
+             frame != scenario->frames.end(); ++frame)
+        {
+            int painted = stats->isEmpty() ? -1 : stats->last().number;
+            nanos.append(renderFrame(view, *frame));
+            if (stats->isEmpty() || stats->last().number == painted)
+                continue;
+            const FrameStats::Frame &last = stats->last();
+            visited.append(last.counts[FrameStats::FS_EVENTS_VISITED]);
+            drawn.append(last.counts[FrameStats::FS_EVENTS_DRAWN]);
+            messages.append(last.counts[FrameStats::FS_MESSAGES_DRAWN]);
+            if (last.reused)
+                reused++;
+        }
+        QApplication::processEvents();
+
+        qint64 total = 0;
+        for (QList<qint64>::Iterator value = nanos.begin();
+             value != nanos.end(); ++value)
+        {
+            total += *value;
+        }
+
+        QJsonObject wall;
+        wall["min"] = percentile(nanos, 0);
+        wall["median"] = percentile(nanos, 0.5);
+        wall["p90"] = percentile(nanos, 0.9);
+        wall["max"] = percentile(nanos, 1);
+        wall["mean"] = (double) total / nanos.size();
+
+        QJsonObject entry;
+        entry["scenario"] = scenario->name;
+        entry["frames"] = nanos.size();
+        entry["painted_frames"] = drawn.size();
+        entry["reused_frames"] = reused;
+        entry["frame_ns"] = wall;
+        entry["events_visited"] = countSummary(visited);
+        entry["events_drawn"] = countSummary(drawn);
+        entry["messages_drawn"] = countSummary(messages);
+        results.append(entry);
+    }
+    return results;
+}
+
+// Load a trace once, then render each view at scripted viewports and report
+// per-frame timings as JSON. The views draw with OpenGL, so this needs a
+// display; use xvfb-run on machines without one.
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("ravel-renderbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark the Ravel views.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "Trace to show (.otf2, .otf or "
+                                 ".sts), unless --generate is given.", "[trace]");
+
+    QCommandLineOption generateOption(QStringList() << "g" << "generate",
+                                      "Benchmark a generated OTF2 trace of the "
+                                      "given size, e.g. 1024x100.",
+                                      "ranksxiterations");
+    QCommandLineOption patternOption(QStringList() << "p" << "pattern",
+                                     "Pattern of the generated trace.",
+                                     "pattern", "halo");
+    QCommandLineOption framesOption(QStringList() << "f" << "frames",
+                                    "Measured frames per scenario.", "count",
+                                    "30");
+    QCommandLineOption sizeOption("size", "Size of each view.", "widthxheight",
+                                  "1280x400");
+    QCommandLineOption viewsOption("views", "Comma separated views to render.",
+                                   "names",
+                                   "step,traditional,cluster,clustertree,overview");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "JSON report to write.", "file",
+                                    "ravel-renderbench.json");
+    QCommandLineOption settingsOption(QStringList() << "s" << "settings",
+                                      "Read import options from the [Import] "
+                                      "group of an ini file.", "file");
+    QCommandLineOption setOption("option",
+                                 "Set an import option by its saved name. "
+                                 "May be repeated.", "name=value");
+    QCommandLineOption metricOption(QStringList() << "m" << "metric",
+                                    "Metric to color by.", "name", "Lateness");
+    QCommandLineOption noReuseOption("no-reuse",
+                                     "Paint every frame in full rather than "
+                                     "moving the last frame of slow views or "
+                                     "drawing timeline tiles in the "
+                                     "background.");
+    parser.addOption(generateOption);
+    parser.addOption(patternOption);
+    parser.addOption(framesOption);
+    parser.addOption(sizeOption);
+    parser.addOption(viewsOption);
+    parser.addOption(outputOption);
+    parser.addOption(settingsOption);
+    parser.addOption(setOption);
+    parser.addOption(metricOption);
+    parser.addOption(noReuseOption);
+    parser.process(app);
+
+    QStringList args = parser.positionalArguments();
+    if (args.size() != (parser.isSet(generateOption) ? 0 : 1))
+        parser.showHelp(1);
+
+    int frames = parser.value(framesOption).toInt();
+    QStringList dimensions = parser.value(sizeOption).split("x");
+    QSize size;
+    if (dimensions.size() == 2)
+        size = QSize(dimensions.at(0).toInt(), dimensions.at(1).toInt());
+    if (frames < 1 || size.width() < 1 || size.height() < 1)
+    {
+        std::cout << "Need at least one frame and a view size." << std::endl;
+        return 1;
+    }
+
+    QTemporaryDir scratch;
+    if (!scratch.isValid())
+    {
+        std::cout << "Unable to create a scratch directory." << std::endl;
+        return 1;
+    }
+
+    // The cluster views need clustering, seeded so runs are comparable
+    ImportOptions * options = new ImportOptions();
+    if (parser.isSet(settingsOption))
+    {
+        QSettings settings(parser.value(settingsOption), QSettings::IniFormat);
+        options->readSettings(&settings);
+    }
+    options->cluster = true;
+    options->seedClusters = true;
+    QString optionError;
+    if (!options->setOptions(parser.values(setOption), &optionError))
+    {
+        std::cout << optionError.toStdString().c_str() << std::endl;
+        delete options;
+        return 1;
+    }
+
+    QString dataFileName;
+    QJsonObject generated;
+    if (parser.isSet(generateOption))
+    {
+        QStringList traceSize = parser.value(generateOption).split("x");
+        TraceGenerator generator;
+        if (traceSize.size() != 2
+            || !generator.setPattern(parser.value(patternOption)))
+        {
+            std::cout << "Unable to generate "
+                      << parser.value(generateOption).toStdString().c_str()
+                      << std::endl;
+            delete options;
+            return 1;
+        }
+        generator.entities = traceSize.at(0).toInt();
+        generator.iterations = traceSize.at(1).toInt();
+        generator.generateTrace(scratch.path(), "generated");
+        dataFileName = scratch.path() + "/generated.otf2";
+
+        generated["ranks"] = generator.entities;
+        generated["iterations"] = generator.iterations;
+        generated["pattern"] = generator.getPatternName();
+    }
+    else
+    {
+        dataFileName = QFileInfo(args.at(0)).absoluteFilePath();
+    }
+
+    if (!options->setOriginFromFile(dataFileName))
+    {
+        std::cout << "Unrecognized trace format!" << std::endl;
+        delete options;
+        return 1;
+    }
+
+    ImportFunctor * importer = new ImportFunctor(options);
+    if (options->origin == ImportOptions::OF_OTF)
+        importer->doImportOTF(dataFileName);
+    else if (options->origin == ImportOptions::OF_OTF2)
+        importer->doImportOTF2(dataFileName);
+    else
+        importer->doImportCharm(dataFileName);
+    Trace * trace = importer->getTrace();
+    delete importer;
+    if (!trace)
+    {
+        std::cout << "Unable to process " << dataFileName.toStdString().c_str()
+                  << std::endl;
+        delete options;
+        return 1;
+    }
+
+    long long num_events = 0;
+    for (QVector<QVector<Event *> *>::Iterator events = trace->events->begin();
+         events != trace->events->end(); ++events)
+    {
+        num_events += (*events)->size();
+    }
+
+    // Same defaults as the main window
+    VisOptions * visoptions = new VisOptions();
+    visoptions->metric = parser.value(metricOption);
+    if (!trace->metrics->contains(visoptions->metric))
+        visoptions->metric = trace->options.origin == ImportOptions::OF_CHARM
+                             ? "Duration" : "Lateness";
+    if (!trace->use_aggregates
+        || trace->options.origin == ImportOptions::OF_CHARM)
+        visoptions->showAggregateSteps = false;
+
+    QStringList names = parser.value(viewsOption).split(",");
+    ClusterTreeVis * clustertreevis = new ClusterTreeVis(NULL, visoptions);
+    QList<BenchView> views;
+    if (names.contains("step"))
+        views.append(BenchView("step", new StepVis(NULL, visoptions)));
+    if (names.contains("traditional"))
+        views.append(BenchView("traditional",
+                               new TraditionalVis(NULL, visoptions)));
+    if (names.contains("cluster"))
+        views.append(BenchView("cluster",
+                               new ClusterVis(clustertreevis, NULL, visoptions)));
+    if (names.contains("clustertree"))
+        views.append(BenchView("clustertree", clustertreevis, false));
+    if (names.contains("overview"))
+        views.append(BenchView("overview", new OverviewVis(NULL, visoptions)));
+
+    // The tree is driven by the cluster view, so it gets the trace either way
+    clustertreevis->setTrace(trace);
+    clustertreevis->processVis();
+    // Each view is shown as its own top-level window, since a QGLWidget
+    // only gets a GL surface to paint to once it is visible
+    for (QList<BenchView>::Iterator view = views.begin();
+         view != views.end(); ++view)
+    {
+        view->vis->setFixedSize(size);
+        view->vis->show();
+        if (view->vis != clustertreevis)
+        {
+            view->vis->setTrace(trace);
+            view->vis->processVis();
+        }
+    }
+    QApplication::processEvents();
+
+    QList<Scenario> scenarios = makeScenarios(trace->global_max_step, frames,
+                                              size);
+    bool reuse = !parser.isSet(noReuseOption);
+    QJsonArray results;
+    for (QList<BenchView>::Iterator view = views.begin();
+         view != views.end(); ++view)
+    {
+        QJsonObject entry;
+        entry["view"] = view->name;
+        entry["scenarios"] = runView(*view, scenarios, reuse);
+        results.append(entry);
+        std::cout << "Rendered " << view->name.toStdString().c_str()
+                  << std::endl;
+    }
+
+    QJsonObject machine;
+    machine["host"] = QSysInfo::machineHostName();
+    machine["os"] = QSysInfo::prettyProductName();
+    machine["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    machine["threads"] = QThread::idealThreadCount();
+    if (!views.isEmpty())
+    {
+        views.first().vis->makeCurrent();
+        machine["gl_renderer"] = QString((const char *) glGetString(GL_RENDERER));
+        machine["gl_version"] = QString((const char *) glGetString(GL_VERSION));
+    }
+
+    QJsonObject report;
+    report["trace"] = parser.isSet(generateOption) ? QString("generated")
+                                                   : dataFileName;
+    if (parser.isSet(generateOption))
+        report["generated"] = generated;
+    report["events"] = num_events;
+    report["steps"] = trace->global_max_step;
+    report["metric"] = visoptions->metric;
+    report["width"] = size.width();
+    report["height"] = size.height();
+    report["frame_reuse"] = reuse;
+    report["qt_version"] = QString(qVersion());
+    report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["machine"] = machine;
+    report["views"] = results;
+
+    // The cluster view hands its drawers to the tree, so it goes first
+    for (QList<BenchView>::Iterator view = views.begin();
+         view != views.end(); ++view)
+    {
+        if (view->vis != clustertreevis)
+            delete view->vis;
+    }
+    delete clustertreevis;
+    delete trace;
+    delete visoptions;
+    delete options;
+
+    QFile output(parser.value(outputOption));
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        std::cout << "Unable to write " << output.fileName().toStdString().c_str()
+                  << std::endl;
+        return 1;
+    }
+    output.write(QJsonDocument(report).toJson());
+    output.close();
+    std::cout << "Wrote " << output.fileName().toStdString().c_str() << std::endl;
+
+    return 0;
+}
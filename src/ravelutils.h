@@ -54,6 +54,19 @@ public:
         std::cout << hours << " hours" << std::endl;
         return;
     }
+
+    // Stateless random number in [0, 1) from splitmix64 over the inputs,
+    // so generated traces can be recomputed from any starting point
+    static double hashRandom(quint64 seed, quint64 a, quint64 b, int salt)
+    {
+        quint64 z = seed + Q_UINT64_C(0x9E3779B97F4A7C15) * (a + 1);
+        z ^= Q_UINT64_C(0xBF58476D1CE4E5B9) * (b + 1);
+        z += Q_UINT64_C(0x94D049BB133111EB) * (salt + 1);
+        z = (z ^ (z >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+        z = z ^ (z >> 31);
+        return (z >> 11) * (1.0 / 9007199254740992.0);
+    }
 };
 
 #endif // RAVEL_UTIL_H
@@ -35,6 +35,7 @@
 #include "counter.h"
 #include "counterrecord.h"
 #include "importoptions.h"
+#include "memorycensus.h"
 #include <stdint.h>
 
 
@@ -61,13 +62,14 @@ RawTrace::RawTrace(int nt, int np)
       metric_names(NULL),
       metric_units(NULL)
 {
-
+    MemoryCensus::watch(this);
 }
 
 // Note we do not delete the function/functionGroup map because
 // we know that will get passed to the processed trace
 RawTrace::~RawTrace()
 {
+    MemoryCensus::unwatch(this);
     for (QVector<QVector<EventRecord *> *>::Iterator eitr = events->begin();
          eitr != events->end(); ++eitr)
     {
@@ -26,19 +26,23 @@
 #include <iostream>
 #include <fstream>
 #include <climits>
+#include <algorithm>
 
 #include "event.h"
 #include "commevent.h"
 #include "collectiverecord.h"
 #include "clusterentity.h"
+#include "clustermatrix.h"
 #include "ravelutils.h"
 #include "message.h"
 #include "p2pevent.h"
 #include "function.h"
 #include "metrics.h"
 #include "gnome.h"
+#include "strideinfo.h"
 
 #include "trace.h"
+#include "stagetimer.h"
 
 Partition::Partition()
     : events(new QMap<unsigned long, QList<CommEvent *> *>),
@@ -64,18 +68,20 @@ Partition::Partition()
       gnome(NULL),
       gnome_type(0),
       cluster_entities(new QVector<ClusterEntity *>()),
-      cluster_vectors(new QMap<int, QVector<long long int> *>()),
-      cluster_step_starts(new QMap<int, int>()),
+      cluster_matrix(NULL),
       debug_mark(false),
       debug_name(-1),
       debug_functions(NULL),
-      free_recvs(NULL)
+      free_recvs(NULL),
+      stride_info(NULL)
 {
     group->insert(this); // We are always in our own group
 }
 
 Partition::~Partition()
 {
+    releaseStrideInfo();
+
     for (QMap<unsigned long, QList<CommEvent *> *>::Iterator eitr = events->begin();
          eitr != events->end(); ++eitr)
     {
@@ -90,14 +96,7 @@ Partition::~Partition()
     delete old_children;
     delete metrics;
     delete gnome;
-
-    for (QMap<int, QVector<long long int> *>::Iterator itr = cluster_vectors->begin();
-         itr != cluster_vectors->end(); ++itr)
-    {
-        delete itr.value();
-    }
-    delete cluster_vectors;
-    delete cluster_step_starts;
+    delete cluster_matrix;
 }
 
 // Call when we are sure we want to delete events held in this partition
@@ -547,6 +546,46 @@ void Partition::finalizeEntityEventOrder()
     }
 }
 
+// Allocate the scratch stride state used by receive reordering and stepping
+// and hand each event a pointer into it.
+void Partition::initializeStrideInfo()
+{
+    releaseStrideInfo();
+    stride_info = new QVector<StrideInfo>(num_events());
+
+    int index = 0;
+    for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list = events->begin();
+         event_list != events->end(); ++event_list)
+    {
+        for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
+             evt != (event_list.value())->end(); ++evt)
+        {
+            (*evt)->stride_info = &((*stride_info)[index]);
+            ++index;
+        }
+    }
+}
+
+// Once steps are set, the stride state is no longer needed
+void Partition::releaseStrideInfo()
+{
+    if (!stride_info)
+        return;
+
+    for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list = events->begin();
+         event_list != events->end(); ++event_list)
+    {
+        for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
+             evt != (event_list.value())->end(); ++evt)
+        {
+            (*evt)->stride_info = NULL;
+        }
+    }
+
+    delete stride_info;
+    stride_info = NULL;
+}
+
 void Partition::receive_reorder_mpi()
 {
     // Partitions always start with some sends that have no previous parent
@@ -564,8 +603,8 @@ void Partition::receive_reorder_mpi()
     {
         if (!event_list.value()->first()->isReceive())
         {
-            event_list.value()->first()->stride = 0;
-            event_list.value()->first()->last_stride = event_list.value()->first();
+            event_list.value()->first()->stride_info->stride = 0;
+            event_list.value()->first()->stride_info->last_stride = event_list.value()->first();
             stride_map->value(0)->append(event_list.value()->first());
         }
     }
@@ -602,22 +641,23 @@ void Partition::receive_reorder_mpi()
                 {
                     if (!local_evt->isReceive())
                     {
-                        if (local_evt->stride < (*evt)->stride + my_stride)
+                        if (local_evt->stride_info->stride
+                            < (*evt)->stride_info->stride + my_stride)
                         {
-                            if (local_evt->stride >= 0)
-                                stride_map->value(local_evt->stride)->removeOne(local_evt);
-                            else if (local_evt->stride == current_stride)
+                            if (local_evt->stride_info->stride >= 0)
+                                stride_map->value(local_evt->stride_info->stride)->removeOne(local_evt);
+                            else if (local_evt->stride_info->stride == current_stride)
                                 std::cout << "Error: Incorrect stride" << std::endl;
 
-                            local_evt->stride = (*evt)->stride + my_stride;
-                            local_evt->last_stride = *evt;
-                            if (!stride_map->contains(local_evt->stride))
-                                stride_map->insert(local_evt->stride,
+                            local_evt->stride_info->stride = (*evt)->stride_info->stride + my_stride;
+                            local_evt->stride_info->last_stride = *evt;
+                            if (!stride_map->contains(local_evt->stride_info->stride))
+                                stride_map->insert(local_evt->stride_info->stride,
                                                    new QList<CommEvent *>());
-                            stride_map->value(local_evt->stride)->append(local_evt);
+                            stride_map->value(local_evt->stride_info->stride)->append(local_evt);
 
-                            if (max_stride < local_evt->stride)
-                                max_stride = local_evt->stride;
+                            if (max_stride < local_evt->stride_info->stride)
+                                max_stride = local_evt->stride_info->stride;
                         }
 
                         my_stride++;
@@ -636,8 +676,8 @@ void Partition::receive_reorder_mpi()
             // Handle recvs for this send
             if (!(*evt)->isReceive())
             {
-                if (max_stride < (*evt)->stride + 1)
-                    max_stride = (*evt)->stride + 1;
+                if (max_stride < (*evt)->stride_info->stride + 1)
+                    max_stride = (*evt)->stride_info->stride + 1;
 
                 (*evt)->set_reorder_strides(stride_map, 1, NULL, current_stride);
             }
@@ -688,8 +728,8 @@ void Partition::receive_reorder()
             if (!(*evt)->isReceive() && ((*evt)->comm_prev == NULL
                                          || (*evt)->comm_prev->partition != this))
             {
-                (*evt)->stride = 0;
-                (*evt)->last_stride = (*evt);
+                (*evt)->stride_info->stride = 0;
+                (*evt)->stride_info->last_stride = (*evt);
                 stride_map->value(0)->append(*evt);
             }
         }
@@ -712,9 +752,9 @@ void Partition::receive_reorder()
         {
             local_evt = *evt;
             my_stride = 1;
-            if (local_evt->stride != current_stride)
+            if (local_evt->stride_info->stride != current_stride)
                 continue;
-            Q_ASSERT(local_evt->stride == current_stride);
+            Q_ASSERT(local_evt->stride_info->stride == current_stride);
 
             // Handle all the events under the common caller
             // (which are those that follow through comm_next in this case without
@@ -725,14 +765,15 @@ void Partition::receive_reorder()
             {
                 if (local_evt->comm_next && local_evt->comm_next->partition == this)
                 {
-                    if (local_evt->comm_next->stride < local_evt->stride + 1)
+                    if (local_evt->comm_next->stride_info->stride
+                        < local_evt->stride_info->stride + 1)
                     {
-                        local_evt->comm_next->stride = local_evt->stride + 1;
+                        local_evt->comm_next->stride_info->stride = local_evt->stride_info->stride + 1;
                     }
-                    local_evt->comm_next->last_stride = *evt;
+                    local_evt->comm_next->stride_info->last_stride = *evt;
 
-                    if (max_stride < local_evt->stride + 1)
-                        max_stride = local_evt->stride + 1;
+                    if (max_stride < local_evt->stride_info->stride + 1)
+                        max_stride = local_evt->stride_info->stride + 1;
 
                     my_stride++;
 
@@ -751,8 +792,8 @@ void Partition::receive_reorder()
             {
                 if (!local_evt->isReceive()) // We have a send - update matching recvs
                 {
-                    if (max_stride < local_evt->stride + my_stride)
-                        max_stride = local_evt->stride + my_stride;
+                    if (max_stride < local_evt->stride_info->stride + my_stride)
+                        max_stride = local_evt->stride_info->stride + my_stride;
 
                     local_evt->set_reorder_strides(stride_map, my_stride, NULL, current_stride);
                 } // Handled send
@@ -873,7 +914,7 @@ void Partition::basic_step()
                 evt = next_step[entity];
 
                 // We are not at_stride
-                if (!(evt && evt->stride == stride))
+                if (!(evt && evt->stride_info->stride == stride))
                 {
                     move_forward = true;
                     // and have all their parents taken care of
@@ -881,9 +922,11 @@ void Partition::basic_step()
                     {
                         // Now we move forward as we can with these non-stride events
                         // that fall between the previous stride and i
-                        if (evt && evt->stride < 0
-                            && (!evt->last_stride || evt->last_stride->stride < stride)
-                            && evt->next_stride && evt->next_stride->stride == stride)
+                        if (evt && evt->stride_info->stride < 0
+                            && (!evt->stride_info->last_stride
+                                || evt->stride_info->last_stride->stride_info->stride < stride)
+                            && evt->stride_info->next_stride
+                            && evt->stride_info->next_stride->stride_info->stride == stride)
                         {
                             // We can move forward also if our parents are taken care of
                             if (evt->calculate_local_step())
@@ -911,7 +954,7 @@ void Partition::basic_step()
 
                 // Save where we are
                 next_step[entity] = evt;
-                if (evt && evt->stride < 0)
+                if (evt && evt->stride_info->stride < 0)
                 {
                     at_stride = false;
                 }
@@ -926,7 +969,7 @@ void Partition::basic_step()
             entity = entities[i];
             evt = next_step[entity];
 
-            if (evt && evt->stride == stride)
+            if (evt && evt->stride_info->stride == stride)
             {
                 evt->step = max_step + 1;
                 if (evt->comm_next && evt->comm_next->partition == this)
@@ -1060,9 +1103,10 @@ void Partition::step()
             // if that the next_stride exists and is this one (otherwise
             // it wouldn't be blocking the step procedure)
             // For recvs, last_stride must exist
-            while (evt && evt->stride < 0
-                   && evt->last_stride->stride < stride
-                   && evt->next_stride && evt->next_stride->stride == stride)
+            while (evt && evt->stride_info->stride < 0
+                   && evt->stride_info->last_stride->stride_info->stride < stride
+                   && evt->stride_info->next_stride
+                   && evt->stride_info->next_stride->stride_info->stride == stride)
             {
                 if (evt->comm_prev && evt->comm_prev->partition == this)
                     // It has to go after its previous event but it also
@@ -1071,9 +1115,9 @@ void Partition::step()
                     // (If last_stride is its entity-previous, then
                     // it will be covered by comm_prev).
                     evt->step = 1 + std::max(evt->comm_prev->step,
-                                              evt->last_stride->step);
+                                              evt->stride_info->last_stride->step);
                 else
-                    evt->step = 1 + evt->last_stride->step;
+                    evt->step = 1 + evt->stride_info->last_stride->step;
 
                 if (evt->step > max_step)
                     max_step = evt->step;
@@ -1096,7 +1140,7 @@ void Partition::step()
             entity = entities[i];
             evt = next_step[entity];
 
-            if (evt && evt->stride == stride)
+            if (evt && evt->stride_info->stride == stride)
             {
                 evt->step = max_step + 1;
                 if (evt->comm_next && evt->comm_next->partition == this)
@@ -1122,9 +1166,9 @@ void Partition::step()
         {
             if (evt->comm_prev && evt->comm_prev->partition == this)
                 evt->step = 1 + std::max(evt->comm_prev->step,
-                                          evt->last_stride->step);
+                                          evt->stride_info->last_stride->step);
             else
-                evt->step = 1 + evt->last_stride->step;
+                evt->step = 1 + evt->stride_info->last_stride->step;
 
             if (evt->step > max_step)
                 max_step = evt->step;
@@ -1144,11 +1188,11 @@ int Partition::set_stride_dag(QList<CommEvent *> * stride_events)
     for (QList<CommEvent *>::Iterator evt = stride_events->begin();
          evt != stride_events->end(); ++evt)
     {
-        if ((*evt)->stride_parents->isEmpty())
+        if ((*evt)->stride_info->stride_parents.isEmpty())
         {
-            (*evt)->stride = 0;
-            for (QSet<CommEvent *>::Iterator child = (*evt)->stride_children->begin();
-                 child != (*evt)->stride_children->end(); ++child)
+            (*evt)->stride_info->stride = 0;
+            for (QSet<CommEvent *>::Iterator child = (*evt)->stride_info->stride_children.begin();
+                 child != (*evt)->stride_info->stride_children.end(); ++child)
             {
                 current_events->insert(*child);
             }
@@ -1165,10 +1209,10 @@ int Partition::set_stride_dag(QList<CommEvent *> * stride_events)
         {
             parentFlag = true;
             stride = -1;
-            for (QSet<CommEvent *>::Iterator parent = (*evt)->stride_parents->begin();
-                 parent != (*evt)->stride_parents->end(); ++parent)
+            for (QSet<CommEvent *>::Iterator parent = (*evt)->stride_info->stride_parents.begin();
+                 parent != (*evt)->stride_info->stride_parents.end(); ++parent)
             {
-                if ((*parent)->stride < 0)
+                if ((*parent)->stride_info->stride < 0)
                 {
                     next_events->insert(*parent);
                     parentFlag = false;
@@ -1176,22 +1220,22 @@ int Partition::set_stride_dag(QList<CommEvent *> * stride_events)
                 }
                 else
                 {
-                    stride = std::max(stride, (*parent)->stride);
+                    stride = std::max(stride, (*parent)->stride_info->stride);
                 }
             }
 
             if (!parentFlag)
                 continue;
 
-            (*evt)->stride = stride + 1; // 1 over the max parent
-            if ((*evt)->stride > max_stride)
-                max_stride = (*evt)->stride;
+            (*evt)->stride_info->stride = stride + 1; // 1 over the max parent
+            if ((*evt)->stride_info->stride > max_stride)
+                max_stride = (*evt)->stride_info->stride;
 
             // Add children to next_events
-            for (QSet<CommEvent *>::Iterator child = (*evt)->stride_children->begin();
-                 child != (*evt)->stride_children->end(); ++child)
+            for (QSet<CommEvent *>::Iterator child = (*evt)->stride_info->stride_children.begin();
+                 child != (*evt)->stride_info->stride_children.end(); ++child)
             {
-                if ((*child)->stride < 0)
+                if ((*child)->stride_info->stride < 0)
                     next_events->insert(*child);
             }
         }
@@ -1251,20 +1295,16 @@ void Partition::calculate_imbalance(int num_pes)
 
 void Partition::makeClusterVectors(QString metric)
 {
+    StageTimer stageTimer("makeClusterVectors");
     // Clean up old
-    for (QMap<int, QVector<long long int> *>::Iterator itr =  cluster_vectors->begin();
-         itr != cluster_vectors->end(); ++itr)
-    {
-        delete itr.value();
-    }
     for (QVector<ClusterEntity *>::Iterator itr
          = cluster_entities->begin(); itr != cluster_entities->end(); ++itr)
     {
         delete *itr;
     }
     cluster_entities->clear();
-    cluster_vectors->clear();
-    cluster_step_starts->clear();
+    delete cluster_matrix;
+    cluster_matrix = NULL;
 
 
     // Create a ClusterEntity for each entity and in each set metric_events
@@ -1272,11 +1312,8 @@ void Partition::makeClusterVectors(QString metric)
     for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list = events->begin();
          event_list != events->end(); ++event_list)
     {
-        QVector<long long int> * metric_vector = new QVector<long long int>();
-        (*cluster_vectors)[event_list.key()] = metric_vector;
         long long int last_value = 0;
         int last_step = (event_list.value())->at(0)->step;
-        (*cluster_step_starts)[event_list.key()] = last_step;
         ClusterEntity * cp = new ClusterEntity(event_list.key(), last_step);
         cluster_entities->append(cp);
         for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
@@ -1285,7 +1322,6 @@ void Partition::makeClusterVectors(QString metric)
             while ((*evt)->step > last_step + 2)
             {
                 // Fill in the previous known value
-                metric_vector->append(last_value);
                 cp->metric_events->append(last_value);
                 last_step += 2;
             }
@@ -1293,17 +1329,30 @@ void Partition::makeClusterVectors(QString metric)
             // Fill in our value
             last_step = (*evt)->step;
             last_value = (*evt)->getMetric(metric);
-            metric_vector->append(last_value);
             cp->metric_events->append(last_value);
         }
         while (last_step <= max_global_step)
         {
             // We're out of steps but fill in the rest
-            metric_vector->append(last_value);
             cp->metric_events->append(last_value);
             last_step += 2;
         }
     }
+
+    // Every vector runs to the end of the partition, so the longest one has
+    // a value for each step of the partition. Rows follow cluster_entities.
+    int columns = 0;
+    for (QVector<ClusterEntity *>::Iterator cp = cluster_entities->begin();
+         cp != cluster_entities->end(); ++cp)
+    {
+        columns = std::max(columns, (*cp)->metric_events->size());
+    }
+    cluster_matrix = new ClusterMatrix(cluster_entities->size(), columns);
+    for (int i = 0; i < cluster_entities->size(); i++)
+    {
+        QVector<long long int> * values = cluster_entities->at(i)->metric_events;
+        cluster_matrix->setRow(i, values->constData(), values->size());
+    }
 }
 
 // String giving process IDs involved in this partition
@@ -1429,6 +1478,7 @@ void Partition::output_graph(QString filename, Trace * trace)
     graph2 << indent.toStdString().c_str() << "node [label=\"\\N\"];\n";
 
     QMap<int, QString> entities = QMap<int, QString>();
+    QMap<CommEvent *, QString> gvids = QMap<CommEvent *, QString>();
 
     int id = 0;
     for (QMap<unsigned long, QList<CommEvent *> *>::Iterator evtlist = events->begin();
@@ -1443,8 +1493,8 @@ void Partition::output_graph(QString filename, Trace * trace)
         for (QList<CommEvent *>::Iterator evt = evtlist.value()->begin();
              evt != evtlist.value()->end(); ++evt)
         {
-            (*evt)->gvid = QString::number(id);
-            graph << indent.toStdString().c_str() << (*evt)->gvid.toStdString().c_str();
+            gvids.insert(*evt, QString::number(id));
+            graph << indent.toStdString().c_str() << gvids.value(*evt).toStdString().c_str();
             graph << " [label=\"";
             graph << "t=" << QString::number((*evt)->entity).toStdString().c_str();\
             graph << ", p=" << QString::number((*evt)->pe).toStdString().c_str();
@@ -1455,7 +1505,7 @@ void Partition::output_graph(QString filename, Trace * trace)
                 graph << "\n " << trace->functions->value((*evt)->caller->function)->name.toStdString().c_str();
             graph << "\"];\n";
 
-            graph2 << indent.toStdString().c_str() << (*evt)->gvid.toStdString().c_str();
+            graph2 << indent.toStdString().c_str() << gvids.value(*evt).toStdString().c_str();
             graph2 << " [label=\"";
             graph2 << "t=" << QString::number((*evt)->entity).toStdString().c_str();\
             graph2 << ", p=" << QString::number((*evt)->pe).toStdString().c_str();
@@ -1480,19 +1530,19 @@ void Partition::output_graph(QString filename, Trace * trace)
         {
             if (prev)
             {
-                graph2 << indent.toStdString().c_str() << prev->gvid.toStdString().c_str();
-                graph2 << " -> " << (*evt)->gvid.toStdString().c_str() << ";\n";
+                graph2 << indent.toStdString().c_str() << gvids.value(prev).toStdString().c_str();
+                graph2 << " -> " << gvids.value(*evt).toStdString().c_str() << ";\n";
             }
             else
             {
                 graph2 << indent.toStdString().c_str() << entities.value(evtlist.key()).toStdString().c_str();
-                graph2 << " -> " << (*evt)->gvid.toStdString().c_str() << ";\n";
+                graph2 << " -> " << gvids.value(*evt).toStdString().c_str() << ";\n";
             }
             if ((*evt)->comm_next && (*evt)->comm_next->partition == this)
             {
                 graph << "edge [color=red];\n";
-                graph << indent.toStdString().c_str() << (*evt)->gvid.toStdString().c_str();
-                graph << " -> " << (*evt)->comm_next->gvid.toStdString().c_str() << ";\n";
+                graph << indent.toStdString().c_str() << gvids.value(*evt).toStdString().c_str();
+                graph << " -> " << gvids.value((*evt)->comm_next).toStdString().c_str() << ";\n";
             }
             if ((*evt)->isP2P() && !(*evt)->isReceive())
             {
@@ -1501,8 +1551,8 @@ void Partition::output_graph(QString filename, Trace * trace)
                      msg != messages->end(); ++msg)
                 {
                     graph << "edge [color=black];\n";
-                    graph << indent.toStdString().c_str() << (*evt)->gvid.toStdString().c_str();
-                    graph << " -> " << (*msg)->receiver->gvid.toStdString().c_str() << ";\n";
+                    graph << indent.toStdString().c_str() << gvids.value(*evt).toStdString().c_str();
+                    graph << " -> " << gvids.value((*msg)->receiver).toStdString().c_str() << ";\n";
                 }
             }
             prev = *evt;
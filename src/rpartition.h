@@ -35,9 +35,11 @@ class Gnome;
 class Event;
 class CommEvent;
 class ClusterEntity;
+class ClusterMatrix;
 class Function;
 class Metrics;
 class Trace;
+class StrideInfo;
 
 class Partition
 {
@@ -53,6 +55,10 @@ public:
     void step();
     void basic_step();
 
+    // Scratch state for receive reordering and stepping
+    void initializeStrideInfo();
+    void releaseStrideInfo();
+
     // Based on step
     bool operator<(const Partition &);
     bool operator>(const Partition &);
@@ -129,14 +135,13 @@ public:
     QString gvid;
 
     // For gnome and clustering
-    // Cluster_vectors simplify the coding of distance calculations
-    // between processes but don't aid performance so may be wasteful
+    // The cluster matrix holds the same vectors as cluster_entities, a row
+    // each in the same order, laid out for the distance kernel
     Gnome * gnome;
     int gnome_type;
     QVector<ClusterEntity *> * cluster_entities;
     void makeClusterVectors(QString metric);
-    QMap<int, QVector<long long int> *> * cluster_vectors;
-    QMap<int, int> * cluster_step_starts;
+    ClusterMatrix * cluster_matrix;
 
     bool debug_mark;
     int debug_name;
@@ -147,6 +152,7 @@ private:
     int set_stride_dag(QList<CommEvent *> *stride_events);
 
     QList<CommEvent *> * free_recvs;
+    QVector<StrideInfo> * stride_info;
     static const bool debug = false;
 
 };
@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "selfprofiler.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+#include <iostream>
+
+bool SelfProfiler::enabled = false;
+QString SelfProfiler::filename = QString();
+QElapsedTimer SelfProfiler::clock = QElapsedTimer();
+QMutex SelfProfiler::mutex;
+QVector<SelfProfiler::TraceEvent> SelfProfiler::events
+    = QVector<SelfProfiler::TraceEvent>();
+QHash<Qt::HANDLE, int> SelfProfiler::threads = QHash<Qt::HANDLE, int>();
+
+void SelfProfiler::startFromEnvironment()
+{
+    QString file = QString::fromLocal8Bit(qgetenv("RAVEL_PROFILE"));
+    if (!file.isEmpty())
+        start(file);
+}
+
+// Begin recording. The file is written by stop, which is also run when the
+// application object goes away.
+void SelfProfiler::start(QString _filename)
+{
+    if (enabled)
+        return;
+
+    filename = _filename;
+    events.clear();
+    threads.clear();
+    events.reserve(1024);
+    clock.start();
+    enabled = true;
+    if (QCoreApplication::instance())
+        qAddPostRoutine(SelfProfiler::stop);
+}
+
+void SelfProfiler::complete(const char * name, qint64 start)
+{
+    qint64 end = now();
+    record('X', name, start, end - start, 0);
+}
+
+void SelfProfiler::record(char phase, const char * name, qint64 ts, qint64 dur,
+                          qint64 value)
+{
+    Qt::HANDLE thread = QThread::currentThreadId();
+
+    QMutexLocker locker(&mutex);
+    if (!enabled)
+        return;
+
+    TraceEvent evt;
+    evt.phase = phase;
+    evt.name = name;
+    evt.ts = ts;
+    evt.dur = dur;
+    evt.value = value;
+    if (!threads.contains(thread))
+        threads.insert(thread, threads.size() + 1);
+    evt.tid = threads.value(thread);
+    events.append(evt);
+}
+
+// Write the trace-event JSON. Times are in microseconds.
+void SelfProfiler::stop()
+{
+    QMutexLocker locker(&mutex);
+    if (!enabled)
+        return;
+    enabled = false;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        std::cerr << "Could not write profile "
+                  << filename.toStdString().c_str() << std::endl;
+        return;
+    }
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+        << "\"args\":{\"name\":\""
+        << (QCoreApplication::instance() ? QCoreApplication::applicationName()
+                                         : QString("ravel"))
+        << "\"}}";
+    for (QHash<Qt::HANDLE, int>::Iterator thread = threads.begin();
+         thread != threads.end(); ++thread)
+    {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << thread.value() << ",\"args\":{\"name\":\""
+            << (thread.value() == 1 ? QString("processing")
+                                    : QString("worker %1").arg(thread.value() - 1))
+            << "\"}}";
+    }
+
+    for (QVector<TraceEvent>::Iterator evt = events.begin();
+         evt != events.end(); ++evt)
+    {
+        out << ",\n{\"name\":\"" << evt->name << "\",\"ph\":\"" << evt->phase
+            << "\",\"pid\":1,\"tid\":" << evt->tid
+            << ",\"ts\":" << QString::number(evt->ts / 1000.0, 'f', 3);
+        if (evt->phase == 'X')
+            out << ",\"dur\":" << QString::number(evt->dur / 1000.0, 'f', 3);
+        else
+            out << ",\"args\":{\"" << evt->name << "\":" << evt->value << "}";
+        out << "}";
+    }
+    out << "\n]}\n";
+    file.close();
+
+    std::cout << "Wrote profile of " << events.size() << " events to "
+              << filename.toStdString().c_str() << std::endl;
+    events.clear();
+    threads.clear();
+}
@@ -0,0 +1,95 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef SELFPROFILER_H
+#define SELFPROFILER_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+
+// Records Ravel's own processing as a Chrome trace-event file which can be
+// opened in chrome://tracing or Perfetto. It is started by setting
+// RAVEL_PROFILE to the output file (or --profile in the command line tools)
+// and written when the application exits.
+//
+// Spans are complete ("X") events so nesting is implied by time on each
+// thread. Counters are "C" events. When profiling is off each span or
+// counter is a single flag check. Recording is safe from any thread.
+class SelfProfiler
+{
+public:
+    // Scoped span on the calling thread. The name must outlive the profiler,
+    // i.e. be a string literal.
+    class Span {
+    public:
+        Span(const char * _name)
+            : name(_name), start(enabled ? now() : -1) {}
+        ~Span() { if (start >= 0) complete(name, start); }
+
+    private:
+        const char * name;
+        qint64 start;
+    };
+
+    static bool isEnabled() { return enabled; }
+    static void startFromEnvironment();
+    static void start(QString filename);
+    static void stop();
+
+    static void counter(const char * name, qint64 value)
+    {
+        if (enabled)
+            record('C', name, now(), 0, value);
+    }
+
+private:
+    class TraceEvent {
+    public:
+        TraceEvent() : phase('X'), name(NULL), ts(0), dur(0), tid(0), value(0) {}
+
+        char phase;
+        const char * name;
+        qint64 ts; // ns since start
+        qint64 dur;
+        int tid;
+        qint64 value;
+    };
+
+    static qint64 now() { return clock.nsecsElapsed(); }
+    static void complete(const char * name, qint64 start);
+    static void record(char phase, const char * name, qint64 ts, qint64 dur,
+                       qint64 value);
+
+    static bool enabled;
+    static QString filename;
+    static QElapsedTimer clock;
+    static QMutex mutex;
+    static QVector<TraceEvent> events;
+    static QHash<Qt::HANDLE, int> threads;
+};
+
+#endif // SELFPROFILER_H
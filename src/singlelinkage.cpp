@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "singlelinkage.h"
+#include <QtConcurrent>
+#include <climits>
+#include <algorithm>
+
+// The distances of rows [first_row, last_row) to columns [first_column,
+// last_column) that are below the diagonal
+class DistanceTile
+{
+public:
+    DistanceTile(const SingleLinkage::Distance * _distance, long long * _block,
+                 int _n, int _first_row, int _last_row,
+                 int _first_column, int _last_column)
+        : distance(_distance), block(_block), n(_n),
+          first_row(_first_row), last_row(_last_row),
+          first_column(_first_column), last_column(_last_column) {}
+
+    const SingleLinkage::Distance * distance;
+    long long * block;
+    int n;
+    int first_row;
+    int last_row;
+    int first_column;
+    int last_column;
+};
+
+static void calculateDistanceTile(const DistanceTile& tile)
+{
+    for (int i = tile.first_row; i < tile.last_row; i++)
+    {
+        long long * row = tile.block + (long long) (i - tile.first_row) * tile.n;
+        int last = std::min(i, tile.last_column);
+        if (tile.first_column < last)
+            tile.distance->distances(i, tile.first_column, last,
+                                     row + tile.first_column);
+    }
+}
+
+class HeightLessThan
+{
+public:
+    HeightLessThan(const QVector<long long> * _heights) : heights(_heights) {}
+
+    bool operator()(int a, int b) const
+    {
+        if (heights->at(a) == heights->at(b))
+            return a < b;
+        return heights->at(a) < heights->at(b);
+    }
+
+    const QVector<long long> * heights;
+};
+
+SingleLinkage::SingleLinkage(int _n)
+    : n(_n),
+      parents(QVector<int>(_n)),
+      heights(QVector<long long>(_n, LLONG_MAX))
+{
+}
+
+void SingleLinkage::build(const Distance * distance)
+{
+    QVector<long long> block(std::min(n, block_rows) * (long long) n);
+    QVector<DistanceTile> tiles;
+    for (int first_row = 0; first_row < n; first_row += block_rows)
+    {
+        int last_row = std::min(n, first_row + block_rows);
+
+        // Distances of the whole block of rows
+        tiles.clear();
+        for (int column = 0; column < last_row - 1; column += tile_columns)
+            tiles.append(DistanceTile(distance, block.data(), n,
+                                      first_row, last_row, column,
+                                      std::min(last_row - 1, column + tile_columns)));
+        QtConcurrent::blockingMap(tiles, calculateDistanceTile);
+
+        // SLINK insertion of each row in turn
+        for (int i = first_row; i < last_row; i++)
+        {
+            long long * m = block.data() + (long long) (i - first_row) * n;
+            parents[i] = i;
+            heights[i] = LLONG_MAX;
+            for (int j = 0; j < i; j++)
+            {
+                int p = parents.at(j);
+                if (heights.at(j) >= m[j])
+                {
+                    m[p] = std::min(m[p], heights.at(j));
+                    heights[j] = m[j];
+                    parents[j] = i;
+                }
+                else
+                {
+                    m[p] = std::min(m[p], m[j]);
+                }
+            }
+            for (int j = 0; j < i; j++)
+            {
+                if (heights.at(j) >= heights.at(parents.at(j)))
+                    parents[j] = i;
+            }
+        }
+    }
+}
+
+QVector<int> SingleLinkage::mergeOrder() const
+{
+    QVector<int> order;
+    order.reserve(n);
+    for (int i = 0; i < n - 1; i++)
+        order.append(i);
+    std::sort(order.begin(), order.end(), HeightLessThan(&heights));
+    return order;
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef SINGLELINKAGE_H
+#define SINGLELINKAGE_H
+
+#include <QVector>
+
+// Single linkage clustering with SLINK (Sibson 1973). The result is the
+// pointer representation of the dendrogram: item i joins the cluster of
+// parent(i) > i at height(i), and the last item is the root. This takes
+// O(n^2) distance evaluations but only O(n) memory, where sorting the list
+// of all pairs takes O(n^2).
+//
+// Distances are computed a block of rows at a time, with the block split
+// into column tiles which are evaluated concurrently.
+class SingleLinkage
+{
+public:
+    // Distance between items i and j, j < i. Called from several threads
+    // at once.
+    class Distance {
+    public:
+        virtual ~Distance() {}
+        virtual long long distance(int i, int j) const = 0;
+
+        // Distances from i to [first, last), last <= i. Override when a
+        // whole row can be computed faster than one pair at a time.
+        virtual void distances(int i, int first, int last,
+                               long long * results) const
+        {
+            for (int j = first; j < last; j++)
+                results[j - first] = distance(i, j);
+        }
+    };
+
+    SingleLinkage(int _n);
+
+    void build(const Distance * distance);
+    int parent(int i) const { return parents.at(i); }
+    long long height(int i) const { return heights.at(i); }
+
+    // Items other than the root, by increasing height. Merging item i with
+    // parent(i) in this order builds the dendrogram bottom up.
+    QVector<int> mergeOrder() const;
+
+    static const int block_rows = 64;
+    static const int tile_columns = 512;
+
+private:
+    int n;
+    QVector<int> parents;
+    QVector<long long> heights;
+};
+
+#endif // SINGLELINKAGE_H
@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "stagetimer.h"
+#include "memorycensus.h"
+#include <QFile>
+#include <QByteArray>
+#include <QMutexLocker>
+#include <QtGlobal>
+
+#ifndef Q_OS_WIN
+#include <sys/resource.h>
+#endif
+
+bool StageTimer::recording = false;
+bool StageTimer::counting = false;
+QMutex StageTimer::mutex;
+QList<StageTimer *> StageTimer::active = QList<StageTimer *>();
+QList<QString> StageTimer::order = QList<QString>();
+QMap<QString, StageTimer::Record> StageTimer::records
+    = QMap<QString, StageTimer::Record>();
+
+StageTimer::StageTimer(const char * _stage)
+    : span(_stage),
+      stage(_stage),
+      started(recording || MemoryCensus::isReporting()),
+      outermost(true),
+      thread(QThread::currentThread()),
+      peak(0),
+      timer(QElapsedTimer())
+{
+    if (!started)
+        return;
+
+    QMutexLocker locker(&mutex);
+
+    // Resetting the high-water mark would lose the enclosing stages' peak,
+    // so hand it to them first
+    long long current = peakRSS();
+    for (QList<StageTimer *>::Iterator outer = active.begin();
+         outer != active.end(); ++outer)
+    {
+        (*outer)->peak = qMax((*outer)->peak, current);
+        if ((*outer)->thread == thread)
+            outermost = false;
+    }
+    resetPeakRSS();
+
+    active.append(this);
+    if (recording && counting)
+        counters.start();
+    timer.start();
+}
+
+StageTimer::~StageTimer()
+{
+    if (!started)
+        return;
+
+    qint64 nanos = timer.nsecsElapsed();
+    counters.stop();
+
+    QMutexLocker locker(&mutex);
+    peak = qMax(peak, peakRSS());
+    active.removeOne(this);
+    for (QList<StageTimer *>::Iterator outer = active.begin();
+         outer != active.end(); ++outer)
+    {
+        (*outer)->peak = qMax((*outer)->peak, peak);
+    }
+
+    QString name = QString(stage);
+    if (!records.contains(name))
+        order.append(name);
+    Record & record = records[name];
+    record.nanos += nanos;
+    record.calls++;
+    record.peak_rss = qMax(record.peak_rss, peak);
+    for (int i = 0; i < PerfCounters::PC_NUM_COUNTERS; i++)
+    {
+        long long value = counters.value(static_cast<PerfCounters::Counter>(i));
+        if (value >= 0)
+            record.counters[i] = qMax(record.counters[i], 0LL) + value;
+    }
+    locker.unlock();
+
+    if (outermost && MemoryCensus::isReporting())
+        MemoryCensus::reportStage(stage, peak);
+}
+
+QList<QPair<QString, StageTimer::Record> > StageTimer::takeRecords()
+{
+    QMutexLocker locker(&mutex);
+    QList<QPair<QString, Record> > taken;
+    for (QList<QString>::Iterator name = order.begin();
+         name != order.end(); ++name)
+    {
+        taken.append(QPair<QString, Record>(*name, records.value(*name)));
+    }
+    order.clear();
+    records.clear();
+    return taken;
+}
+
+// High-water mark of resident memory in bytes. On Linux this is VmHWM,
+// which resetPeakRSS can lower again; elsewhere it is the process maximum.
+long long StageTimer::peakRSS()
+{
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly))
+    {
+        QByteArray line;
+        while (!(line = status.readLine()).isEmpty())
+        {
+            if (line.startsWith("VmHWM:"))
+                return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+        }
+    }
+#endif
+#ifndef Q_OS_WIN
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024LL;
+#endif
+#else
+    return 0;
+#endif
+}
+
+void StageTimer::resetPeakRSS()
+{
+#ifdef Q_OS_LINUX
+    QFile clear("/proc/self/clear_refs");
+    if (clear.open(QIODevice::WriteOnly))
+        clear.write("5");
+#endif
+}
@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+
+#include "selfprofiler.h"
+#include "perfcounters.h"
+
+// Scoped timer for the stages of the processing pipeline. Put one at the
+// top of a stage with the stage's name. When recording is off (the default)
+// it does nothing. When on, it adds its wall time to the stage's total and
+// records the peak resident memory seen while the stage ran, which is used
+// for benchmarking. With counting on as well, it adds the hardware counters
+// of the stage's thread. Each stage is also a span of the self profile, and
+// is followed by a memory census when MemoryCensus is reporting.
+//
+// Timers may nest. Stages on different threads (e.g. processing and paint)
+// are safe but the peak memory of one includes the other. Use a
+// SelfProfiler::Span for work split across worker threads. Only stages
+// that are not inside another stage on the same thread are followed by a
+// census, so nested and per-partition stages do not each walk the trace.
+class StageTimer
+{
+public:
+    StageTimer(const char * _stage);
+    ~StageTimer();
+
+    class Record {
+    public:
+        Record() : nanos(0), calls(0), peak_rss(0)
+        {
+            for (int i = 0; i < PerfCounters::PC_NUM_COUNTERS; i++)
+                counters[i] = -1;
+        }
+
+        qint64 nanos;
+        int calls;
+        long long peak_rss; // bytes
+        long long counters[PerfCounters::PC_NUM_COUNTERS]; // -1 if not counted
+    };
+
+    static void setRecording(bool record) { recording = record; }
+    static bool isRecording() { return recording; }
+    static void setCounting(bool count) { counting = count; }
+    static bool isCounting() { return counting; }
+
+    // Totals per stage since the last take, in the order first seen
+    static QList<QPair<QString, Record> > takeRecords();
+
+    static long long peakRSS();
+    static void resetPeakRSS();
+
+private:
+    SelfProfiler::Span span;
+    const char * stage;
+    bool started;
+    bool outermost; // no enclosing stage on this thread
+    QThread * thread;
+    long long peak;
+    QElapsedTimer timer;
+    PerfCounters counters;
+
+    static bool recording;
+    static bool counting;
+    static QMutex mutex;
+    static QList<StageTimer *> active;
+    static QList<QString> order;
+    static QMap<QString, Record> records;
+};
+
+#endif // STAGETIMER_H
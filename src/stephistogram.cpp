@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "stephistogram.h"
+#include <cmath>
+
+#include "trace.h"
+#include "rpartition.h"
+#include "commevent.h"
+
+StepHistogram::StepHistogram(Trace * _trace, QString _metric)
+    : trace(_trace),
+      metric(_metric),
+      sums(QVector<double>()),
+      prefix(QVector<double>()),
+      stats(TraceSummary::MetricStats())
+{
+}
+
+void StepHistogram::build()
+{
+    sums = QVector<double>(trace->global_max_step + 1, 0);
+    stats = TraceSummary::MetricStats();
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part)
+    {
+        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                if (!(*evt)->hasMetric(metric))
+                    continue;
+                double value = (*evt)->getMetric(metric);
+                double aggregate = (*evt)->getMetric(metric, true);
+                stats.add(value, aggregate);
+
+                int step = (*evt)->step;
+                if (step < 0 || step >= sums.size())
+                    continue;
+                if (value > 0)
+                    sums[step] += value;
+
+                // The aggregate sits in the step before its event
+                if (step == 0)
+                    continue;
+                if (aggregate > 0)
+                    sums[step - 1] += aggregate;
+            }
+        }
+    }
+
+    stats.finish();
+
+    prefix = QVector<double>(sums.size() + 1, 0);
+    for (int i = 0; i < sums.size(); i++)
+        prefix[i + 1] = prefix[i] + sums[i];
+}
+
+double StepHistogram::cumulative(double step) const
+{
+    if (step <= 0 || sums.isEmpty())
+        return 0;
+    if (step >= sums.size())
+        return prefix.last();
+
+    int whole = static_cast<int>(floor(step));
+    return prefix[whole] + sums[whole] * (step - whole);
+}
+
+double StepHistogram::total(double start, double stop) const
+{
+    return cumulative(stop) - cumulative(start);
+}
+
+long long StepHistogram::memoryBytes() const
+{
+    return sizeof(StepHistogram) - sizeof(TraceSummary::MetricStats)
+           + stats.memoryBytes()
+           + (sums.capacity() + prefix.capacity()) * sizeof(double);
+}
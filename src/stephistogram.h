@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef STEPHISTOGRAM_H
+#define STEPHISTOGRAM_H
+
+#include <QString>
+#include <QVector>
+
+#include "tracesummary.h"
+
+class Trace;
+
+// Sum of a metric over all entities at each global step, with an aggregate
+// counted at the step before its event, as the overview draws it. Positive
+// values only. A prefix sum over the steps lets any range of steps, whole or
+// fractional, be totalled in constant time, so rebinning to a new width
+// does not look at the events again. The same pass gathers the metric's
+// range and distribution for the trace summary.
+class StepHistogram
+{
+public:
+    StepHistogram(Trace * _trace, QString _metric);
+
+    void build();
+    QString getMetric() const { return metric; }
+    int numSteps() const { return sums.size(); }
+    double sum(int step) const { return sums.at(step); }
+    const TraceSummary::MetricStats * getStats() const { return &stats; }
+
+    // Total over the steps in [start, stop), each step spread evenly over
+    // its unit interval
+    double total(double start, double stop) const;
+    long long memoryBytes() const;
+
+private:
+    double cumulative(double step) const;
+
+    Trace * trace;
+    QString metric;
+    QVector<double> sums;
+    QVector<double> prefix; // prefix[i] = sums[0] + ... + sums[i - 1]
+    TraceSummary::MetricStats stats;
+};
+
+#endif // STEPHISTOGRAM_H
@@ -0,0 +1,199 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "steppyramid.h"
+#include <QtConcurrent>
+#include <algorithm>
+
+#include "trace.h"
+#include "rpartition.h"
+#include "commevent.h"
+#include "stagetimer.h"
+#include "tracesummary.h"
+
+// Level 0 rows [first_row, last_row), which no other band touches
+class StepPyramidBand
+{
+public:
+    StepPyramidBand(StepPyramid * _pyramid, int _first_row, int _last_row)
+        : pyramid(_pyramid), first_row(_first_row), last_row(_last_row) {}
+    void build() const { pyramid->buildBand(first_row, last_row); }
+
+    StepPyramid * pyramid;
+    int first_row;
+    int last_row;
+};
+
+static void buildStepPyramidBand(const StepPyramidBand& band)
+{
+    band.build();
+}
+
+void StepPyramid::Stats::add(double value)
+{
+    count++;
+    mean += (value - mean) / count;
+    if (count == 1 || value > max)
+        max = value;
+}
+
+void StepPyramid::Stats::add(const Stats& other)
+{
+    if (!other.count)
+        return;
+    if (!count || other.max > max)
+        max = other.max;
+    int total = count + other.count;
+    mean = (double(mean) * count + double(other.mean) * other.count) / total;
+    count = total;
+}
+
+StepPyramid::StepPyramid(Trace * _trace, QString _metric)
+    : trace(_trace),
+      metric(_metric),
+      step_bin(2),
+      entity_bin(1),
+      levels(QVector<Level>())
+{
+}
+
+// Columns start at step -1, which holds the aggregate of step 0
+void StepPyramid::build()
+{
+    StageTimer stageTimer("buildStepPyramid");
+    levels.clear();
+
+    int steps = trace->global_max_step + 2;
+    int entities = std::max(trace->num_entities, 1);
+    step_bin = 2;
+    entity_bin = 1;
+    long long columns = (steps + step_bin - 1) / step_bin;
+    long long rows = entities;
+    while (columns * rows > max_cells)
+    {
+        if (columns >= rows)
+        {
+            step_bin *= 2;
+            columns = (steps + step_bin - 1) / step_bin;
+        }
+        else
+        {
+            entity_bin *= 2;
+            rows = (entities + entity_bin - 1) / entity_bin;
+        }
+    }
+    levels.append(Level(columns, rows));
+
+    QVector<StepPyramidBand> bands;
+    int band_rows = std::max(1, 64 / entity_bin);
+    for (int row = 0; row < rows; row += band_rows)
+        bands.append(StepPyramidBand(this, row, std::min<int>(rows, row + band_rows)));
+    QtConcurrent::blockingMap(bands, buildStepPyramidBand);
+
+    while (levels.last().columns > 1 || levels.last().rows > 1)
+        buildLevel(levels.size());
+}
+
+void StepPyramid::buildBand(int first_row, int last_row)
+{
+    Level& level = levels[0];
+    unsigned long first_entity = first_row * entity_bin;
+    unsigned long last_entity = last_row * entity_bin;
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part)
+    {
+        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->lowerBound(first_entity);
+             event_list != (*part)->events->end() && event_list.key() < last_entity;
+             ++event_list)
+        {
+            Cell * row = level.cells.data()
+                         + (event_list.key() / entity_bin) * level.columns;
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                int step = (*evt)->step;
+                row[(step + 1) / step_bin].events.add((*evt)->getMetric(metric));
+                row[step / step_bin].aggregates.add((*evt)->getMetric(metric, true));
+            }
+        }
+    }
+}
+
+// Each cell of a level summarizes up to four of the level below
+void StepPyramid::buildLevel(int level)
+{
+    const Level& below = levels.at(level - 1);
+    Level above((below.columns + 1) / 2, (below.rows + 1) / 2);
+    for (int r = 0; r < below.rows; r++)
+    {
+        const Cell * from = below.cells.constData() + r * below.columns;
+        Cell * to = above.cells.data() + (r / 2) * above.columns;
+        for (int c = 0; c < below.columns; c++)
+        {
+            to[c / 2].events.add(from[c].events);
+            to[c / 2].aggregates.add(from[c].aggregates);
+        }
+    }
+    levels.append(above);
+}
+
+int StepPyramid::chooseLevel(double steps_per_pixel,
+                             double entities_per_pixel) const
+{
+    // Entity rows cannot be split so they may be taller than a pixel
+    entities_per_pixel = std::max(entities_per_pixel, 1.0);
+    for (int level = levels.size() - 1; level >= 0; level--)
+        if (stepBin(level) <= steps_per_pixel
+            && entityBin(level) <= entities_per_pixel)
+            return level;
+    return -1;
+}
+
+long long StepPyramid::memoryBytes() const
+{
+    long long bytes = sizeof(StepPyramid);
+    for (QVector<Level>::ConstIterator level = levels.constBegin();
+         level != levels.constEnd(); ++level)
+    {
+        bytes += sizeof(Level) + level->cells.capacity() * sizeof(Cell);
+    }
+    return bytes;
+}
+
+bool StepPyramid::worthBuilding(Trace * trace)
+{
+    if (trace->summary)
+        return trace->summary->num_events > max_cells;
+
+    long long num_events = 0;
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part)
+    {
+        num_events += (*part)->num_events();
+        if (num_events > max_cells)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef STEPPYRAMID_H
+#define STEPPYRAMID_H
+
+#include <QString>
+#include <QVector>
+
+class Trace;
+
+// A metric summarized over the step x entity grid of a trace at several
+// resolutions, for drawing the logical timeline zoomed out beyond one event
+// per pixel. Level 0 bins steps and entities by powers of two so it has at
+// most max_cells cells, and each further level halves both. Every cell
+// keeps the count, mean and max of the events and, separately, of their
+// aggregates, which sit one step before them.
+//
+// Building reads every event once and may run in a worker thread.
+class StepPyramid
+{
+public:
+    class Stats {
+    public:
+        Stats() : count(0), mean(0), max(0) {}
+        void add(double value);
+        void add(const Stats& other);
+
+        int count;
+        float mean;
+        float max;
+    };
+
+    class Cell {
+    public:
+        Stats events;
+        Stats aggregates;
+    };
+
+    StepPyramid(Trace * _trace, QString _metric);
+
+    void build();
+    QString getMetric() const { return metric; }
+    bool isBuilt() const { return !levels.isEmpty(); }
+
+    int numLevels() const { return levels.size(); }
+    int stepBin(int level) const { return step_bin << level; }
+    int entityBin(int level) const { return entity_bin << level; }
+    int columns(int level) const { return levels.at(level).columns; }
+    int rows(int level) const { return levels.at(level).rows; }
+    const Cell& cell(int level, int column, int row) const
+        { return levels.at(level).cells.at(row * columns(level) + column); }
+
+    // The coarsest level whose cells are no larger than a pixel, or -1 if
+    // even level 0 is coarser than that
+    int chooseLevel(double steps_per_pixel, double entities_per_pixel) const;
+
+    long long memoryBytes() const;
+
+    // Whether drawing event by event could outgrow the pyramid
+    static bool worthBuilding(Trace * trace);
+    static const int max_cells = 1 << 21;
+
+private:
+    class Level {
+    public:
+        Level() : columns(0), rows(0), cells(QVector<Cell>()) {}
+        Level(int _columns, int _rows)
+            : columns(_columns), rows(_rows),
+              cells(QVector<Cell>(_columns * _rows)) {}
+
+        int columns;
+        int rows;
+        QVector<Cell> cells;
+    };
+
+    friend class StepPyramidBand;
+    void buildBand(int first_row, int last_row);
+    void buildLevel(int level);
+
+    Trace * trace;
+    QString metric;
+    int step_bin;
+    int entity_bin;
+    QVector<Level> levels;
+};
+
+#endif // STEPPYRAMID_H
@@ -36,11 +36,16 @@
 #include "collectiveevent.h"
 #include "primaryentitygroup.h"
 #include "entity.h"
+#include "steppyramid.h"
+#include "tracesummary.h"
+#include "memorycensus.h"
 #include <iostream>
 #include <cmath>
 #include <QLocale>
 #include <QMouseEvent>
+#include <QElapsedTimer>
 #include <QWheelEvent>
+#include <QtConcurrent>
 
 #include "function.h"
 
@@ -59,20 +64,27 @@ StepVis::StepVis(QWidget* parent, VisOptions * _options)
       ellipse_width(0),
       ellipse_height(0),
       overdrawYMap(new QMap<int, int>()),
-      groupColorMap(new QMap<int, QColor>())
+      groupColorMap(new QMap<int, QColor>()),
+      usePyramid(false),
+      pyramid(NULL),
+      pendingPyramid(NULL),
+      pyramidWatcher()
 {
-
+    connect(&pyramidWatcher, SIGNAL(finished()), this, SLOT(pyramidBuilt()));
 }
 
 StepVis::~StepVis()
 {
+    stopPyramid();
     delete overdrawYMap;
     delete groupColorMap;
 }
 
 void StepVis::setTrace(Trace * t)
 {
+    stopPyramid();
     VisWidget::setTrace(t);
+    usePyramid = StepPyramid::worthBuilding(trace);
     // Initial conditions
     if (options->showAggregateSteps)
         startStep = -1;
@@ -162,32 +174,59 @@ void StepVis::processVis()
 }
 
 
+void StepVis::clear()
+{
+    stopPyramid();
+    VisWidget::clear();
+}
+
+void StepVis::countMemory(MemoryCensus * census)
+{
+    VisWidget::countMemory(census);
+    if (pyramid)
+        census->add(MemoryCensus::MC_VIS, 1, pyramid->memoryBytes());
+}
+
+static void buildStepPyramid(StepPyramid * pyramid)
+{
+    pyramid->build();
+}
+
+// Build a pyramid for the metric unless one is already on its way
+void StepVis::startPyramid(QString metric)
+{
+    if (!usePyramid || pyramidWatcher.isRunning())
+        return;
+    pendingPyramid = new StepPyramid(trace, metric);
+    pyramidWatcher.setFuture(QtConcurrent::run(buildStepPyramid, pendingPyramid));
+}
+
+void StepVis::pyramidBuilt()
+{
+    if (!pendingPyramid)
+        return;
+    delete pyramid;
+    pyramid = pendingPyramid;
+    pendingPyramid = NULL;
+    repaint();
+}
+
+// Wait out any build and drop the pyramids as the trace is going away
+void StepVis::stopPyramid()
+{
+    pyramidWatcher.waitForFinished();
+    delete pendingPyramid;
+    pendingPyramid = NULL;
+    delete pyramid;
+    pyramid = NULL;
+}
+
 void StepVis::setupMetric()
 {
-    // Find the maximum of a metric -- TODO: Move this into trace as a lookup
-    // some day before we do tiling
-    maxMetric = 0;
-    QString metric(options->metric);
-    for (QList<Partition *>::Iterator part = trace->partitions->begin();
-         part != trace->partitions->end(); ++part)
-    {
-        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
-             = (*part)->events->begin();
-             event_list != (*part)->events->end(); ++event_list)
-        {
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                if ((*evt)->hasMetric(metric))
-                {
-                    if ((*evt)->getMetric(metric) > maxMetric)
-                        maxMetric = (*evt)->getMetric(metric);
-                    if ((*evt)->getMetric(metric, true) > maxMetric)
-                        maxMetric = (*evt)->getMetric(metric, true);
-                }
-            }
-        }
-    }
+    // The largest event or aggregate value, from the trace's summary
+    const TraceSummary::MetricStats * stats
+            = trace->summary->getMetricStats(options->metric);
+    maxMetric = std::max(0.0, std::max(stats->max, stats->aggregate_max));
     options->setRange(0, maxMetric);
     cacheMetric = options->metric;
 
@@ -340,43 +379,19 @@ void StepVis::mouseMoveEvent(QMouseEvent * event)
                 repaint();
             }
         }
-        else if (options->showAggregateSteps && hover_event
-                 && drawnEvents[hover_event].contains(mousex, mousey)) // fxn
+        else
         {
-            if (!hover_aggregate && mousex
-                <= drawnEvents[hover_event].x() + stepwidth)
-            {
-                hover_aggregate = true;
-                repaint();
-            }
-            else if (hover_aggregate && mousex >=  drawnEvents[hover_event].x()
-                     + stepwidth)
+            QRect evtRect;
+            Event * evt = findDrawnEvent(mousex, mousey, &evtRect);
+            bool aggregate = evt && options->showAggregateSteps
+                             && mousex <= evtRect.x() + stepwidth;
+            if (evt != hover_event || aggregate != hover_aggregate)
             {
-                hover_aggregate = false;
+                hover_event = evt;
+                hover_aggregate = aggregate;
                 repaint();
             }
         }
-        else if (hover_event == NULL
-                 || !drawnEvents[hover_event].contains(mousex, mousey))
-        {
-            hover_event = NULL;
-            for (QMap<Event *, QRect>::Iterator evt = drawnEvents.begin();
-                 evt != drawnEvents.end(); ++evt)
-            {
-                if (evt.value().contains(mousex, mousey))
-                {
-                    hover_aggregate = false;
-                    if (options->showAggregateSteps && mousex
-                        <= evt.value().x() + stepwidth)
-                    {
-                        hover_aggregate = true;
-                    }
-                    hover_event = evt.key();
-                }
-            }
-
-            repaint();
-        }
     }
 
 }
@@ -407,12 +422,27 @@ void StepVis::wheelEvent(QWheelEvent * event)
     emit stepsChanged(startStep, startStep + stepSpan, false);
 }
 
+bool StepVis::viewRange(ViewRange * range)
+{
+    int effectiveHeight = rect().height() - colorBarHeight;
+    range->plot = QRect(labelWidth, 0, rect().width() - labelWidth,
+                        effectiveHeight);
+    range->x = startStep;
+    if (options->showAggregateSteps)
+        range->xscale = floor(rect().width() / stepSpan);
+    else
+        range->xscale = floor(rect().width() / (ceil(stepSpan / 2.0))) / 2;
+    range->y = startEntity;
+    range->yscale = floor(effectiveHeight / entitySpan);
+    return range->xscale > 0 && range->yscale > 0;
+}
+
 void StepVis::prepaint()
 {
     if (!visProcessed)
         return;
     closed = false;
-    drawnEvents.clear();
+    drawnEvents.reset(rect());
     if (jumped) // We have to redo the active_partitions
     {
         // We know this list is in order, so we only have to go so far
@@ -533,7 +563,17 @@ void StepVis::drawNativeGL()
     entityheight = height/ entitySpan;
     stepwidth = width / effectiveSpan;
 
+    // Once several steps share a pixel, draw the pyramid so the work
+    // follows the pixels rather than the events
+    if (!(selected_gnome && !selected_entities.isEmpty())
+        && drawPyramidGL(metric, !(options->showAggregateSteps
+                                   || !trace->use_aggregates)))
+    {
+        return;
+    }
 
+    QElapsedTimer walk;
+    walk.start();
     double num_events = 0;
     Partition * part = NULL;
     int topStep = boundStep(startStep + stepSpan) + 1;
@@ -586,19 +626,21 @@ void StepVis::drawNativeGL()
     }
 
     // Generate buffers to hold each bar. We don't know how many there will
-    // be since we draw one per event.
+    // be since we draw one per event. Colors are looked up for all bars at
+    // once afterwards.
     QVector<GLfloat> bars = QVector<GLfloat>();
-    QVector<GLfloat> colors = QVector<GLfloat>();
+    QVector<double> values = QVector<double>();
+    QVector<GLubyte> alphas = QVector<GLubyte>();
 
     // Process events for values
     float x, y; // true position
     float position; // placement of entity
-    QColor color;
     float maxEntity = entitySpan + startEntity;
     float myopacity, opacity_multiplier = 1.0;
     if (selected_gnome && !selected_entities.isEmpty())
         opacity_multiplier = 0.50;
     std::cout << startStep << std::endl;
+    int partitions = 0, visited = 0, drawn = 0;
     for (int i = startPartition; i < trace->partitions->length(); ++i)
     {
         part = trace->partitions->at(i);
@@ -606,6 +648,7 @@ void StepVis::drawNativeGL()
             break;
         else if (part->max_global_step < bottomStep)
             continue;
+        partitions++;
         for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list = part->events->begin();
              event_list != part->events->end(); ++event_list)
         {
@@ -628,9 +671,11 @@ void StepVis::drawNativeGL()
             for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
                  evt != (event_list.value())->end(); ++evt)
             {
+                visited++;
                 // Out of step span test
                 if ((*evt)->step < bottomStep || (*evt)->step > topStep)
                     continue;
+                drawn++;
 
                 // Calculate position of this bar in float space
                 if (options->showAggregateSteps || !trace->use_aggregates)
@@ -638,7 +683,6 @@ void StepVis::drawNativeGL()
                 else
                     x = ((*evt)->step - startStep) / 2 * barwidth;
 
-                color = options->colormap->color((*evt)->getMetric(metric));
                 if (selected)
                     myopacity = opacity;
                 else
@@ -652,13 +696,8 @@ void StepVis::drawNativeGL()
                 bars.append(y + barheight + yoffset);
                 bars.append(x + barwidth + xoffset);
                 bars.append(y - yoffset);
-                for (int j = 0; j < 4; ++j)
-                {
-                    colors.append(color.red() / 255.0);
-                    colors.append(color.green() / 255.0);
-                    colors.append(color.blue() / 255.0);
-                    colors.append(myopacity);
-                }
+                values.append((*evt)->getMetric(metric));
+                alphas.append(std::min(myopacity, 1.0f) * 255);
 
 
                 if (options->showAggregateSteps) // repeat!
@@ -667,8 +706,6 @@ void StepVis::drawNativeGL()
                     if (x + barwidth <= 0)
                         continue;
 
-                    color = options->colormap->color((*evt)->getMetric(metric, true));
-
                     bars.append(x - xoffset);
                     bars.append(y - yoffset);
                     bars.append(x - xoffset);
@@ -677,23 +714,23 @@ void StepVis::drawNativeGL()
                     bars.append(y + barheight + yoffset);
                     bars.append(x + barwidth + xoffset);
                     bars.append(y - yoffset);
-                    for (int j = 0; j < 4; ++j)
-                    {
-                        colors.append(color.red() / 255.0);
-                        colors.append(color.green() / 255.0);
-                        colors.append(color.blue() / 255.0);
-                        colors.append(myopacity);
-                    }
+                    values.append((*evt)->getMetric(metric, true));
+                    alphas.append(std::min(myopacity, 1.0f) * 255);
                 }
 
             }
         }
     }
+    frameStats.add(FrameStats::FS_TRAVERSAL, walk.nsecsElapsed());
+    frameStats.count(FrameStats::FS_PARTITIONS, partitions);
+    frameStats.count(FrameStats::FS_EVENTS_VISITED, visited);
+    frameStats.count(FrameStats::FS_EVENTS_DRAWN, drawn);
+    QVector<GLubyte> colors = barColors(values, alphas);
 
     // Draw
     glEnableClientState(GL_COLOR_ARRAY);
     glEnableClientState(GL_VERTEX_ARRAY);
-    glColorPointer(4,GL_FLOAT,0,colors.constData());
+    glColorPointer(4,GL_UNSIGNED_BYTE,0,colors.constData());
     glVertexPointer(2,GL_FLOAT,0,bars.constData());
     glDrawArrays(GL_QUADS,0,bars.size()/2);
     glDisableClientState(GL_VERTEX_ARRAY);
@@ -701,6 +738,107 @@ void StepVis::drawNativeGL()
 }
 
 // Qt Event painting
+// Draw a quad per visible cell of the finest pyramid level that is no
+// finer than the pixels. Returns false if there is no suitable level yet.
+bool StepVis::drawPyramidGL(QString metric, bool halfSteps)
+{
+    if (!usePyramid)
+        return false;
+    if (!pyramid || pyramid->getMetric() != metric)
+    {
+        startPyramid(metric);
+        return false;
+    }
+
+    float stepScale = halfSteps ? 0.5 : 1.0; // x units per step
+    int level = pyramid->chooseLevel(1.0 / (stepwidth * stepScale),
+                                     1.0 / entityheight);
+    if (level < 0)
+        return false;
+
+    int stepBin = pyramid->stepBin(level);
+    int entityBin = pyramid->entityBin(level);
+    int firstColumn = std::max(0, int(floor((startStep + 1) / stepBin)));
+    int lastColumn = std::min(pyramid->columns(level) - 1,
+                              int(floor((startStep + stepSpan + 1) / stepBin)));
+    int firstRow = std::max(0, int(floor(startEntity)) / entityBin);
+    int lastRow = std::min(pyramid->rows(level) - 1,
+                           int(ceil(startEntity + entitySpan)) / entityBin);
+    float maxEntity = entitySpan + startEntity;
+
+    QVector<GLfloat> bars = QVector<GLfloat>();
+    QVector<double> values = QVector<double>();
+    int cells = std::max(0, lastColumn - firstColumn + 1)
+                * std::max(0, lastRow - firstRow + 1);
+    bars.reserve(cells * 8);
+    values.reserve(cells);
+
+    // Cells count as events in the frame statistics
+    QElapsedTimer walk;
+    walk.start();
+    StepPyramid::Stats stats;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        float top = maxEntity - row * entityBin;
+        float bottom = top - entityBin;
+        for (int column = firstColumn; column <= lastColumn; column++)
+        {
+            const StepPyramid::Cell& cell = pyramid->cell(level, column, row);
+            stats = cell.events;
+            if (options->showAggregateSteps)
+                stats.add(cell.aggregates);
+            if (!stats.count)
+                continue;
+
+            // Columns start at step -1
+            float left = (column * stepBin - 1 - startStep) * stepScale;
+            float right = left + stepBin * stepScale;
+
+            bars.append(left);
+            bars.append(bottom);
+            bars.append(left);
+            bars.append(top);
+            bars.append(right);
+            bars.append(top);
+            bars.append(right);
+            bars.append(bottom);
+            values.append(stats.mean);
+        }
+    }
+    frameStats.add(FrameStats::FS_TRAVERSAL, walk.nsecsElapsed());
+    frameStats.count(FrameStats::FS_EVENTS_VISITED, cells);
+    frameStats.count(FrameStats::FS_EVENTS_DRAWN, values.size());
+    QVector<GLubyte> colors = barColors(values,
+                                        QVector<GLubyte>(values.size(), 255));
+
+    glEnableClientState(GL_COLOR_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glColorPointer(4,GL_UNSIGNED_BYTE,0,colors.constData());
+    glVertexPointer(2,GL_FLOAT,0,bars.constData());
+    glDrawArrays(GL_QUADS,0,bars.size()/2);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    return true;
+}
+
+// The same span tests paintEvents uses to draw an event
+bool StepVis::commEventShown(CommEvent * evt)
+{
+    if (evt->step < floor(startStep) - 1
+        || evt->step > boundStep(startStep + stepSpan) + 1)
+    {
+        return false;
+    }
+    int position = proc_to_order[evt->entity];
+    if (position < floor(startEntity)
+        || position > ceil(startEntity + entitySpan))
+    {
+        return false;
+    }
+    return floor((position - startEntity) * blockheight) + 1
+           < rect().height() - colorBarHeight;
+}
+
 void StepVis::paintEvents(QPainter * painter)
 {
     // Figure out block sizes. Need integers for qtpaint to align right
@@ -734,7 +872,6 @@ void StepVis::paintEvents(QPainter * painter)
     QString metric(options->metric);
     int position;
     bool complete, aggcomplete;
-    QSet<CommBundle *> drawComms = QSet<CommBundle *>();
     QSet<CommBundle *> selectedComms = QSet<CommBundle *>();
     painter->setPen(QPen(QColor(0, 0, 0)));
     Partition * part = NULL;
@@ -767,6 +904,9 @@ void StepVis::paintEvents(QPainter * painter)
 
 
     // Only do partitions in our range
+    QElapsedTimer walk;
+    walk.start();
+    int partitions = 0, visited = 0, drawn = 0;
     for (int i = startPartition; i < trace->partitions->length(); ++i)
     {
         part = trace->partitions->at(i);
@@ -774,6 +914,7 @@ void StepVis::paintEvents(QPainter * painter)
             break;
         else if (part->max_global_step < bottomStep)
             continue;
+        partitions++;
 
         // Go through events in partition
         for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
@@ -799,6 +940,7 @@ void StepVis::paintEvents(QPainter * painter)
             for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
                  evt != (event_list.value())->end(); ++evt)
             {
+                visited++;
                  // Out of step span test
                 if ((*evt)->step < bottomStep || (*evt)->step > topStep)
                 {
@@ -837,6 +979,7 @@ void StepVis::paintEvents(QPainter * painter)
                     myopacity = 1.0;
                 painter->setPen(QPen(QColor(0, 0, 0, myopacity*255)));
                 // Draw the event
+                drawn++;
                 if ((*evt)->hasMetric(metric))
                     painter->fillRect(QRectF(x, y, w, h),
                                       QBrush(options->colormap->color((*evt)->getMetric(metric),
@@ -860,8 +1003,7 @@ void StepVis::paintEvents(QPainter * painter)
                     painter->setPen(QPen(QColor(0, 0, 0)));
 
 
-                // Save messages for the end since they draw on top
-                (*evt)->addComms(&drawComms);
+                // Messages are drawn at the end since they draw on top
                 if (*evt == selected_event)
                 {
                     if (overdraw_selected)
@@ -910,15 +1052,19 @@ void StepVis::paintEvents(QPainter * painter)
                         painter->setPen(QPen(QColor(0, 0, 0)));
 
                     // For selection
-                    drawnEvents[*evt] = QRect(xa, y, (x - xa) + w, h);
+                    drawnEvents.insert(*evt, QRect(xa, y, (x - xa) + w, h));
                 } else {
                     // For selection
-                    drawnEvents[*evt] = QRect(x, y, w, h);
+                    drawnEvents.insert(*evt, QRect(x, y, w, h));
                 }
 
             }
         }
     }
+    frameStats.add(FrameStats::FS_TRAVERSAL, walk.nsecsElapsed());
+    frameStats.count(FrameStats::FS_PARTITIONS, partitions);
+    frameStats.count(FrameStats::FS_EVENTS_VISITED, visited);
+    frameStats.count(FrameStats::FS_EVENTS_DRAWN, drawn);
 
     // Messages
     // We need to do all of the message drawing after the event drawing
@@ -934,24 +1080,12 @@ void StepVis::paintEvents(QPainter * painter)
         else
             ellipse_height = 3;
 
-        for (QSet<CommBundle *>::Iterator comm = drawComms.begin();
-             comm != drawComms.end(); ++comm)
-        {
-            if (!selectedComms.contains(*comm))
-                (*comm)->draw(painter, this);
-        }
-
-        // Now draw selected
-        for (QSet<CommBundle *>::Iterator comm = selectedComms.begin();
-             comm != selectedComms.end(); ++comm)
-        {
-            (*comm)->draw(painter, this);
-        }
+        drawCommBundles(painter, bottomStep, topStep, &selectedComms);
     }
 
     if (selected_event && options->traceBack)
     {
-        selected_event->track_delay(painter, this);
+        trackDelay(painter, selected_event);
     }
 
     if (overdraw_selected)
@@ -1282,20 +1416,42 @@ void StepVis::drawLine(QPainter * painter, QPointF * p1, QPointF * p2)
     {
         float slope = float(p1->y() - p2->y()) / (p1->x() - p2->x());
         float intercept = p1->y() - slope * p1->x();
-        painter->drawLine(QPointF((effectiveHeight - intercept) / slope,
-                                  effectiveHeight), *p2);
+        drawCommLine(painter, QPointF((effectiveHeight - intercept) / slope,
+                                      effectiveHeight), *p2);
     }
     else if (p2->y() > effectiveHeight)
     {
         float slope = float(p1->y() - p2->y()) / (p1->x() - p2->x());
         float intercept = p1->y() - slope * p1->x();
-        painter->drawLine(*p1, QPointF((effectiveHeight - intercept) / slope,
-                                       effectiveHeight));
+        drawCommLine(painter, *p1, QPointF((effectiveHeight - intercept) / slope,
+                                           effectiveHeight));
     }
     else
     {
-        painter->drawLine(*p1, *p2);
+        drawCommLine(painter, *p1, *p2);
+    }
+}
+
+// RGBA for each corner of each bar, from the colormap in one batch
+QVector<GLubyte> StepVis::barColors(const QVector<double> &values,
+                                    const QVector<GLubyte> &alphas)
+{
+    QVector<QRgb> rgb(values.size());
+    options->colormap->color(values.constData(), values.size(), rgb.data());
+
+    QVector<GLubyte> colors(values.size() * 16);
+    GLubyte * corner = colors.data();
+    for (int i = 0; i < values.size(); i++)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            *corner++ = qRed(rgb[i]);
+            *corner++ = qGreen(rgb[i]);
+            *corner++ = qBlue(rgb[i]);
+            *corner++ = alphas[i];
+        }
     }
+    return colors;
 }
 
 void StepVis::drawColorBarGL()
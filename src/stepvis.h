@@ -26,9 +26,11 @@
 #define STEPVIS_H
 
 #include "timelinevis.h"
+#include <QFutureWatcher>
 
 class MetricRangeDialog;
 class CommEvent;
+class StepPyramid;
 
 // Logical timeline vis
 class StepVis : public TimelineVis
@@ -39,6 +41,8 @@ public:
     ~StepVis();
     void setTrace(Trace * t);
     void processVis();
+    void clear();
+    void countMemory(MemoryCensus * census);
 
     void mouseMoveEvent(QMouseEvent * event);
     void wheelEvent(QWheelEvent * event);
@@ -58,13 +62,23 @@ public slots:
     void setSteps(float start, float stop, bool jump = false);
     void setMaxMetric(long long int new_max);
 
+private slots:
+    void pyramidBuilt();
+
 protected:
     void qtPaint(QPainter *painter);
     void drawNativeGL();
+    bool drawPyramidGL(QString metric, bool halfSteps);
+    void startPyramid(QString metric);
+    void stopPyramid();
     void paintEvents(QPainter *painter);
+    bool commEventShown(CommEvent * evt);
     void prepaint();
+    bool viewRange(ViewRange * range);
     void overdrawSelected(QPainter *painter, QList<int> entities);
     void drawColorBarGL();
+    QVector<GLubyte> barColors(const QVector<double> &values,
+                               const QVector<GLubyte> &alphas);
     void drawColorBarText(QPainter * painter);
     void drawCollective(QPainter * painter, CollectiveRecord * cr,
                         int ellipse_width, int ellipse_height,
@@ -95,6 +109,13 @@ private:
 
     QMap<int, QColor> * groupColorMap;
 
+    // Summary for zoomed out drawing, built in the background for large
+    // traces
+    bool usePyramid;
+    StepPyramid * pyramid;
+    StepPyramid * pendingPyramid;
+    QFutureWatcher<void> pyramidWatcher;
+
     static const int colorBarHeight = 24;
 };
 
@@ -22,20 +22,32 @@
 // along with this program; if not, write to the Free Software Foundation,
 // Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 //////////////////////////////////////////////////////////////////////////////
-#ifndef COMMDRAWINTERFACE_H
-#define COMMDRAWINTERFACE_H
+#ifndef STRIDEINFO_H
+#define STRIDEINFO_H
+
+#include <QSet>
 
-class QPainter;
-class Message;
-class CollectiveRecord;
 class CommEvent;
 
-class CommDrawInterface
+// Scratch state used only while a partition is having its receives
+// reordered and its steps assigned. The partition owns these for the length
+// of that pass and releases them afterwards, so events do not carry the
+// stride graph around for the lifetime of the trace.
+class StrideInfo
 {
 public:
-    virtual void drawMessage(QPainter * painter, Message * message)=0;
-    virtual void drawCollective(QPainter * painter, CollectiveRecord * cr)=0;
-    virtual void drawDelayTracking(QPainter * painter, CommEvent * p2p)=0;
+    StrideInfo()
+        : last_stride(NULL),
+          next_stride(NULL),
+          stride_parents(QSet<CommEvent *>()),
+          stride_children(QSet<CommEvent *>()),
+          stride(-1) {}
+
+    CommEvent * last_stride;
+    CommEvent * next_stride;
+    QSet<CommEvent *> stride_parents;
+    QSet<CommEvent *> stride_children;
+    int stride;
 };
 
-#endif // COMMDRAWINTERFACE_H
+#endif // STRIDEINFO_H
@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "timeindex.h"
+#include "event.h"
+#include <algorithm>
+
+TimeIndex::TimeIndex(QVector<Event *> * _roots)
+    : roots(new QVector<Event *>(*_roots)),
+      max_exits(new QVector<unsigned long long>())
+{
+    qSort(roots->begin(), roots->end(), Event::eventEnterLessThan);
+
+    unsigned long long max_exit = 0;
+    max_exits->reserve(roots->size());
+    for (QVector<Event *>::Iterator root = roots->begin();
+         root != roots->end(); ++root)
+    {
+        (*root)->sortCallees();
+        max_exit = std::max(max_exit, (*root)->subtreeEnd());
+        max_exits->append(max_exit);
+    }
+}
+
+TimeIndex::~TimeIndex()
+{
+    // Events belong to the trace
+    delete roots;
+    delete max_exits;
+}
+
+// First root whose subtree has not finished by start. As max_exits
+// never decreases, everything before it ends before start.
+int TimeIndex::firstRoot(unsigned long long start)
+{
+    int low = 0, high = max_exits->size();
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (max_exits->at(mid) < start)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Last root that has entered by stop, -1 if there is none
+int TimeIndex::lastRoot(unsigned long long stop)
+{
+    int low = 0, high = roots->size();
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (roots->at(mid)->enter <= stop)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low - 1;
+}
+
+Event * TimeIndex::findEvent(unsigned long long time)
+{
+    Event * found = NULL;
+    int last = lastRoot(time);
+    for (int i = firstRoot(time); i <= last; i++)
+    {
+        found = roots->at(i)->findChild(time);
+        if (found)
+            return found;
+    }
+    return found;
+}
+
+void TimeIndex::findEvents(unsigned long long start, unsigned long long stop,
+                           QVector<Event *> * results)
+{
+    int last = lastRoot(stop);
+    for (int i = firstRoot(start); i <= last; i++)
+    {
+        roots->at(i)->findOverlapping(start, stop, results);
+    }
+}
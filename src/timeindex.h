@@ -22,5 +22,37 @@
 // along with this program; if not, write to the Free Software Foundation,
 // Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 //////////////////////////////////////////////////////////////////////////////
-#include "commdrawinterface.h"
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
 
+#include <QVector>
+
+class Event;
+
+// Index over the call tree roots of one entity for time lookups.
+// Roots are kept sorted by enter time alongside the running maximum of
+// their subtree exits, so both point and range queries are binary searches
+// even if roots happen to overlap.
+class TimeIndex
+{
+public:
+    TimeIndex(QVector<Event *> * _roots);
+    ~TimeIndex();
+
+    // Smallest event containing time, NULL if there is none
+    Event * findEvent(unsigned long long time);
+
+    // All events (at any depth) overlapping [start, stop]
+    void findEvents(unsigned long long start, unsigned long long stop,
+                    QVector<Event *> * results);
+
+    // Range of roots that may overlap [start, stop] is firstRoot(start)
+    // through lastRoot(stop) inclusive
+    int firstRoot(unsigned long long start);
+    int lastRoot(unsigned long long stop);
+
+    QVector<Event *> * roots;
+    QVector<unsigned long long> * max_exits;
+};
+
+#endif // TIMEINDEX_H
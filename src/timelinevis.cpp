@@ -33,6 +33,7 @@
 
 #include "trace.h"
 #include "event.h"
+#include "commevent.h"
 #include "function.h"
 #include "rpartition.h"
 #include "entity.h"
@@ -126,58 +127,55 @@ void TimelineVis::mouseDoubleClickEvent(QMouseEvent * event)
 
     int x = event->x();
     int y = event->y();
-    for (QMap<Event *, QRect>::Iterator evt = drawnEvents.begin();
-         evt != drawnEvents.end(); ++evt)
+    QRect evtRect;
+    Event * evt = findDrawnEvent(x, y, &evtRect);
+    if (evt) // We've found the event
     {
-        if (evt.value().contains(x,y)) // We've found the event
+        if (evt == selected_event) // We were in this event
         {
-            if (evt.key() == selected_event) // We were in this event
+            if (options->showAggregateSteps)
             {
-                if (options->showAggregateSteps)
+                // we're in the aggregate event
+                if (x < evtRect.x() + evtRect.width() / 2)
                 {
-                    // we're in the aggregate event
-                    if (x < evt.value().x() + evt.value().width() / 2)
+                    if (selected_aggregate)
                     {
-                        if (selected_aggregate)
-                        {
-                            selected_event = NULL;
-                            selected_aggregate = false;
-                        }
-                        else
-                        {
-                            selected_aggregate = true;
-                        }
+                        selected_event = NULL;
+                        selected_aggregate = false;
                     }
-                    else // We're in the normal event
+                    else
                     {
-                        if (selected_aggregate)
-                        {
-                            selected_aggregate = false;
-                        }
-                        else
-                        {
-                            selected_event = NULL;
-                        }
+                        selected_aggregate = true;
                     }
                 }
-                else
-                    selected_event = NULL;
-            }
-            else // This is a new event to us
-            {
-                // we're in the aggregate event
-                if (options->showAggregateSteps
-                    && x < evt.value().x() + evt.value().width() / 2)
-                {
-                    selected_aggregate = true;
-                }
-                else
+                else // We're in the normal event
                 {
-                    selected_aggregate = false;
+                    if (selected_aggregate)
+                    {
+                        selected_aggregate = false;
+                    }
+                    else
+                    {
+                        selected_event = NULL;
+                    }
                 }
-                selected_event = evt.key();
             }
-            break;
+            else
+                selected_event = NULL;
+        }
+        else // This is a new event to us
+        {
+            // we're in the aggregate event
+            if (options->showAggregateSteps
+                && x < evtRect.x() + evtRect.width() / 2)
+            {
+                selected_aggregate = true;
+            }
+            else
+            {
+                selected_aggregate = false;
+            }
+            selected_event = evt;
         }
     }
 
@@ -264,9 +262,19 @@ void TimelineVis::drawHover(QPainter * painter)
     QFontMetrics font_metrics = painter->fontMetrics();
 
     QString text = "";
-    if (hover_aggregate) // Do not draw
+    if (hover_aggregate)
     {
-        return;
+        // Name the function the aggregate event spends most time in
+        if (!trace->use_aggregates || !hover_event->isCommEvent())
+            return;
+
+        QList<Trace::FunctionPair> fps
+                = trace->getAggregateFunctions(static_cast<CommEvent *>(hover_event));
+        if (fps.isEmpty())
+            return;
+
+        qSort(fps);
+        text = trace->functions->value(fps.first().fxn)->name;
     }
     else
     {
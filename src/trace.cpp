@@ -28,6 +28,7 @@
 #include <fstream>
 #include <QElapsedTimer>
 #include <QTime>
+#include <QtConcurrent>
 #include <cmath>
 #include <climits>
 #include <cfloat>
@@ -47,6 +48,15 @@
 #include "ravelutils.h"
 #include "primaryentitygroup.h"
 #include "metrics.h"
+#include "timeindex.h"
+#include "aggregateprofiles.h"
+#include "aggregatesteptotals.h"
+#include "stephistogram.h"
+#include "tracesummary.h"
+#include "commindex.h"
+#include "stagetimer.h"
+#include "selfprofiler.h"
+#include "memorycensus.h"
 
 Trace::Trace(int nt, int np)
     : name(""),
@@ -72,6 +82,12 @@ Trace::Trace(int nt, int np)
       collectiveMap(NULL),
       events(new QVector<QVector<Event *> *>(std::max(nt, np))),
       roots(new QVector<QVector<Event *> *>(std::max(nt, np))),
+      time_indices(NULL),
+      aggregate_profiles(NULL),
+      aggregate_totals(NULL),
+      step_histograms(NULL),
+      summary(NULL),
+      comm_index(NULL),
       mpi_group(-1),
       global_max_step(-1),
       dag_entries(new QList<Partition *>()),
@@ -89,10 +105,12 @@ Trace::Trace(int nt, int np)
     }
 
     gnomes->append(new ExchangeGnome());
+    MemoryCensus::watch(this);
 }
 
 Trace::~Trace()
 {
+    MemoryCensus::unwatch(this);
     delete metrics;
     delete metric_units;
     delete functionGroups;
@@ -136,6 +154,20 @@ Trace::~Trace()
     }
     delete roots;
 
+    if (time_indices)
+    {
+        for (QVector<TimeIndex *>::Iterator index = time_indices->begin();
+             index != time_indices->end(); ++index)
+        {
+            delete *index;
+        }
+        delete time_indices;
+    }
+    deleteAggregateProfiles();
+    deleteStepHistograms();
+    delete summary;
+    delete comm_index;
+
     for (QList<Gnome *>::Iterator gnome = gnomes->begin();
          gnome != gnomes->end(); ++gnome)
     {
@@ -190,6 +222,7 @@ Trace::~Trace()
 
 void Trace::preprocess(ImportOptions * _options)
 {
+    SelfProfiler::Span span("preprocess");
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
 
@@ -211,6 +244,12 @@ void Trace::preprocess(ImportOptions * _options)
     qSort(partitions->begin(), partitions->end(),
           dereferencedLessThan<Partition>);
     addPartitionMetric(); // For debugging
+    buildTimeIndex();
+    if (use_aggregates)
+        calculateAggregateProfiles();
+    calculateStepHistograms();
+    calculateSummary();
+    buildCommIndex();
 
     isProcessed = true;
 
@@ -221,6 +260,7 @@ void Trace::preprocess(ImportOptions * _options)
 
 void Trace::preprocessFromSaved()
 {
+    SelfProfiler::Span span("preprocessFromSaved");
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
 
@@ -245,6 +285,12 @@ void Trace::preprocessFromSaved()
 
     qSort(partitions->begin(), partitions->end(),
           dereferencedLessThan<Partition>);
+    buildTimeIndex();
+    if (use_aggregates)
+        calculateAggregateProfiles();
+    calculateStepHistograms();
+    calculateSummary();
+    buildCommIndex();
 
     isProcessed = true;
 
@@ -257,6 +303,7 @@ void Trace::preprocessFromSaved()
 // easily parallelized by partition
 void Trace::gnomify()
 {
+    StageTimer stageTimer("gnomify");
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
 
@@ -292,6 +339,8 @@ void Trace::gnomify()
                 (*part)->gnome_type = i;
                 (*part)->gnome = gnome->create();
                 (*part)->gnome->set_seed(options.clusterSeed);
+                (*part)->gnome->set_clusters(options.maxClusters,
+                                             options.autoClusters);
                 (*part)->gnome->setPartition(*part);
                 (*part)->gnome->setFunctions(functions);
                 if (options.origin != ImportOptions::OF_SAVE_OTF2)
@@ -305,6 +354,8 @@ void Trace::gnomify()
             (*part)->gnome_type = -1;
             (*part)->gnome = new Gnome();
             (*part)->gnome->set_seed(options.clusterSeed);
+            (*part)->gnome->set_clusters(options.maxClusters,
+                                         options.autoClusters);
             (*part)->gnome->setPartition(*part);
             (*part)->gnome->setFunctions(functions);
             if (options.origin != ImportOptions::OF_SAVE_OTF2)
@@ -359,6 +410,7 @@ void Trace::addPartitionMetric()
 
 void Trace::partition()
 {
+    SelfProfiler::Span span("partition");
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
 
@@ -864,6 +916,7 @@ void Trace::calculate_partition_lateness()
 // Calculates lateness per global step
 void Trace::calculate_lateness()
 {
+    StageTimer stageTimer("calculate_lateness");
     metrics->append("G. Lateness");
     (*metric_units)["G. Lateness"] = RavelUtils::getUnits(units);
     metrics->append("Colorless");
@@ -1025,6 +1078,8 @@ void Trace::finalizeEntityEventOrder()
 // not broken due to runtime, so would this be.
 void Trace::mergeForEntryRepair(bool entries)
 {
+    StageTimer stageTimer("mergeForEntryRepair");
+    SelfProfiler::counter("partitions", partitions->size());
     print_partition_info("Repairing entries...");
     QString debug_step = "7";
     if (entries)
@@ -1286,11 +1341,14 @@ void Trace::mergeForEntryRepair(bool entries)
     set_dag_steps();
 
     delete new_partitions;
+    SelfProfiler::counter("partitions", partitions->size());
 }
 
 // Ordering between unordered sends and merging
 void Trace::mergeForCharmLeaps()
 {
+    StageTimer stageTimer("mergeForCharmLeaps");
+    SelfProfiler::counter("partitions", partitions->size());
     print_partition_info("Forcing partition dag of unordered sends...",
                           "9a-tracegraph-pretrue", true, true);
 
@@ -1540,6 +1598,7 @@ void Trace::mergeForCharmLeaps()
             count++;
         }
     }
+    SelfProfiler::counter("partitions", partitions->size());
 }
 
 
@@ -1748,6 +1807,7 @@ void Trace::forcePartitionDag()
 // Iterates through all partitions and sets the steps
 void Trace::assignSteps()
 {
+    StageTimer stageTimer("assignSteps");
     // Step
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
@@ -1778,7 +1838,19 @@ void Trace::assignSteps()
         traceElapsed = traceTimer.nsecsElapsed();
         RavelUtils::gu_printTime(traceElapsed, "Enforcing Partition Dag: ");
         print_partition_info("", "11-tracegraph-after", true);
+    }
 
+    // Partitions are fixed from here on, so set up the stride state
+    // used by reordering and stepping. Each partition releases it as
+    // soon as its steps are assigned.
+    for (QList<Partition *>::Iterator part = partitions->begin();
+         part != partitions->end(); ++part)
+    {
+        (*part)->initializeStrideInfo();
+    }
+
+    if (options.origin == ImportOptions::OF_CHARM)
+    {
         finalizeEntityEventOrder();
     }
     else if (options.reorderReceives)
@@ -1814,6 +1886,7 @@ void Trace::assignSteps()
             ++currentIter;
             (*partition)->debug_name = currentIter;
             (*partition)->step();
+            (*partition)->releaseStrideInfo();
         }
     } else {
         for (QList<Partition *>::Iterator partition = partitions->begin();
@@ -1828,6 +1901,7 @@ void Trace::assignSteps()
             ++currentIter;
             (*partition)->debug_name = currentIter;
             (*partition)->basic_step();
+            (*partition)->releaseStrideInfo();
         }
     }
     traceElapsed = traceTimer.nsecsElapsed();
@@ -1872,6 +1946,8 @@ void Trace::assignSteps()
 // At least that's consistent!
 void Trace::mergeByLeap()
 {
+    StageTimer stageTimer("mergeByLeap");
+    SelfProfiler::counter("partitions", partitions->size());
     int leap = 0;
     QSet<Partition *> * new_partitions = new QSet<Partition *>();
     QSet<Partition *> * current_leap = new QSet<Partition *>();
@@ -2242,6 +2318,7 @@ void Trace::mergeByLeap()
     set_dag_steps();
 
     delete new_partitions;
+    SelfProfiler::counter("partitions", partitions->size());
 }
 
 
@@ -2455,6 +2532,7 @@ void Trace::mergeForMessagesHelper(Partition * part,
 // Loop through the partitions and merge all connected by messages.
 void Trace::mergeForMessages()
 {
+    StageTimer stageTimer("mergeForMessages");
     int progressPortion = std::max(round(partitions->size() / 1.0 / 35),1.0);
     int currentPortion = 0;
     int currentIter = 0;
@@ -2618,6 +2696,7 @@ QList<QList<Partition *> *> * Trace::tarjan()
 // Goes through current partitions and merges cycles
 void Trace::mergeCycles()
 {
+    StageTimer stageTimer("mergeCycles");
     // Determine partition parents/children through dag
     // and then determine strongly connected components (SCCs) with tarjan.
     emit(updatePreprocess(41, "Merging cycles..."));
@@ -2626,6 +2705,20 @@ void Trace::mergeCycles()
 
     std::cout << "Tarjan... " << std::endl;
     QList<QList<Partition *> *> * components = tarjan();
+    if (SelfProfiler::isEnabled())
+    {
+        int largest = 0, cyclic = 0;
+        for (QList<QList<Partition *> *>::Iterator component = components->begin();
+             component != components->end(); ++component)
+        {
+            largest = std::max(largest, (*component)->size());
+            if ((*component)->size() > 1)
+                cyclic++;
+        }
+        SelfProfiler::counter("SCCs", components->size());
+        SelfProfiler::counter("cyclic SCCs", cyclic);
+        SelfProfiler::counter("largest SCC", largest);
+    }
     emit(updatePreprocess(43, "Merging cycles..."));
 
     std::cout << "Merging from the cycles..." << std::endl;
@@ -2638,6 +2731,8 @@ void Trace::mergeCycles()
 // into a single partition. This updates parent/child relationships so
 // there is no need to reset the dag.
 void Trace::mergePartitions(QList<QList<Partition *> *> * components) {
+    SelfProfiler::Span span("mergePartitions");
+    SelfProfiler::counter("partitions", partitions->size());
     QElapsedTimer traceTimer;
     qint64 traceElapsed;
     traceTimer.start();
@@ -2800,6 +2895,8 @@ void Trace::mergePartitions(QList<QList<Partition *> *> * components) {
         (*part)->new_partition = NULL;
     }
 
+    SelfProfiler::counter("partitions", partitions->size());
+
     traceElapsed = traceTimer.nsecsElapsed();
     RavelUtils::gu_printTime(traceElapsed, "Partition Merge: ");
 }
@@ -2997,74 +3094,233 @@ void Trace::set_dag_steps()
 }
 
 
-// In progress: will be used for extra information on aggregate events
-QList<Trace::FunctionPair> Trace::getAggregateFunctions(CommEvent * evt)
+static void calculateEntityProfiles(AggregateProfiles * profiles)
 {
-    unsigned long long int stoptime = evt->enter;
-    unsigned long long int starttime = 0;
-    if (evt->comm_prev)
-        starttime = evt->comm_prev->exit;
+    SelfProfiler::Span span("calculateEntityProfiles");
+    profiles->calculate();
+}
+
+// Aggregate event profiles are computed once per entity rather than walking
+// the call trees on every query. Entities are independent and the call
+// trees are only read here, so they are handled concurrently.
+void Trace::calculateAggregateProfiles()
+{
+    StageTimer stageTimer("calculateAggregateProfiles");
+    QElapsedTimer traceTimer;
+    qint64 traceElapsed;
+
+    traceTimer.start();
 
-    QVector<Event *> * proots = roots->at(evt->entity);
-    QMap<int, FunctionPair> * fpMap = new QMap<int, FunctionPair>();
+    if (!time_indices)
+        buildTimeIndex();
 
-    for (QVector<Event *>::Iterator root = proots->begin();
-         root != proots->end(); ++root)
+    deleteAggregateProfiles();
+    aggregate_profiles = new QVector<AggregateProfiles *>(roots->size());
+    for (int i = 0; i < roots->size(); i++)
     {
-        getAggregateFunctionRecurse(*root, fpMap, starttime, stoptime);
+        (*aggregate_profiles)[i] = new AggregateProfiles(time_indices->at(i));
     }
 
-    QList<FunctionPair> fpList = fpMap->values();
-    delete fpMap;
-    return fpList;
+    for (QList<Partition *>::Iterator part = partitions->begin();
+         part != partitions->end(); ++part)
+    {
+        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            if (event_list.key() >= (unsigned long) roots->size())
+                continue;
+
+            AggregateProfiles * profiles
+                    = aggregate_profiles->at(event_list.key());
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                profiles->addEvent(*evt);
+            }
+        }
+    }
+
+    QtConcurrent::blockingMap(*aggregate_profiles, calculateEntityProfiles);
+
+    aggregate_totals = new AggregateStepTotals();
+    aggregate_totals->build(aggregate_profiles);
+
+    traceElapsed = traceTimer.nsecsElapsed();
+    RavelUtils::gu_printTime(traceElapsed, "Aggregate Profiles: ");
+}
+
+void Trace::deleteAggregateProfiles()
+{
+    if (!aggregate_profiles)
+        return;
+
+    for (QVector<AggregateProfiles *>::Iterator profiles
+         = aggregate_profiles->begin();
+         profiles != aggregate_profiles->end(); ++profiles)
+    {
+        delete *profiles;
+    }
+    delete aggregate_profiles;
+    aggregate_profiles = NULL;
+    delete aggregate_totals;
+    aggregate_totals = NULL;
 }
 
-long long int Trace::getAggregateFunctionRecurse(Event * evt,
-                                                 QMap<int, FunctionPair> * fpMap,
-                                                 unsigned long long start,
-                                                 unsigned long long stop)
+static void buildStepHistogram(StepHistogram * histogram)
 {
-    if (evt->enter > stop || evt->exit < start)
-        return 0;
+    SelfProfiler::Span span("buildStepHistogram");
+    histogram->build();
+}
+
+// Per step metric sums for the overview and each metric's range and
+// distribution for the summary, one pass over the events per metric. The
+// metrics are independent so they are built concurrently.
+void Trace::calculateStepHistograms()
+{
+    StageTimer stageTimer("calculateStepHistograms");
 
-    unsigned long long overlap_stop = std::min(stop, evt->exit);
-    unsigned long long overlap_start = std::max(start, evt->enter);
-    long long overlap = overlap_stop - overlap_start;
-    long long child_overlap;
-    for (QVector<Event *>::Iterator child = evt->callees->begin();
-         child != evt->callees->end(); ++child)
+    deleteStepHistograms();
+    step_histograms = new QMap<QString, StepHistogram *>();
+    QVector<StepHistogram *> histograms;
+    for (QList<QString>::Iterator metric = metrics->begin();
+         metric != metrics->end(); ++metric)
     {
-        child_overlap = getAggregateFunctionRecurse(*child, fpMap,
-                                                    start, stop);
-        overlap -= child_overlap;
+        if (step_histograms->contains(*metric))
+            continue;
+        StepHistogram * histogram = new StepHistogram(this, *metric);
+        step_histograms->insert(*metric, histogram);
+        histograms.append(histogram);
     }
 
-    if (fpMap->contains(evt->function))
+    QtConcurrent::blockingMap(histograms, buildStepHistogram);
+}
+
+void Trace::calculateSummary()
+{
+    delete summary;
+    summary = new TraceSummary(this);
+    summary->build();
+}
+
+void Trace::buildCommIndex()
+{
+    StageTimer stageTimer("buildCommIndex");
+    delete comm_index;
+    comm_index = new CommIndex();
+    comm_index->build(this);
+}
+
+// Metrics added after loading are summed the first time they are asked for
+StepHistogram * Trace::getStepHistogram(QString metric)
+{
+    if (!step_histograms)
+        step_histograms = new QMap<QString, StepHistogram *>();
+
+    StepHistogram * histogram = step_histograms->value(metric, NULL);
+    if (!histogram)
     {
-        FunctionPair oldfp = fpMap->value(evt->function);
-        (*fpMap)[evt->function] = FunctionPair(evt->function,
-                                               oldfp.time + overlap);
+        histogram = new StepHistogram(this, metric);
+        histogram->build();
+        step_histograms->insert(metric, histogram);
     }
-    else
+    return histogram;
+}
+
+void Trace::deleteStepHistograms()
+{
+    if (!step_histograms)
+        return;
+
+    for (QMap<QString, StepHistogram *>::Iterator histogram
+         = step_histograms->begin();
+         histogram != step_histograms->end(); ++histogram)
     {
-        (*fpMap)[evt->function] = FunctionPair(evt->function, overlap);
+        delete histogram.value();
     }
-    return overlap;
+    delete step_histograms;
+    step_histograms = NULL;
 }
 
-// Find the smallest event in a timeline that contains the given time
-Event * Trace::findEvent(int entity, unsigned long long time)
+// Time spent in each function in the aggregate event before evt
+QList<Trace::FunctionPair> Trace::getAggregateFunctions(CommEvent * evt)
+{
+    if (!aggregate_profiles)
+        calculateAggregateProfiles();
+
+    if (evt->entity >= (unsigned long) aggregate_profiles->size())
+        return QList<FunctionPair>();
+
+    return aggregate_profiles->at(evt->entity)->getProfile(evt);
+}
+
+// The functions taking the most time across all aggregate events whose
+// comm event falls in [start_step, stop_step], greatest first
+QList<Trace::FunctionPair> Trace::getTopAggregateFunctions(int start_step,
+                                                           int stop_step,
+                                                           int count)
 {
-    Event * found = NULL;
-    for (QVector<Event *>::Iterator root = roots->at(entity)->begin();
-         root != roots->at(entity)->end(); ++root)
+    if (!aggregate_profiles)
+        calculateAggregateProfiles();
+
+    QMap<int, long long int> * totals = new QMap<int, long long int>();
+    aggregate_totals->addTotals(start_step, stop_step, totals);
+
+    QList<FunctionPair> fpList = QList<FunctionPair>();
+    for (QMap<int, long long int>::Iterator fxn = totals->begin();
+         fxn != totals->end(); ++fxn)
     {
-        found = (*root)->findChild(time);
-        if (found)
-            return found;
+        fpList.append(FunctionPair(fxn.key(), fxn.value()));
+    }
+    delete totals;
+
+    qSort(fpList);
+    if (count >= 0 && fpList.size() > count)
+        fpList = fpList.mid(0, count);
+    return fpList;
+}
+
+// Index the call tree roots of every entity by time. The call trees
+// must be complete, so this happens once processing is finished.
+void Trace::buildTimeIndex()
+{
+    StageTimer stageTimer("buildTimeIndex");
+    // Profiles refer to the old index
+    deleteAggregateProfiles();
+    if (time_indices)
+    {
+        for (QVector<TimeIndex *>::Iterator index = time_indices->begin();
+             index != time_indices->end(); ++index)
+        {
+            delete *index;
+        }
+        delete time_indices;
     }
 
-    return found;
+    time_indices = new QVector<TimeIndex *>(roots->size());
+    for (int i = 0; i < roots->size(); i++)
+    {
+        (*time_indices)[i] = new TimeIndex(roots->at(i));
+    }
+}
+
+// Find the smallest event in a timeline that contains the given time
+Event * Trace::findEvent(int entity, unsigned long long time)
+{
+    if (!time_indices)
+        buildTimeIndex();
+
+    return time_indices->at(entity)->findEvent(time);
+}
+
+// Find all events in a timeline overlapping [start, stop]
+void Trace::findEvents(int entity, unsigned long long start,
+                       unsigned long long stop, QVector<Event *> * results)
+{
+    if (!time_indices)
+        buildTimeIndex();
+
+    time_indices->at(entity)->findEvents(start, stop, results);
 }
 
 void Trace::clear_dag_step_dict()
@@ -46,6 +46,12 @@ class EntityGroup;
 class PrimaryEntityGroup;
 class OTFCollective;
 class CollectiveRecord;
+class TimeIndex;
+class AggregateProfiles;
+class AggregateStepTotals;
+class StepHistogram;
+class TraceSummary;
+class CommIndex;
 
 class Trace : public QObject
 {
@@ -60,7 +66,12 @@ public:
     void assignSteps();
     void gnomify();
     void mergePartitions(QList<QList<Partition *> *> * components);
+
+    // Time lookups on the call trees
+    void buildTimeIndex();
     Event * findEvent(int entity, unsigned long long time);
+    void findEvents(int entity, unsigned long long start,
+                    unsigned long long stop, QVector<Event *> * results);
 
     QString name;
     QString fullpath;
@@ -93,6 +104,12 @@ public:
 
     QVector<QVector<Event *> *> * events; // This is going to be by entities
     QVector<QVector<Event *> *> * roots; // Roots of call trees per pe
+    QVector<TimeIndex *> * time_indices; // Sorted roots per entity
+    QVector<AggregateProfiles *> * aggregate_profiles; // Per entity
+    AggregateStepTotals * aggregate_totals; // Profiles summed by step
+    QMap<QString, StepHistogram *> * step_histograms; // Per metric
+    TraceSummary * summary; // Shared bounds and metric ranges
+    CommIndex * comm_index; // Messages and collectives by step
 
     int mpi_group; // functionGroup index of "MPI" functions
 
@@ -120,7 +137,14 @@ public:
         int fxn;
         long long int time;
     };
+    void calculateAggregateProfiles();
+    void calculateStepHistograms();
+    void calculateSummary();
+    void buildCommIndex();
+    StepHistogram * getStepHistogram(QString metric);
     QList<FunctionPair> getAggregateFunctions(CommEvent *evt);
+    QList<FunctionPair> getTopAggregateFunctions(int start_step, int stop_step,
+                                                 int count);
 
 signals:
     // This is for progress bars
@@ -188,11 +212,8 @@ private:
     void setGnomeMetric(Partition * part, int gnome_index);
     void addPartitionMetric();
 
-    // Find functions inside aggregate function
-    long long int getAggregateFunctionRecurse(Event * evt,
-                                              QMap<int, FunctionPair> * fpMap,
-                                              unsigned long long start,
-                                              unsigned long long stop);
+    void deleteAggregateProfiles();
+    void deleteStepHistograms();
 
     bool isProcessed; // Partitions exist
 
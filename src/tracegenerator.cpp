@@ -0,0 +1,566 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "tracegenerator.h"
+#include "ravelutils.h"
+#include <QPair>
+#include <QtAlgorithms>
+#include <iostream>
+
+TraceGenerator::TraceGenerator()
+    : entities(16),
+      iterations(10),
+      pattern(GP_HALO),
+      depth(2),
+      counters(0),
+      fanout(4),
+      imbalance(0),
+      noise(0),
+      compute(100000),
+      message_size(1024),
+      seed(0),
+      archive(NULL),
+      global_def_writer(NULL),
+      string_counter(0),
+      event_counts(QVector<uint64_t>()),
+      latency(2000),
+      call_cost(500),
+      max_compute(0),
+      period(0)
+{
+    flush_callbacks.otf2_post_flush = TraceGenerator::post_flush;
+    flush_callbacks.otf2_pre_flush = TraceGenerator::pre_flush;
+}
+
+QList<QString> TraceGenerator::getPatternNames()
+{
+    QList<QString> names;
+    names << "halo" << "alltoall" << "masterworker" << "burst" << "collective";
+    return names;
+}
+
+bool TraceGenerator::setPattern(QString name)
+{
+    int index = getPatternNames().indexOf(name.toLower());
+    if (index < 0)
+        return false;
+
+    pattern = (Pattern) index;
+    return true;
+}
+
+QString TraceGenerator::getPatternName()
+{
+    return getPatternNames().at(pattern);
+}
+
+void TraceGenerator::generateTrace(QString path, QString filename)
+{
+    setupTiming();
+
+    archive = OTF2_Archive_Open(path.toStdString().c_str(),
+                                filename.toStdString().c_str(),
+                                OTF2_FILEMODE_WRITE,
+                                1024 * 1024, 4 * 1024 * 1024,
+                                OTF2_SUBSTRATE_POSIX, OTF2_COMPRESSION_NONE);
+
+    OTF2_Archive_SetFlushCallbacks(archive, &flush_callbacks, NULL);
+    OTF2_Archive_SetSerialCollectiveCallbacks(archive);
+    OTF2_Archive_SetCreator(archive, "Ravel trace generator");
+
+    // Events first so the location definitions know their event counts
+    event_counts = QVector<uint64_t>(entities, 0);
+    OTF2_Archive_OpenEvtFiles(archive);
+    for (int i = 0; i < entities; i++)
+    {
+        writeEntityEvents(i);
+        if (entities >= 10 && (i + 1) % (entities / 10) == 0)
+            std::cout << "Wrote " << (i + 1) << " of " << entities
+                      << " ranks" << std::endl;
+    }
+    OTF2_Archive_CloseEvtFiles(archive);
+
+    writeDefinitions();
+
+    OTF2_Archive_Close(archive);
+    archive = NULL;
+}
+
+// Every time below is bounded so an iteration always fits in one period,
+// that way no rank ever needs to know what any other rank did in a previous
+// iteration.
+void TraceGenerator::setupTiming()
+{
+    if (counters > 255)
+        counters = 255;
+    if (fanout < 1)
+        fanout = 1;
+
+    // Leave room for the nested compute regions
+    if (compute < (unsigned long long) (2 * depth + 1) * call_cost)
+        compute = (2 * depth + 1) * call_cost;
+    max_compute = (unsigned long long) (compute * (1 + imbalance) * (1 + noise)) + 1;
+
+    unsigned long long window = 0;
+    if (pattern == GP_MASTERWORKER)
+        window = 2 * latency + (2 * entities + 4) * call_cost;
+    else if (pattern == GP_COLLECTIVE)
+        window = latency + 2 * call_cost;
+    else
+        window = 2 * latency + (2 * exchangeCount(0) + 4) * call_cost;
+    period = max_compute + window + call_cost;
+}
+
+// Imbalance is a per-rank constant, noise changes every iteration
+unsigned long long TraceGenerator::computeTime(unsigned long entity,
+                                               unsigned long iteration)
+{
+    double slow = 1 + imbalance * RavelUtils::hashRandom(seed, entity, 0, 1);
+    double jitter = 1 + noise * RavelUtils::hashRandom(seed, entity, iteration, 2);
+    return (unsigned long long) (compute * slow * jitter);
+}
+
+unsigned long long TraceGenerator::iterationStart(unsigned long iteration)
+{
+    return call_cost + iteration * period;
+}
+
+// Sends always come first in the exchange patterns so their times only
+// depend on the sender's compute
+unsigned long long TraceGenerator::sendTime(unsigned long entity,
+                                            unsigned long iteration, int index)
+{
+    return iterationStart(iteration) + computeTime(entity, iteration)
+           + index * call_cost + call_cost / 2;
+}
+
+int TraceGenerator::exchangeCount(unsigned long entity)
+{
+    if (pattern == GP_HALO)
+        return entities > 1 ? 2 : 0;
+    else if (pattern == GP_BURST)
+        return qMin(fanout, entities - 1);
+
+    // All-to-all within blocks of fanout + 1 ranks
+    unsigned long block = fanout + 1;
+    unsigned long base = (entity / block) * block;
+    return qMin(block, (unsigned long) entities - base) - 1;
+}
+
+// The index-th message an entity sends goes out with tag index and is
+// the index-th message its partner receives.
+unsigned long TraceGenerator::exchangePartner(unsigned long entity, int index,
+                                              bool send)
+{
+    if (pattern == GP_ALLTOALL)
+    {
+        unsigned long block = fanout + 1;
+        unsigned long base = (entity / block) * block;
+        unsigned long size = qMin(block, (unsigned long) entities - base);
+        unsigned long local = entity - base;
+        if (send)
+            return base + (local + index + 1) % size;
+        return base + (local + size - index - 1) % size;
+    }
+
+    long long offset = index + 1;
+    if (pattern == GP_HALO)
+        offset = (index == 0) ? 1 : -1;
+    if (!send)
+        offset = -offset;
+    return (((long long) entity + offset) % entities + entities) % entities;
+}
+
+void TraceGenerator::writeEntityEvents(unsigned long entity)
+{
+    RankState state;
+    state.writer = OTF2_Archive_GetEvtWriter(archive, entity);
+    state.entity = entity;
+    state.now = 0;
+    state.events = 0;
+    state.request = 0;
+    state.computed = 0;
+
+    enter(&state, GR_MAIN);
+    for (int i = 0; i < iterations; i++)
+        writeIteration(&state, i);
+    state.now = iterationStart(iterations);
+    leave(&state, GR_MAIN);
+
+    event_counts[entity] = state.events;
+    OTF2_Archive_CloseEvtWriter(archive, state.writer);
+}
+
+void TraceGenerator::writeIteration(RankState * state, unsigned long iteration)
+{
+    state->now = qMax(state->now, iterationStart(iteration));
+    writeCompute(state, iteration);
+
+    if (pattern == GP_MASTERWORKER)
+        writeMasterWorker(state, iteration);
+    else if (pattern == GP_COLLECTIVE)
+        writeCollective(state, iteration);
+    else
+        writeExchange(state, iteration);
+}
+
+void TraceGenerator::writeCompute(RankState * state, unsigned long iteration)
+{
+    unsigned long long start = state->now;
+    unsigned long long length = computeTime(state->entity, iteration);
+
+    writeCounters(state);
+    for (int i = 0; i < depth; i++)
+    {
+        state->now = start + i * call_cost;
+        enter(state, GR_COMPUTE + i);
+    }
+    for (int i = depth - 1; i >= 0; i--)
+    {
+        state->now = start + length - i * call_cost;
+        leave(state, GR_COMPUTE + i);
+    }
+    state->now = start + length;
+    state->computed += length;
+    writeCounters(state);
+}
+
+// Rank 0 collects a result from every worker and hands out new work. Its
+// receives start only once every worker's result can have arrived, so the
+// schedule is fixed and workers can find their reply time directly.
+void TraceGenerator::writeMasterWorker(RankState * state,
+                                       unsigned long iteration)
+{
+    unsigned long long collect = iterationStart(iteration) + max_compute
+                                 + call_cost + latency;
+    unsigned long long distribute = collect + (entities - 1) * call_cost;
+
+    if (state->entity == 0)
+    {
+        for (int worker = 1; worker < entities; worker++)
+        {
+            state->now = collect + (worker - 1) * call_cost;
+            enter(state, GR_RECV);
+            state->now += call_cost / 2;
+            OTF2_EvtWriter_MpiRecv(state->writer, NULL, state->now,
+                                   worker, 0, 0, message_size);
+            state->events++;
+            state->now = collect + worker * call_cost;
+            leave(state, GR_RECV);
+        }
+        for (int worker = 1; worker < entities; worker++)
+        {
+            state->now = distribute + (worker - 1) * call_cost;
+            enter(state, GR_SEND);
+            state->now += call_cost / 2;
+            OTF2_EvtWriter_MpiSend(state->writer, NULL, state->now,
+                                   worker, 0, 1, message_size);
+            state->events++;
+            state->now = distribute + worker * call_cost;
+            leave(state, GR_SEND);
+        }
+        return;
+    }
+
+    enter(state, GR_SEND);
+    state->now += call_cost / 2;
+    OTF2_EvtWriter_MpiSend(state->writer, NULL, state->now,
+                           0, 0, 0, message_size);
+    state->events++;
+    state->now += call_cost / 2;
+    leave(state, GR_SEND);
+
+    enter(state, GR_RECV);
+    unsigned long long arrival = distribute + (state->entity - 1) * call_cost
+                                 + call_cost / 2 + latency;
+    state->now = qMax(state->now + call_cost / 2, arrival);
+    OTF2_EvtWriter_MpiRecv(state->writer, NULL, state->now,
+                           0, 0, 1, message_size);
+    state->events++;
+    state->now += call_cost / 2;
+    leave(state, GR_RECV);
+}
+
+// Everyone leaves once the slowest possible rank has arrived
+void TraceGenerator::writeCollective(RankState * state,
+                                     unsigned long iteration)
+{
+    enter(state, GR_ALLREDUCE);
+    state->now += call_cost / 2;
+    OTF2_EvtWriter_MpiCollectiveBegin(state->writer, NULL, state->now);
+    state->events++;
+
+    state->now = iterationStart(iteration) + max_compute + call_cost
+                 + latency;
+    OTF2_EvtWriter_MpiCollectiveEnd(state->writer, NULL, state->now,
+                                    OTF2_COLLECTIVE_OP_ALLREDUCE, 0,
+                                    OTF2_UNDEFINED_UINT32,
+                                    message_size, message_size);
+    state->events++;
+    state->now += call_cost / 2;
+    leave(state, GR_ALLREDUCE);
+}
+
+// Halo uses blocking sends and receives, burst and all-to-all post every
+// Isend and then complete the sends and receives in a single Waitall.
+void TraceGenerator::writeExchange(RankState * state, unsigned long iteration)
+{
+    int count = exchangeCount(state->entity);
+    if (count == 0)
+        return;
+
+    bool blocking = (pattern == GP_HALO);
+    QList<uint64_t> requests;
+    for (int i = 0; i < count; i++)
+    {
+        enter(state, blocking ? GR_SEND : GR_ISEND);
+        state->now += call_cost / 2;
+        if (blocking)
+        {
+            OTF2_EvtWriter_MpiSend(state->writer, NULL, state->now,
+                                   exchangePartner(state->entity, i, true),
+                                   0, i, message_size);
+        }
+        else
+        {
+            requests.append(state->request);
+            OTF2_EvtWriter_MpiIsend(state->writer, NULL, state->now,
+                                    exchangePartner(state->entity, i, true),
+                                    0, i, message_size, state->request);
+            state->request++;
+        }
+        state->events++;
+        state->now += call_cost / 2;
+        leave(state, blocking ? GR_SEND : GR_ISEND);
+    }
+
+    if (blocking)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            unsigned long sender = exchangePartner(state->entity, i, false);
+            enter(state, GR_RECV);
+            state->now = qMax(state->now + call_cost / 2,
+                              sendTime(sender, iteration, i) + latency);
+            OTF2_EvtWriter_MpiRecv(state->writer, NULL, state->now,
+                                   sender, 0, i, message_size);
+            state->events++;
+            state->now += call_cost / 2;
+            leave(state, GR_RECV);
+        }
+        return;
+    }
+
+    enter(state, GR_WAITALL);
+    state->now += call_cost / 2;
+    for (QList<uint64_t>::Iterator request = requests.begin();
+         request != requests.end(); ++request)
+    {
+        OTF2_EvtWriter_MpiIsendComplete(state->writer, NULL, state->now,
+                                        *request);
+        state->events++;
+    }
+
+    // Receives complete in arrival order
+    QList<QPair<unsigned long long, int> > arrivals;
+    for (int i = 0; i < count; i++)
+    {
+        unsigned long sender = exchangePartner(state->entity, i, false);
+        arrivals.append(QPair<unsigned long long, int>(sendTime(sender, iteration, i)
+                                                       + latency, i));
+    }
+    qSort(arrivals);
+    for (QList<QPair<unsigned long long, int> >::Iterator arrival = arrivals.begin();
+         arrival != arrivals.end(); ++arrival)
+    {
+        state->now = qMax(state->now, arrival->first);
+        OTF2_EvtWriter_MpiIrecv(state->writer, NULL, state->now,
+                                exchangePartner(state->entity, arrival->second, false),
+                                0, arrival->second, message_size,
+                                state->request);
+        state->request++;
+        state->events++;
+    }
+    state->now += call_cost / 2;
+    leave(state, GR_WAITALL);
+}
+
+// Counters accumulate with compute time, each at a different rate
+void TraceGenerator::writeCounters(RankState * state)
+{
+    if (counters <= 0)
+        return;
+
+    QVector<OTF2_Type> types(counters, OTF2_TYPE_UINT64);
+    QVector<OTF2_MetricValue> values(counters);
+    for (int i = 0; i < counters; i++)
+        values[i].unsigned_int = state->computed * (i + 1);
+
+    OTF2_EvtWriter_Metric(state->writer, NULL, state->now, 0, counters,
+                          types.constData(), values.constData());
+    state->events++;
+}
+
+void TraceGenerator::enter(RankState * state, int region)
+{
+    OTF2_EvtWriter_Enter(state->writer, NULL, state->now, region);
+    state->events++;
+}
+
+void TraceGenerator::leave(RankState * state, int region)
+{
+    OTF2_EvtWriter_Leave(state->writer, NULL, state->now, region);
+    state->events++;
+}
+
+void TraceGenerator::writeDefinitions()
+{
+    global_def_writer = OTF2_Archive_GetGlobalDefWriter(archive);
+    string_counter = 0;
+
+    // Nanosecond clock
+    OTF2_GlobalDefWriter_WriteClockProperties(global_def_writer,
+                                              1000000000,
+                                              0,
+                                              iterationStart(iterations) + 1);
+
+    writeString("");
+
+    // Regions
+    QList<QString> mpi_functions;
+    mpi_functions << "MPI_Send" << "MPI_Recv" << "MPI_Isend" << "MPI_Waitall"
+                  << "MPI_Allreduce";
+    QList<QString> functions;
+    functions << "main" << mpi_functions;
+    for (int i = 0; i < depth; i++)
+        functions << "compute_" + QString::number(i);
+
+    for (int i = 0; i < functions.size(); i++)
+    {
+        OTF2_GlobalDefWriter_WriteRegion( global_def_writer,
+                                          i /* id */,
+                                          writeString(functions.at(i)) /* region name  */,
+                                          0 /* alternative name */,
+                                          0 /* description */,
+                                          OTF2_REGION_ROLE_UNKNOWN,
+                                          mpi_functions.contains(functions.at(i))
+                                          ? OTF2_PARADIGM_MPI
+                                          : OTF2_PARADIGM_USER,
+                                          OTF2_REGION_FLAG_NONE,
+                                          0 /* source file */,
+                                          0 /* begin lno */,
+                                          0 /* end lno */ );
+    }
+
+    // Metrics
+    if (counters > 0)
+    {
+        OTF2_StringRef unit = writeString("#");
+        QVector<OTF2_MetricMemberRef> members(counters);
+        for (int i = 0; i < counters; i++)
+        {
+            OTF2_StringRef name = writeString("counter_" + QString::number(i));
+            OTF2_GlobalDefWriter_WriteMetricMember(global_def_writer,
+                                                   i /* id */,
+                                                   name /* name */,
+                                                   name /* description */,
+                                                   OTF2_METRIC_TYPE_USER,
+                                                   OTF2_METRIC_ACCUMULATED_START,
+                                                   OTF2_TYPE_UINT64,
+                                                   OTF2_BASE_DECIMAL,
+                                                   0 /* exponent */,
+                                                   unit);
+            members[i] = i;
+        }
+        OTF2_GlobalDefWriter_WriteMetricClass(global_def_writer,
+                                              0 /* id */,
+                                              counters,
+                                              members.constData(),
+                                              OTF2_METRIC_SYNCHRONOUS_STRICT,
+                                              OTF2_RECORDER_KIND_CPU);
+    }
+
+    // Ranks
+    OTF2_StringRef machine = writeString("machine");
+    OTF2_GlobalDefWriter_WriteSystemTreeNode(global_def_writer,
+                                             0 /* id */,
+                                             machine /* name */,
+                                             machine /* class */,
+                                             OTF2_UNDEFINED_SYSTEM_TREE_NODE);
+
+    for (int i = 0; i < entities; i++)
+    {
+        OTF2_StringRef name = writeString("rank " + QString::number(i));
+        OTF2_GlobalDefWriter_WriteLocationGroup(global_def_writer,
+                                                i /* id */,
+                                                name /* name */,
+                                                OTF2_LOCATION_GROUP_TYPE_PROCESS,
+                                                0 /* system tree */ );
+
+        OTF2_GlobalDefWriter_WriteLocation(global_def_writer,
+                                           i /* id */,
+                                           name /* name */,
+                                           OTF2_LOCATION_TYPE_CPU_THREAD,
+                                           event_counts.at(i) /* # events */,
+                                           i /* location group */ );
+    }
+
+    // MPI_COMM_WORLD, rank i is location i
+    QVector<uint64_t> members(entities);
+    for (int i = 0; i < entities; i++)
+        members[i] = i;
+
+    OTF2_GlobalDefWriter_WriteGroup(global_def_writer,
+                                    0 /* id */,
+                                    0 /* name */,
+                                    OTF2_GROUP_TYPE_COMM_LOCATIONS,
+                                    OTF2_PARADIGM_MPI,
+                                    OTF2_GROUP_FLAG_NONE,
+                                    entities,
+                                    members.constData());
+
+    OTF2_GlobalDefWriter_WriteGroup(global_def_writer,
+                                    1 /* id */,
+                                    0 /* name */,
+                                    OTF2_GROUP_TYPE_COMM_GROUP,
+                                    OTF2_PARADIGM_MPI,
+                                    OTF2_GROUP_FLAG_NONE,
+                                    entities,
+                                    members.constData());
+
+    OTF2_GlobalDefWriter_WriteComm(global_def_writer,
+                                   0 /* id */,
+                                   writeString("MPI_COMM_WORLD") /* name */,
+                                   1 /* group */,
+                                   OTF2_UNDEFINED_COMM /* parent */ );
+}
+
+OTF2_StringRef TraceGenerator::writeString(QString str)
+{
+    OTF2_StringRef ref = string_counter;
+    OTF2_GlobalDefWriter_WriteString(global_def_writer, ref,
+                                     str.toStdString().c_str());
+    string_counter++;
+    return ref;
+}
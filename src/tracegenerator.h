@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef TRACEGENERATOR_H
+#define TRACEGENERATOR_H
+
+#include <otf2/otf2.h>
+#include <QString>
+#include <QList>
+#include <QVector>
+
+// Writes synthetic MPI traces of a requested size and communication
+// pattern to OTF2 so that every processing stage can be measured on
+// reproducible inputs.
+//
+// All timing is derived from hashes of (seed, rank, iteration) rather than
+// a running random stream, so any rank can compute when a partner sent a
+// message. That lets us write one location at a time and keep memory flat
+// regardless of the number of ranks.
+class TraceGenerator
+{
+public:
+    TraceGenerator();
+
+    enum Pattern { GP_HALO, GP_ALLTOALL, GP_MASTERWORKER, GP_BURST,
+                   GP_COLLECTIVE };
+
+    static QList<QString> getPatternNames();
+    bool setPattern(QString name);
+    QString getPatternName();
+
+    void generateTrace(QString path, QString filename);
+
+    int entities; // number of ranks
+    int iterations; // number of application steps
+    Pattern pattern;
+    int depth; // nesting of compute regions per iteration
+    int counters; // number of accumulated metrics, at most 255
+    int fanout; // partners per rank for burst and all-to-all
+    double imbalance; // persistent per-rank slowdown, fraction of compute
+    double noise; // per-iteration jitter, fraction of compute
+    unsigned long long compute; // base compute time in ns
+    unsigned long long message_size;
+    unsigned long seed;
+
+    static OTF2_FlushType
+    pre_flush( void*            userData,
+               OTF2_FileType    fileType,
+               OTF2_LocationRef location,
+               void*            callerData,
+               bool             final )
+    {
+        Q_UNUSED(userData);
+        Q_UNUSED(fileType);
+        Q_UNUSED(location);
+        Q_UNUSED(callerData);
+        Q_UNUSED(final);
+        return OTF2_FLUSH;
+    }
+
+    static OTF2_TimeStamp
+    post_flush( void*            userData,
+                OTF2_FileType    fileType,
+                OTF2_LocationRef location )
+    {
+        Q_UNUSED(userData);
+        Q_UNUSED(fileType);
+        Q_UNUSED(location);
+        return 0;
+    }
+
+    OTF2_FlushCallbacks flush_callbacks;
+
+private:
+    // Region ids, compute regions follow the MPI ones
+    enum GeneratorRegion { GR_MAIN, GR_SEND, GR_RECV, GR_ISEND, GR_WAITALL,
+                           GR_ALLREDUCE, GR_COMPUTE };
+
+    // Per location writing state
+    struct RankState {
+        OTF2_EvtWriter * writer;
+        unsigned long entity;
+        unsigned long long now;
+        unsigned long long events;
+        unsigned long long request;
+        unsigned long long computed; // total compute for counters
+    };
+
+    OTF2_Archive * archive;
+    OTF2_GlobalDefWriter * global_def_writer;
+    OTF2_StringRef string_counter;
+    QVector<uint64_t> event_counts;
+
+    // Derived timing constants
+    unsigned long long latency;
+    unsigned long long call_cost;
+    unsigned long long max_compute;
+    unsigned long long period;
+
+    void setupTiming();
+    unsigned long long computeTime(unsigned long entity,
+                                   unsigned long iteration);
+    unsigned long long iterationStart(unsigned long iteration);
+    unsigned long long sendTime(unsigned long entity, unsigned long iteration,
+                                int index);
+    int exchangeCount(unsigned long entity);
+    unsigned long exchangePartner(unsigned long entity, int index, bool send);
+
+    void writeDefinitions();
+    OTF2_StringRef writeString(QString str);
+    void writeEntityEvents(unsigned long entity);
+    void writeIteration(RankState * state, unsigned long iteration);
+    void writeCompute(RankState * state, unsigned long iteration);
+    void writeMasterWorker(RankState * state, unsigned long iteration);
+    void writeCollective(RankState * state, unsigned long iteration);
+    void writeExchange(RankState * state, unsigned long iteration);
+    void writeCounters(RankState * state);
+    void enter(RankState * state, int region);
+    void leave(RankState * state, int region);
+};
+
+#endif // TRACEGENERATOR_H
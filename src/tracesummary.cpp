@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "tracesummary.h"
+#include <algorithm>
+#include <cmath>
+
+#include "trace.h"
+#include "rpartition.h"
+#include "commevent.h"
+#include "stagetimer.h"
+#include "stephistogram.h"
+
+void TraceSummary::TimeRange::add(unsigned long long enter,
+                                  unsigned long long exit)
+{
+    if (enter < start)
+        start = enter;
+    if (exit > stop)
+        stop = exit;
+}
+
+TraceSummary::MetricStats::MetricStats()
+    : count(0),
+      min(0),
+      max(0),
+      aggregate_min(0),
+      aggregate_max(0),
+      percentiles(QVector<double>()),
+      aggregate_percentiles(QVector<double>()),
+      values(QVector<double>()),
+      aggregates(QVector<double>()),
+      state(88172645463325252ULL)
+{
+}
+
+// Reservoir sampling: the n-th event replaces a random sample with
+// probability sample_size / n
+void TraceSummary::MetricStats::add(double value, double aggregate)
+{
+    if (!count)
+    {
+        min = max = value;
+        aggregate_min = aggregate_max = aggregate;
+    }
+    min = std::min(min, value);
+    max = std::max(max, value);
+    aggregate_min = std::min(aggregate_min, aggregate);
+    aggregate_max = std::max(aggregate_max, aggregate);
+    count++;
+
+    if (values.size() < sample_size)
+    {
+        values.append(value);
+        aggregates.append(aggregate);
+        return;
+    }
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    quint64 slot = state % quint64(count);
+    if (slot < quint64(sample_size))
+    {
+        values[slot] = value;
+        aggregates[slot] = aggregate;
+    }
+}
+
+void TraceSummary::MetricStats::finish()
+{
+    fillPercentiles(&values, &percentiles);
+    fillPercentiles(&aggregates, &aggregate_percentiles);
+    if (count)
+    {
+        percentiles.first() = min;
+        percentiles.last() = max;
+        aggregate_percentiles.first() = aggregate_min;
+        aggregate_percentiles.last() = aggregate_max;
+    }
+    values = QVector<double>();
+    aggregates = QVector<double>();
+}
+
+// Sorts values and keeps the nearest rank for each whole percentile
+void TraceSummary::MetricStats::fillPercentiles(QVector<double> * values,
+                                                QVector<double> * percentiles)
+{
+    percentiles->clear();
+    if (values->isEmpty())
+        return;
+
+    std::sort(values->begin(), values->end());
+    int last = values->size() - 1;
+    percentiles->resize(num_percentiles);
+    for (int i = 0; i < num_percentiles; i++)
+    {
+        int rank = static_cast<int>(floor(i * last / double(num_percentiles - 1)
+                                          + 0.5));
+        (*percentiles)[i] = values->at(rank);
+    }
+}
+
+double TraceSummary::MetricStats::percentile(double fraction,
+                                             bool aggregate) const
+{
+    const QVector<double>& ranks = aggregate ? aggregate_percentiles
+                                             : percentiles;
+    if (ranks.isEmpty())
+        return 0;
+
+    double position = std::min(std::max(fraction, 0.0), 1.0)
+                      * (num_percentiles - 1);
+    int lower = static_cast<int>(floor(position));
+    if (lower >= num_percentiles - 1)
+        return ranks.last();
+    return ranks[lower] + (ranks[lower + 1] - ranks[lower]) * (position - lower);
+}
+
+long long TraceSummary::MetricStats::memoryBytes() const
+{
+    return sizeof(MetricStats)
+           + (percentiles.capacity() + aggregate_percentiles.capacity()
+              + values.capacity() + aggregates.capacity()) * sizeof(double);
+}
+
+TraceSummary::TraceSummary(Trace * _trace)
+    : num_events(0),
+      time(TimeRange()),
+      step_times(QVector<TimeRange>()),
+      partition_extents(QVector<PartitionExtent>()),
+      trace(_trace)
+{
+}
+
+TraceSummary::~TraceSummary()
+{
+}
+
+void TraceSummary::build()
+{
+    StageTimer stageTimer("buildTraceSummary");
+
+    num_events = 0;
+    time = TimeRange();
+    step_times = QVector<TimeRange>(trace->global_max_step + 1);
+    partition_extents = QVector<PartitionExtent>(trace->partitions->size());
+    int index = 0;
+    for (QList<Partition *>::Iterator part = trace->partitions->begin();
+         part != trace->partitions->end(); ++part, ++index)
+    {
+        PartitionExtent& extent = partition_extents[index];
+        extent.min_step = (*part)->min_global_step;
+        extent.max_step = (*part)->max_global_step;
+        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
+             = (*part)->events->begin();
+             event_list != (*part)->events->end(); ++event_list)
+        {
+            for (QList<CommEvent *>::Iterator evt = event_list.value()->begin();
+                 evt != event_list.value()->end(); ++evt)
+            {
+                num_events++;
+                time.add((*evt)->enter, (*evt)->exit);
+                extent.time.add((*evt)->enter, (*evt)->exit);
+                int step = (*evt)->step;
+                if (step >= 0 && step < step_times.size())
+                    step_times[step].add((*evt)->enter, (*evt)->exit);
+            }
+        }
+    }
+}
+
+// Kept with the metric's step histogram, which is built on first use for
+// metrics added after loading
+const TraceSummary::MetricStats * TraceSummary::getMetricStats(QString metric)
+{
+    return trace->getStepHistogram(metric)->getStats();
+}
+
+long long TraceSummary::memoryBytes() const
+{
+    return sizeof(TraceSummary)
+           + step_times.capacity() * sizeof(TimeRange)
+           + partition_extents.capacity() * sizeof(PartitionExtent);
+}
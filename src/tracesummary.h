@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef TRACESUMMARY_H
+#define TRACESUMMARY_H
+
+#include <QString>
+#include <QVector>
+#include <climits>
+
+class Trace;
+
+// Whole-trace figures the views used to rescan every event for whenever a
+// trace was shown or a metric changed: the time bounds of the comm events,
+// the time each global step spans, per partition extents and, per metric,
+// the range and distribution of the event and aggregate values. Built once
+// after processing. The metric figures are gathered by each metric's
+// StepHistogram in the pass that sums its steps.
+class TraceSummary
+{
+public:
+    class TimeRange {
+    public:
+        TimeRange() : start(ULLONG_MAX), stop(0) {}
+        void add(unsigned long long enter, unsigned long long exit);
+        bool isEmpty() const { return start > stop; }
+
+        unsigned long long start;
+        unsigned long long stop;
+    };
+
+    // Exact count and range. The percentiles come from a uniform sample of
+    // at most sample_size events, so summarizing a metric takes bounded
+    // memory however large the trace is.
+    class MetricStats {
+    public:
+        MetricStats();
+        void add(double value, double aggregate); // one event's values
+        void finish(); // fill the percentiles and drop the sample
+
+        // fraction in [0, 1], interpolated between whole percentiles
+        double percentile(double fraction, bool aggregate = false) const;
+        long long memoryBytes() const;
+
+        int count; // events with the metric
+        double min;
+        double max;
+        double aggregate_min;
+        double aggregate_max;
+        QVector<double> percentiles; // 0th to 100th
+        QVector<double> aggregate_percentiles;
+
+        static const int sample_size = 4096;
+
+    private:
+        static void fillPercentiles(QVector<double> * values,
+                                    QVector<double> * percentiles);
+
+        QVector<double> values; // sample while adding
+        QVector<double> aggregates;
+        quint64 state; // xorshift, fixed seed so summaries repeat
+    };
+
+    class PartitionExtent {
+    public:
+        PartitionExtent() : min_step(0), max_step(0), time(TimeRange()) {}
+
+        int min_step;
+        int max_step;
+        TimeRange time;
+    };
+
+    TraceSummary(Trace * _trace);
+    ~TraceSummary();
+
+    void build();
+    const MetricStats * getMetricStats(QString metric);
+    long long memoryBytes() const;
+
+    long long num_events; // comm events
+    TimeRange time;
+    QVector<TimeRange> step_times; // by global step
+    QVector<PartitionExtent> partition_extents; // in trace partition order
+
+    static const int num_percentiles = 101;
+
+private:
+    Trace * trace;
+};
+
+#endif // TRACESUMMARY_H
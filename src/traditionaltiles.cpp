@@ -0,0 +1,598 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#include "traditionaltiles.h"
+#include <cmath>
+#include <algorithm>
+#include <QPainter>
+#include <QFontMetrics>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include "trace.h"
+#include "event.h"
+#include "commevent.h"
+#include "function.h"
+#include "colormap.h"
+#include "framestats.h"
+
+// Pixels of one entity row covered by events too narrow to draw on their
+// own, so dense activity shows as spans rather than disappearing
+class PixelCoverage
+{
+public:
+    PixelCoverage(int _first, int _last)
+        : first(_first), values(QVector<double>(std::max(_last - _first, 0))),
+          covered(QVector<bool>(std::max(_last - _first, 0), false)),
+          empty(true) {}
+
+    // Cover pixels [x, x + w) with a metric value, keeping the largest
+    void add(float x, float w, double value)
+    {
+        // A pixel is covered if the span reaches into it, and an event
+        // narrower than a pixel still covers the one it starts in
+        int from = int(floor(x)) - first;
+        int to = std::max(int(ceil(x + w)) - 1 - first, from);
+        from = std::max(from, 0);
+        to = std::min(to, covered.size() - 1);
+        for (int p = from; p <= to; p++)
+        {
+            if (!covered.at(p) || value > values.at(p))
+                values[p] = value;
+            covered[p] = true;
+            empty = false;
+        }
+    }
+
+    // Fill runs of covered pixels, in one color or by value from the
+    // colormap, then start over
+    void draw(QPainter * painter, float y, float h, ColorMap * colormap,
+              QColor color)
+    {
+        if (empty)
+            return;
+        int p = 0;
+        while (p < covered.size())
+        {
+            if (!covered.at(p))
+            {
+                p++;
+                continue;
+            }
+            QColor run_color = colormap ? colormap->color(values.at(p)) : color;
+            int start = p;
+            while (p < covered.size() && covered.at(p)
+                   && (!colormap || colormap->color(values.at(p)) == run_color))
+            {
+                covered[p] = false;
+                p++;
+            }
+            painter->fillRect(QRectF(first + start, y, p - start, h),
+                              QBrush(run_color));
+        }
+        empty = true;
+    }
+
+private:
+    int first;
+    QVector<double> values;
+    QVector<bool> covered;
+    bool empty;
+};
+
+// Boxes are cut this far outside a tile, so the borders of boxes running
+// on into the next tile are not drawn and neighbouring tiles meet
+static const int tile_margin = 2;
+
+// Cut the span [x, x + w) to the tile and its margin, false if none is left
+static bool cutToTile(float * x, float * w)
+{
+    float low = -tile_margin;
+    float high = TraditionalTiles::tile_size + tile_margin;
+    if (*x < low)
+    {
+        *w -= low - *x;
+        *x = low;
+    }
+    if (*x + *w > high)
+        *w = high - *x;
+    return *w > 0;
+}
+
+// Function name at the start of an event box, if it fits in available
+// pixels and the box's height and reaches into the tile
+static void drawName(QPainter * painter, Trace * trace, int function,
+                     float x, float y, float h, float available)
+{
+    if (x + 2 >= TraditionalTiles::tile_size)
+        return;
+    Function * fxn = trace->functions->value(function);
+    if (!fxn)
+        return;
+    QRect fxnRect = painter->fontMetrics().boundingRect(fxn->name);
+    if (fxnRect.width() < available && fxnRect.height() < h
+        && x + 2 + fxnRect.width() > 0)
+    {
+        painter->drawText(x + 2, y + fxnRect.height(), fxn->name);
+    }
+}
+
+TraditionalTiles::Style::Style()
+    : xscale(0),
+      blockheight(0),
+      spacing(0),
+      metric(QString()),
+      byMetric(false),
+      colormap(0)
+{
+}
+
+bool TraditionalTiles::Style::operator==(const Style &other) const
+{
+    return xscale == other.xscale && blockheight == other.blockheight
+           && spacing == other.spacing && byMetric == other.byMetric
+           && colormap == other.colormap && metric == other.metric;
+}
+
+uint qHash(const TraditionalTiles::Key &key)
+{
+    return qHash(key.column) ^ (qHash(key.row) * 31)
+           ^ qHash(key.style.xscale) ^ (key.style.blockheight * 131)
+           ^ (key.style.colormap * 8191);
+}
+
+TraditionalTiles::Tile::Tile(const Key &_key, const Source * _source)
+    : key(_key),
+      source(_source),
+      colormap(NULL),
+      watcher(NULL),
+      wanted(1),
+      image(QImage()),
+      used(0),
+      counted(false),
+      visited(0),
+      drawn(0),
+      nanos(0)
+{
+}
+
+TraditionalTiles::Tile::~Tile()
+{
+    if (watcher)
+    {
+        wanted.store(0);
+        watcher->waitForFinished();
+        delete watcher;
+    }
+    delete colormap;
+}
+
+TraditionalTiles::TraditionalTiles(QObject * parent)
+    : QObject(parent),
+      source(Source()),
+      tiles(QHash<Key, Tile *>()),
+      frame(0)
+{
+}
+
+TraditionalTiles::~TraditionalTiles()
+{
+    clear();
+}
+
+void TraditionalTiles::setTrace(Trace * _trace,
+                                const QVector<int> &_order_to_entity,
+                                int _idle_function,
+                                unsigned long long _first_time,
+                                unsigned long long _last_time)
+{
+    clear();
+    source.trace = _trace;
+    source.order_to_entity = _order_to_entity;
+    source.idle_function = _idle_function;
+    source.first_time = _first_time;
+    source.last_time = _last_time;
+
+    // Workers only read the time index, so it has to exist beforehand
+    if (source.trace && !source.trace->time_indices)
+        source.trace->buildTimeIndex();
+}
+
+// Drop every tile, skipping the drawings not yet started and waiting out
+// the rest
+void TraditionalTiles::clear()
+{
+    for (QHash<Key, Tile *>::Iterator tile = tiles.begin();
+         tile != tiles.end(); ++tile)
+    {
+        tile.value()->wanted.store(0);
+    }
+    for (QHash<Key, Tile *>::Iterator tile = tiles.begin();
+         tile != tiles.end(); ++tile)
+    {
+        delete tile.value();
+    }
+    tiles.clear();
+}
+
+long long TraditionalTiles::memoryBytes() const
+{
+    long long bytes = sizeof(TraditionalTiles);
+    for (QHash<Key, Tile *>::ConstIterator tile = tiles.constBegin();
+         tile != tiles.constEnd(); ++tile)
+    {
+        bytes += sizeof(Tile) + tile.value()->image.byteCount();
+        if (tile.value()->colormap)
+            bytes += sizeof(ColorMap);
+    }
+    return bytes;
+}
+
+bool TraditionalTiles::draw(QPainter * painter, const QRect &plot,
+                            const Style &style, ColorMap * colormap,
+                            const QColor &background,
+                            unsigned long long startTime, float startEntity,
+                            bool wait, FrameStats * stats)
+{
+    frame++;
+    if (!source.trace || style.xscale <= 0 || style.blockheight <= 0)
+        return true;
+
+    // Grid pixels at the plot's top left and the size of the grid
+    double gridLeft = floor(static_cast<long long>(startTime
+                                                   - source.first_time)
+                            * style.xscale + 0.5);
+    double gridTop = ceil(startEntity * style.blockheight);
+    double gridWidth = (source.last_time - source.first_time) * style.xscale
+                       + tile_margin;
+    double gridHeight = source.order_to_entity.size() * style.blockheight + 1;
+
+    qint64 firstColumn = std::max(floor(gridLeft / tile_size), 0.0);
+    qint64 lastColumn = std::min(floor((gridLeft + plot.width() - 1)
+                                       / tile_size),
+                                 floor(gridWidth / tile_size));
+    int firstRow = std::max(floor(gridTop / tile_size), 0.0);
+    int lastRow = std::min(floor((gridTop + plot.height() - 1) / tile_size),
+                           floor(gridHeight / tile_size));
+
+    // Find or start the tiles of the plot
+    QList<Tile *> shown = QList<Tile *>();
+    bool complete = true;
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        for (qint64 column = firstColumn; column <= lastColumn; column++)
+        {
+            Key key(style, column, row);
+            Tile * tile = tiles.value(key, NULL);
+            if (!tile)
+            {
+                tile = new Tile(key, &source);
+                tiles.insert(key, tile);
+            }
+            tile->used = frame;
+            tile->wanted.store(1);
+            if (wait && tile->isDrawing())
+                tile->watcher->waitForFinished();
+            if (!tile->isReady() && !tile->isDrawing())
+            {
+                start(tile, colormap, wait);
+                if (wait && stats)
+                    stats->add(FrameStats::FS_TRAVERSAL, tile->nanos);
+            }
+            if (!tile->isReady())
+                complete = false;
+            shown.append(tile);
+        }
+    }
+
+    // Tiles that went out of view or out of style need not be drawn after
+    // all, though they are kept if they are
+    for (QHash<Key, Tile *>::Iterator tile = tiles.begin();
+         tile != tiles.end(); ++tile)
+    {
+        if (tile.value()->used != frame && tile.value()->isDrawing())
+            tile.value()->wanted.store(0);
+    }
+
+    painter->save();
+    painter->setClipRect(plot);
+
+    // Until the tiles are all there, stretch the tiles of other styles
+    // over where they belong now, the most recently shown on top
+    if (!complete)
+    {
+        QList<Tile *> others = QList<Tile *>();
+        for (QHash<Key, Tile *>::Iterator tile = tiles.begin();
+             tile != tiles.end(); ++tile)
+        {
+            if (tile.value()->isReady() && !(tile.value()->key.style == style))
+                others.append(tile.value());
+        }
+        std::sort(others.begin(), others.end(), usedBefore);
+
+        for (QList<Tile *>::Iterator tile = others.begin();
+             tile != others.end(); ++tile)
+        {
+            const Key &key = (*tile)->key;
+            double xratio = style.xscale / key.style.xscale;
+            double yratio = style.blockheight / 1.0 / key.style.blockheight;
+            QRectF target(plot.left() + 1 - gridLeft
+                              + (key.column * tile_size - 1) * xratio,
+                          plot.top() + 1 - gridTop
+                              + (key.row * tile_size - 1.0) * yratio,
+                          tile_size * xratio, tile_size * yratio);
+            if (target.intersects(plot))
+                painter->drawImage(target, (*tile)->image);
+        }
+    }
+
+    for (QList<Tile *>::Iterator tile = shown.begin();
+         tile != shown.end(); ++tile)
+    {
+        if (!(*tile)->isReady())
+            continue;
+
+        QPoint origin(plot.left() + (*tile)->key.column * tile_size
+                          - gridLeft,
+                      plot.top() + (*tile)->key.row * tile_size - gridTop);
+        painter->fillRect(QRect(origin, (*tile)->image.size()), background);
+        painter->drawImage(origin, (*tile)->image);
+
+        // A tile's events count towards the first frame showing it
+        if (stats && !(*tile)->counted)
+        {
+            stats->count(FrameStats::FS_EVENTS_VISITED, (*tile)->visited);
+            stats->count(FrameStats::FS_EVENTS_DRAWN, (*tile)->drawn);
+        }
+        (*tile)->counted = true;
+    }
+    painter->restore();
+
+    evict();
+    return complete;
+}
+
+// Draw a tile on a worker, or right here with wait. The worker gets its
+// own copy of the colormap as the view's may change meanwhile.
+void TraditionalTiles::start(Tile * tile, ColorMap * colormap, bool wait)
+{
+    delete tile->colormap;
+    tile->colormap = NULL;
+    if (tile->key.style.byMetric && colormap)
+        tile->colormap = new ColorMap(*colormap);
+
+    if (wait)
+    {
+        drawTile(tile);
+        return;
+    }
+
+    if (!tile->watcher)
+    {
+        tile->watcher = new QFutureWatcher<void>();
+        connect(tile->watcher, SIGNAL(finished()), this, SIGNAL(tileDrawn()));
+    }
+    tile->watcher->setFuture(QtConcurrent::run(drawTile, tile));
+}
+
+// Drop the least recently shown tiles beyond max_tiles, other than those
+// shown now and those being drawn
+void TraditionalTiles::evict()
+{
+    if (tiles.size() <= max_tiles)
+        return;
+
+    QList<Tile *> old = QList<Tile *>();
+    for (QHash<Key, Tile *>::Iterator tile = tiles.begin();
+         tile != tiles.end(); ++tile)
+    {
+        if (tile.value()->used != frame && !tile.value()->isDrawing())
+            old.append(tile.value());
+    }
+    std::sort(old.begin(), old.end(), usedBefore);
+
+    for (QList<Tile *>::Iterator tile = old.begin();
+         tile != old.end() && tiles.size() > max_tiles; ++tile)
+    {
+        tiles.remove((*tile)->key);
+        delete *tile;
+    }
+}
+
+// Draw the events of the tile's rows overlapping its time, like the view
+// used to: other events in gray by depth under the comm events, and what
+// is too narrow to draw as the rows' coverage spans. Runs on a worker and
+// so reads only the trace, the source and the tile.
+void TraditionalTiles::drawTile(Tile * tile)
+{
+    if (!tile->wanted.load())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    const Source * source = tile->source;
+    const Style &style = tile->key.style;
+    Trace * trace = source->trace;
+
+    QImage image(tile_size, tile_size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setFont(QFont("Helvetica", 10));
+    painter.setPen(QPen(QColor(0, 0, 0)));
+
+    // Grid pixels of the tile's top left, and the times and rows they
+    // reach with the margin
+    double left = tile->key.column * double(tile_size);
+    int top = tile->key.row * tile_size;
+    unsigned long long startTime = source->first_time;
+    if (left > tile_margin)
+        startTime += (left - tile_margin) / style.xscale;
+    unsigned long long stopTime = source->first_time
+            + (left + tile_size + tile_margin) / style.xscale;
+    int firstRow = std::max(top / style.blockheight - 1, 0);
+    int lastRow = std::min((top + tile_size) / style.blockheight,
+                           source->order_to_entity.size() - 1);
+
+    float barheight = style.blockheight - style.spacing;
+    int one_tick = std::max(2.0, ceil(style.xscale));
+    ColorMap * coverageColors = NULL;
+    if (style.byMetric)
+        coverageColors = tile->colormap;
+    PixelCoverage coverage(0, tile_size);
+    QVector<Event *> visible = QVector<Event *>();
+    QVector<CommEvent *> comms = QVector<CommEvent *>();
+    float x, y, w, h, cx, cy, cw, ch, exact;
+    int visited = 0, drawn = 0;
+    for (int i = firstRow; i <= lastRow; ++i)
+    {
+        if (!tile->wanted.load())
+            return;
+
+        visible.clear();
+        comms.clear();
+        trace->findEvents(source->order_to_entity.at(i), startTime, stopTime,
+                          &visible);
+        visited += visible.size();
+        float rowY = i * style.blockheight + 1 - top;
+
+        for (QVector<Event *>::Iterator evt = visible.begin();
+             evt != visible.end(); ++evt)
+        {
+            if ((*evt)->isCommEvent())
+            {
+                comms.append(static_cast<CommEvent *>(*evt));
+                continue;
+            }
+
+            exact = static_cast<long long>((*evt)->enter - source->first_time)
+                    * style.xscale + 1 - left;
+            w = ((*evt)->exit - (*evt)->enter) * style.xscale;
+            if (w < 2) // Tiny events are left to the coverage spans
+            {
+                if ((*evt)->function != source->idle_function)
+                    coverage.add(exact, w, 0);
+                continue;
+            }
+
+            x = floor(exact);
+            y = rowY;
+            h = barheight;
+            int graycolor = 0;
+            if ((*evt)->function == source->idle_function)
+            {
+                h = barheight / 2;
+                y += barheight / 4;
+            }
+            else
+            {
+                graycolor = std::min(240, std::max(100, 100 + (*evt)->depth
+                                                               * 20));
+            }
+
+            float available = ((*evt)->getVisibleEnd((*evt)->enter)
+                               - (*evt)->enter) * style.xscale + 2;
+            float drawnX = x;
+            if (!cutToTile(&drawnX, &w))
+                continue;
+            painter.fillRect(QRectF(drawnX, y, w, h),
+                             QBrush(QColor(graycolor, graycolor, graycolor)));
+            if (style.spacing > 0)
+                painter.drawRect(QRectF(drawnX, y, w, h));
+            drawName(&painter, trace, (*evt)->function, x, y, h, available);
+            drawn++;
+        }
+        coverage.draw(&painter, rowY, barheight, NULL, QColor(100, 100, 100));
+
+        for (QVector<CommEvent *>::Iterator evt = comms.begin();
+             evt != comms.end(); ++evt)
+        {
+            exact = static_cast<long long>((*evt)->enter - source->first_time)
+                    * style.xscale + 1 - left;
+            w = ((*evt)->exit - (*evt)->enter) * style.xscale;
+            cw = ((*evt)->extent_end - (*evt)->extent_begin) * style.xscale;
+            if ((*evt)->exit == (*evt)->enter)
+                w = one_tick;
+            if ((*evt)->extent_end == (*evt)->extent_begin)
+                cw = one_tick;
+
+            bool colored = style.byMetric && tile->colormap
+                           && (*evt)->hasMetric(style.metric);
+            QColor color = QColor(200, 200, 255);
+            if (colored)
+                color = tile->colormap->color((*evt)->getMetric(style.metric));
+
+            if (cw < 2) // we know cw >= w, too small so add to the coverage
+            {
+                double value = 0;
+                if (colored)
+                    value = (*evt)->getMetric(style.metric);
+                coverage.add(exact, w, value);
+                continue;
+            }
+
+            // Background color on the larger extent
+            if (colored)
+            {
+                cx = floor(static_cast<long long>((*evt)->extent_begin
+                                                  - source->first_time)
+                           * style.xscale) + 1 - left;
+                cy = rowY;
+                ch = barheight;
+                if (style.spacing > 0)
+                {
+                    cx += 1;
+                    cw -= 2;
+                    cy += 1;
+                    ch -= 2;
+                }
+                if (cutToTile(&cx, &cw))
+                    painter.fillRect(QRectF(cx, cy, cw, ch), QBrush(color));
+            }
+            drawn++;
+            if (w < 2)
+                continue;
+
+            x = floor(exact);
+            float available = w + 2;
+            float drawnX = x;
+            if (!cutToTile(&drawnX, &w))
+                continue;
+            painter.fillRect(QRectF(drawnX, rowY, w, barheight),
+                             QBrush(color));
+            if (style.spacing > 0)
+                painter.drawRect(QRectF(drawnX, rowY, w, barheight));
+            drawName(&painter, trace, (*evt)->function, x, rowY, barheight,
+                     available);
+        }
+        coverage.draw(&painter, rowY, barheight, coverageColors,
+                      QColor(200, 200, 255));
+    }
+    painter.end();
+
+    tile->visited = visited;
+    tile->drawn = drawn;
+    tile->nanos = timer.nsecsElapsed();
+    tile->image = image;
+}
@@ -0,0 +1,158 @@
+//////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+//
+// This file is part of Ravel.
+// Written by Kate Isaacs, kisaacs@acm.org, All rights reserved.
+// LLNL-CODE-663885
+//
+// For details, see https://github.com/scalability-llnl/ravel
+// Please also see the LICENSE file for our notice and the LGPL.
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License (as published by
+// the Free Software Foundation) version 2.1 dated February 1999.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the IMPLIED WARRANTY OF
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the terms and
+// conditions of the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//////////////////////////////////////////////////////////////////////////////
+#ifndef TRADITIONALTILES_H
+#define TRADITIONALTILES_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <QColor>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+
+class Trace;
+class ColorMap;
+class FrameStats;
+class QPainter;
+
+// The event boxes of the physical timeline, drawn into tile_size square
+// images on worker threads and kept by the style they were drawn with.
+// Tiles sit on a pixel grid over the whole trace: at a style's xscale, a
+// time is (time - first_time) * xscale pixels from the left of the grid,
+// and entity row r starts r * blockheight + 1 pixels from the top. Panning
+// draws only the tiles coming into view; until a tile is ready, whatever
+// tiles of other styles cover its area are stretched over it.
+//
+// Tiles hold no selection, hover or messages, which the view draws on top.
+class TraditionalTiles : public QObject
+{
+    Q_OBJECT
+public:
+    // What the tiles are drawn with besides their place on the grid
+    class Style {
+    public:
+        Style();
+        bool operator==(const Style &other) const;
+
+        double xscale; // pixels per time unit
+        int blockheight;
+        int spacing; // between rows, which are bordered when it is non-zero
+        QString metric;
+        bool byMetric; // comm events colored by the metric
+        int colormap; // serial of the colormap
+    };
+
+    TraditionalTiles(QObject * parent = 0);
+    ~TraditionalTiles();
+
+    // Rows of the grid in order of the entities drawn in them. Drops all
+    // tiles, waiting out any being drawn.
+    void setTrace(Trace * _trace, const QVector<int> &_order_to_entity,
+                  int _idle_function, unsigned long long _first_time,
+                  unsigned long long _last_time);
+    void clear();
+
+    // Composite the tiles covering plot, where the view has startTime at
+    // plot.left() + 1 and entity position startEntity at plot.top() + 1,
+    // and start drawing the missing ones. With wait they are drawn before
+    // returning. Returns whether every tile shown was ready.
+    bool draw(QPainter * painter, const QRect &plot, const Style &style,
+              ColorMap * colormap, const QColor &background,
+              unsigned long long startTime, float startEntity, bool wait,
+              FrameStats * stats);
+
+    int size() const { return tiles.size(); }
+    long long memoryBytes() const;
+
+    static const int tile_size = 256;
+    static const int max_tiles = 160;
+
+signals:
+    void tileDrawn();
+
+private:
+    class Key {
+    public:
+        Key(const Style &_style, qint64 _column, int _row)
+            : style(_style), column(_column), row(_row) {}
+        bool operator==(const Key &other) const
+            { return column == other.column && row == other.row
+                     && style == other.style; }
+
+        Style style;
+        qint64 column;
+        int row;
+    };
+    friend uint qHash(const Key &key);
+
+    // What all tiles are drawn from, only changed with no tile drawing
+    class Source {
+    public:
+        Source() : trace(NULL), order_to_entity(QVector<int>()),
+            idle_function(-1), first_time(0), last_time(0) {}
+
+        Trace * trace;
+        QVector<int> order_to_entity;
+        int idle_function;
+        unsigned long long first_time;
+        unsigned long long last_time;
+    };
+
+    class Tile {
+    public:
+        Tile(const Key &_key, const Source * _source);
+        ~Tile();
+        bool isDrawing() const
+            { return watcher && !watcher->isFinished(); }
+        bool isReady() const { return !isDrawing() && !image.isNull(); }
+
+        Key key;
+        const Source * source;
+        ColorMap * colormap; // copy for the worker
+        QFutureWatcher<void> * watcher;
+        QAtomicInt wanted; // cleared to skip a drawing no longer needed
+        QImage image;
+        int used; // last frame it was shown in
+        bool counted; // counts added to a frame
+        int visited;
+        int drawn;
+        qint64 nanos;
+    };
+
+    static void drawTile(Tile * tile);
+    static bool usedBefore(const Tile * tile1, const Tile * tile2)
+        { return tile1->used < tile2->used; }
+    void start(Tile * tile, ColorMap * colormap, bool wait);
+    void evict();
+
+    Source source;
+    QHash<Key, Tile *> tiles;
+    int frame;
+};
+
+#endif // TRADITIONALTILES_H
@@ -25,9 +25,12 @@
 #include "traditionalvis.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include <QFontMetrics>
 #include <QMouseEvent>
+#include <QElapsedTimer>
 #include <QWheelEvent>
+#include <QFontDatabase>
 
 #include "trace.h"
 #include "rpartition.h"
@@ -36,11 +39,13 @@
 #include "message.h"
 #include "colormap.h"
 #include "commevent.h"
+#include "tracesummary.h"
 #include "event.h"
 #include "entity.h"
 #include "primaryentitygroup.h"
 #include "p2pevent.h"
 #include "collectiveevent.h"
+#include "memorycensus.h"
 
 TraditionalVis::TraditionalVis(QWidget * parent, VisOptions * _options)
     : TimelineVis(parent = parent, _options),
@@ -50,9 +55,10 @@ TraditionalVis::TraditionalVis(QWidget * parent, VisOptions * _options)
     timeSpan(0),
     stepToTime(new QVector<TimePair *>()),
     lassoRect(QRect()),
-    blockheight(0)
+    blockheight(0),
+    tiles()
 {
-
+    connect(&tiles, SIGNAL(tileDrawn()), this, SLOT(update()));
 }
 
 TraditionalVis::~TraditionalVis()
@@ -68,6 +74,7 @@ TraditionalVis::~TraditionalVis()
 
 void TraditionalVis::setTrace(Trace * t)
 {
+    tiles.clear();
     VisWidget::setTrace(t);
 
     // Initial conditions
@@ -79,36 +86,10 @@ void TraditionalVis::setTrace(Trace * t)
     startPartition = 0;
 
     // Determine/save time information
-    minTime = ULLONG_MAX;
-    maxTime = 0;
-    startTime = ULLONG_MAX;
-    unsigned long long stopTime = 0;
+    TraceSummary * summary = trace->summary;
+    minTime = summary->time.start;
+    maxTime = summary->time.stop;
     maxStep = trace->global_max_step;
-    for (QList<Partition*>::Iterator part = trace->partitions->begin();
-         part != trace->partitions->end(); ++part)
-    {
-        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
-             = (*part)->events->begin(); event_list != (*part)->events->end();
-             ++event_list)
-        {
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                if ((*evt)->exit > maxTime)
-                    maxTime = (*evt)->exit;
-                if ((*evt)->enter < minTime)
-                    minTime = (*evt)->enter;
-                if ((*evt)->step >= boundStep(startStep)
-                        && (*evt)->enter < startTime)
-                    startTime = (*evt)->enter;
-                if ((*evt)->step <= boundStep(stopStep)
-                        && (*evt)->exit > stopTime)
-                    stopTime = (*evt)->exit;
-            }
-        }
-    }
-    timeSpan = stopTime - startTime;
-    stepSpan = stopStep - startStep;
 
     // Clean up old
     for (QVector<TimePair *>::Iterator itr = stepToTime->begin();
@@ -119,31 +100,31 @@ void TraditionalVis::setTrace(Trace * t)
     }
     delete stepToTime;
 
-    // Create time/step mapping
+    // Create time/step mapping, one entry per pair of steps
     stepToTime = new QVector<TimePair *>();
     for (int i = 0; i < maxStep/2 + 1; i++)
         stepToTime->insert(i, new TimePair(ULLONG_MAX, 0));
-    int step;
-    for (QList<Partition*>::Iterator part = trace->partitions->begin();
-         part != trace->partitions->end(); ++part)
+    startTime = ULLONG_MAX;
+    unsigned long long stopTime = 0;
+    for (int step = 0; step < summary->step_times.size(); step++)
     {
-        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
-             = (*part)->events->begin(); event_list != (*part)->events->end();
-             ++event_list)
-        {
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                if ((*evt)->step < 0)
-                    continue;
-                step = (*evt)->step / 2;
-                if ((*stepToTime)[step]->start > (*evt)->enter)
-                    (*stepToTime)[step]->start = (*evt)->enter;
-                if ((*stepToTime)[step]->stop < (*evt)->exit)
-                    (*stepToTime)[step]->stop = (*evt)->exit;
-            }
-        }
+        const TraceSummary::TimeRange& range = summary->step_times.at(step);
+        if (range.isEmpty())
+            continue;
+
+        TimePair * pair = (*stepToTime)[step / 2];
+        if (pair->start > range.start)
+            pair->start = range.start;
+        if (pair->stop < range.stop)
+            pair->stop = range.stop;
+
+        if (step >= boundStep(startStep) && range.start < startTime)
+            startTime = range.start;
+        if (step <= boundStep(stopStep) && range.stop > stopTime)
+            stopTime = range.stop;
     }
+    timeSpan = stopTime - startTime;
+    stepSpan = stopStep - startStep;
 
     // Create processing element mapping
     proc_to_order = QMap<unsigned long, unsigned long>();
@@ -169,6 +150,33 @@ void TraditionalVis::setTrace(Trace * t)
 
 }
 
+// Tiles draw the rows by their entities once the idle function is known
+void TraditionalVis::processVis()
+{
+    TimelineVis::processVis();
+
+    QVector<int> order_to_entity = QVector<int>(order_to_proc.size());
+    for (QMap<unsigned long, unsigned long>::Iterator order = order_to_proc.begin();
+         order != order_to_proc.end(); ++order)
+    {
+        order_to_entity[order.key()] = order.value();
+    }
+    tiles.setTrace(trace, order_to_entity, idleFunction, minTime, maxTime);
+}
+
+void TraditionalVis::clear()
+{
+    tiles.clear();
+    TimelineVis::clear();
+}
+
+void TraditionalVis::countMemory(MemoryCensus * census)
+{
+    VisWidget::countMemory(census);
+    census->add(MemoryCensus::MC_VIS, tiles.size(), tiles.memoryBytes());
+}
+
+// Only comm events can be selected
 void TraditionalVis::mouseDoubleClickEvent(QMouseEvent * event)
 {
     if (!visProcessed)
@@ -176,21 +184,19 @@ void TraditionalVis::mouseDoubleClickEvent(QMouseEvent * event)
 
     int x = event->x();
     int y = event->y();
-    for (QMap<Event *, QRect>::Iterator evt = drawnEvents.begin();
-         evt != drawnEvents.end(); ++evt)
-        if (evt.value().contains(x,y))
+    Event * evt = eventAt(x, y);
+    if (evt && evt->isCommEvent())
+    {
+        if (evt == selected_event)
         {
-            if (evt.key() == selected_event)
-            {
-                selected_event = NULL;
-            }
-            else
-            {
-                selected_aggregate = false;
-                selected_event = evt.key();
-            }
-            break;
+            selected_event = NULL;
         }
+        else
+        {
+            selected_aggregate = false;
+            selected_event = evt;
+        }
+    }
 
     changeSource = true;
     emit eventClicked(selected_event, false, false);
@@ -285,22 +291,10 @@ void TraditionalVis::mouseMoveEvent(QMouseEvent * event)
     {
         mousex = event->x();
         mousey = event->y();
-        if (hover_event == NULL
-                || !drawnEvents[hover_event].contains(mousex, mousey))
+        Event * evt = eventAt(mousex, mousey);
+        if (evt != hover_event)
         {
-            // Hover for all events! Note since we only save comm events in the
-            // drawnEvents, this will recalculate for non-comm events each move
-            if (mousey > blockheight * entitySpan)
-                hover_event = NULL;
-            else
-            {
-                int hover_proc = order_to_proc[floor((mousey - 1) / blockheight)
-                                                + startEntity];
-                unsigned long long hover_time = (mousex - 1 - labelWidth)
-                                                / 1.0 / rect().width()
-                                                * timeSpan + startTime;
-                hover_event = trace->findEvent(hover_proc, hover_time);
-            }
+            hover_event = evt;
             repaint();
         }
     }
@@ -366,12 +360,23 @@ void TraditionalVis::setSteps(float start, float stop, bool jump)
     }
 }
 
+bool TraditionalVis::viewRange(ViewRange * range)
+{
+    int canvasHeight = rect().height() - timescaleHeight;
+    range->plot = QRect(labelWidth, 0, rect().width() - labelWidth,
+                        canvasHeight);
+    range->x = startTime;
+    range->xscale = rect().width() / 1.0 / timeSpan;
+    range->y = startEntity;
+    range->yscale = floor(canvasHeight / entitySpan);
+    return timeSpan > 0 && range->yscale > 0;
+}
+
 void TraditionalVis::prepaint()
 {
     if (!visProcessed)
         return;
     closed = false;
-    drawnEvents.clear();
     int bottomStep = floor(startStep) - 1;
     // Fix bottomStep in the case where there are no steps in the view,
     // otherwise partition place will be lost
@@ -465,86 +470,98 @@ void TraditionalVis::drawNativeGL()
     // Process events for values
     float x, y, w; // true position
     float position; // placement of entity
-    Partition * part = NULL;
     int oldStart = startStep;
     int oldStop = stepSpan + startStep;
     int step, stopStep = 0;
-    int upperStep = startStep + stepSpan + 2;
     startStep = maxStep;
     QColor color;
     float maxEntity = entitySpan + startEntity;
-    for (int i = startPartition; i < trace->partitions->length(); ++i)
-    {
-        part = trace->partitions->at(i);
-        if (part->min_global_step > upperStep)
-            break;
 
-        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
-             = part->events->begin(); event_list != part->events->end();
-             ++event_list)
+    // Comm events overlapping the view of each row, from the time index
+    int start = std::max(int(floor(startEntity)), 0);
+    int end = std::min(int(ceil(startEntity + entitySpan)),
+                       trace->num_pes - 1);
+    QVector<Event *> visible = QVector<Event *>();
+    QVector<CommEvent *> comms = QVector<CommEvent *>();
+    QElapsedTimer walk;
+    walk.start();
+    int visited = 0;
+    for (int i = start; i <= end; ++i)
+    {
+        visible.clear();
+        comms.clear();
+        trace->findEvents(order_to_proc[i], startTime, stopTime, &visible);
+        visited += visible.size();
+        for (QVector<Event *>::Iterator evt = visible.begin();
+             evt != visible.end(); ++evt)
         {
+            if ((*evt)->isCommEvent())
+                comms.append(static_cast<CommEvent *>(*evt));
+        }
 
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
+        for (QVector<CommEvent *>::Iterator evt = comms.begin();
+             evt != comms.end(); ++evt)
+        {
 
-                position = proc_to_order[(*evt)->pe];
-                 // Out of entity span test
-                if (position < floor(startEntity)
-                        || position > ceil(startEntity + entitySpan))
-                    continue;
-                y = (maxEntity - position) * barheight - 1;
-                // Out of time span test
-                if ((*evt)->exit < startTime || (*evt)->enter > stopTime)
-                    continue;
-
-
-                // save step information for emitting
-                step = (*evt)->step;
-                if (step >= 0 && step > stopStep)
-                    stopStep = step;
-                if (step >= 0 && step < startStep) {
-                    startStep = step;
-                }
+            position = proc_to_order[(*evt)->pe];
+             // Out of entity span test
+            if (position < floor(startEntity)
+                    || position > ceil(startEntity + entitySpan))
+                continue;
+            y = (maxEntity - position) * barheight - 1;
+            // Out of time span test
+            if ((*evt)->exit < startTime || (*evt)->enter > stopTime)
+                continue;
+
+
+            // save step information for emitting
+            step = (*evt)->step;
+            if (step >= 0 && step > stopStep)
+                stopStep = step;
+            if (step >= 0 && step < startStep) {
+                startStep = step;
+            }
 
-                // Calculate position of this bar in float space
-                w = (*evt)->exit - (*evt)->enter;
-                x = 0;
-                if ((*evt)->enter >= startTime)
-                    x = (*evt)->enter - startTime;
-                else
-                    w -= (startTime - (*evt)->enter);
+            // Calculate position of this bar in float space
+            w = (*evt)->exit - (*evt)->enter;
+            x = 0;
+            if ((*evt)->enter >= startTime)
+                x = (*evt)->enter - startTime;
+            else
+                w -= (startTime - (*evt)->enter);
 
-                color = options->colormap->color((*evt)->getMetric(options->metric)); //    (*(*evt)->metrics)[metric]->event);
-                if (options->colorTraditionalByMetric
-                        && (*evt)->hasMetric(options->metric))
-                    color= options->colormap->color((*evt)->getMetric(options->metric));
+            color = options->colormap->color((*evt)->getMetric(options->metric)); //    (*(*evt)->metrics)[metric]->event);
+            if (options->colorTraditionalByMetric
+                    && (*evt)->hasMetric(options->metric))
+                color= options->colormap->color((*evt)->getMetric(options->metric));
+            else
+            {
+                if (*evt == selected_event)
+                    color = Qt::yellow;
                 else
-                {
-                    if (*evt == selected_event)
-                        color = Qt::yellow;
-                    else
-                        color = QColor(200, 200, 255);
-                }
-
-                bars.append(x);
-                bars.append(y);
-                bars.append(x);
-                bars.append(y + barheight);
-                bars.append(x + w);
-                bars.append(y + barheight);
-                bars.append(x + w);
-                bars.append(y);
-                for (int j = 0; j < 4; ++j)
-                {
-                    colors.append(color.red() / 255.0);
-                    colors.append(color.green() / 255.0);
-                    colors.append(color.blue() / 255.0);
-                }
+                    color = QColor(200, 200, 255);
+            }
 
+            bars.append(x);
+            bars.append(y);
+            bars.append(x);
+            bars.append(y + barheight);
+            bars.append(x + w);
+            bars.append(y + barheight);
+            bars.append(x + w);
+            bars.append(y);
+            for (int j = 0; j < 4; ++j)
+            {
+                colors.append(color.red() / 255.0);
+                colors.append(color.green() / 255.0);
+                colors.append(color.blue() / 255.0);
             }
+
         }
     }
+    frameStats.add(FrameStats::FS_TRAVERSAL, walk.nsecsElapsed());
+    frameStats.count(FrameStats::FS_EVENTS_VISITED, visited);
+    frameStats.count(FrameStats::FS_EVENTS_DRAWN, bars.size() / 8);
 
     // Draw
     glEnableClientState(GL_COLOR_ARRAY);
@@ -585,6 +602,20 @@ void TraditionalVis::qtPaint(QPainter *painter)
     }
 }
 
+// The same span tests paintEvents uses to draw a comm event
+bool TraditionalVis::commEventShown(CommEvent * evt)
+{
+    int position = proc_to_order[evt->pe];
+    if (position < floor(startEntity)
+        || position > ceil(startEntity + entitySpan))
+    {
+        return false;
+    }
+    return evt->exit >= startTime && evt->enter <= startTime + timeSpan;
+}
+
+// The event boxes come from tiles drawn on worker threads, which leave the
+// selection, messages and delay tracking to be drawn over them here
 void TraditionalVis::paintEvents(QPainter *painter)
 {
     int canvasHeight = rect().height() - timescaleHeight;
@@ -593,287 +624,72 @@ void TraditionalVis::paintEvents(QPainter *painter)
     if (canvasHeight / entitySpan > 12)
         entity_spacing = 3;
 
-    float x, y, w, h;
-    float cx, cw; // For extended color
     blockheight = floor(canvasHeight / entitySpan);
     float barheight = blockheight - entity_spacing;
     entityheight = blockheight;
-    int oldStart = startStep;
-    int oldStop = stepSpan + startStep;
-    int upperStep = startStep + stepSpan + 2;
-    startStep = maxStep;
-    int stopStep = 0;
     QRect extents = QRect(labelWidth, 0, rect().width(), canvasHeight);
-
-    painter->setFont(QFont("Helvetica", 10));
-    QFontMetrics font_metrics = painter->fontMetrics();
-
-    int position, step;
-    bool complete;
-    //QSet<Message *> drawMessages = QSet<Message *>();
-    QSet<CommBundle *> drawComms = QSet<CommBundle *>();
-    QSet<CommBundle *> selectedComms = QSet<CommBundle *>();
     unsigned long long stopTime = startTime + timeSpan;
-    painter->setPen(QPen(QColor(0, 0, 0)));
-    Partition * part = NULL;
 
-    int start = std::max(int(floor(startEntity)), 0);
-    int end = std::min(int(ceil(startEntity + entitySpan)),
-                       trace->num_pes - 1);
-    for (int i = start; i <= end; ++i)
+    TraditionalTiles::Style style;
+    style.xscale = rect().width() / 1.0 / timeSpan;
+    style.blockheight = blockheight;
+    style.spacing = entity_spacing;
+    style.byMetric = options->colorTraditionalByMetric;
+    if (style.byMetric)
     {
-        position = order_to_proc[i];
-        QVector<Event *> * roots = trace->roots->at(i);
-        for (QVector<Event *>::Iterator root = roots->begin();
-             root != roots->end(); ++root)
-        {
-            paintNotStepEvents(painter, *root, position, entity_spacing,
-                               barheight, blockheight, &extents);
-        }
+        style.metric = options->metric;
+        style.colormap = options->colormap->getSerial();
     }
 
-    int one_tick = std::max(2.0, ceil(rect().width() / 1.0 / timeSpan));
+    // Frames are complete when they are not allowed to lag, as in the
+    // render benchmark, and when text can only be drawn on this thread
+    bool wait = !frameReuse
+                || !QFontDatabase::supportsThreadedFontRendering();
+    tiles.draw(painter, QRect(labelWidth, 0, rect().width() - labelWidth,
+                              canvasHeight),
+               style, options->colormap, backgroundColor, startTime,
+               startEntity, wait, &frameStats);
 
-    for (int i = startPartition; i < trace->partitions->length(); ++i)
+    painter->setFont(QFont("Helvetica", 10));
+    painter->setPen(QPen(QColor(0, 0, 0)));
+    QSet<CommBundle *> selectedComms = QSet<CommBundle *>();
+    if (selected_event)
     {
-        part = trace->partitions->at(i);
-        if (part->min_global_step > upperStep)
-            break;
-        for (QMap<unsigned long, QList<CommEvent *> *>::Iterator event_list
-             = part->events->begin(); event_list != part->events->end();
-             ++event_list)
+        paintSelected(painter, entity_spacing, barheight, &extents);
+        if (selected_event->isCommEvent()
+            && commEventShown(static_cast<CommEvent *>(selected_event)))
         {
-
-            for (QList<CommEvent *>::Iterator evt = (event_list.value())->begin();
-                 evt != (event_list.value())->end(); ++evt)
-            {
-                bool selected = false;
-                if (part->gnome == selected_gnome
-                    && selected_entities.contains(proc_to_order[(*evt)->pe]))
-                {
-                    selected = true;
-                }
-
-                position = proc_to_order[(*evt)->pe];
-                // Out of entity span test
-               if (position < floor(startEntity)
-                       || position > ceil(startEntity + entitySpan))
-                   continue;
-                y = floor((position - startEntity) * blockheight) + 1;
-
-
-                 // Out of time span test
-                if ((*evt)->exit < startTime || (*evt)->enter > stopTime)
-                    continue;
-
-
-                // save step information for emitting
-                step = (*evt)->step;
-                if (step >= 0 && step > stopStep)
-                    stopStep = step;
-                if (step >= 0 && step < startStep) {
-                    startStep = step;
-                }
-
-
-                w = ((*evt)->exit - (*evt)->enter) / 1.0
-                        / timeSpan * rect().width();
-                cw = ((*evt)->extent_end - (*evt)->extent_begin) / 1.0
-                        / timeSpan * rect().width();
-
-                if ((*evt)->exit == (*evt)->enter)
-                {
-                    w = one_tick;
-                }
-                if ((*evt)->extent_end == (*evt)->extent_begin)
-                {
-                    cw = one_tick;
-                }
-
-
-                if (w >= 2) // we know cw >= w
-                {
-                    x = floor(static_cast<long long>((*evt)->enter - startTime)
-                              / 1.0 / timeSpan * rect().width()) + 1 + labelWidth;
-                    h = barheight;
-
-                    cx = floor(static_cast<long long>((*evt)->extent_begin - startTime)
-                               / 1.0 / timeSpan * rect().width()) + 1 + labelWidth;
-
-
-                    // Corrections for partially drawn
-                    complete = true;
-                    if (y < 0) {
-                        h = barheight - fabs(y);
-                        y = 0;
-                        complete = false;
-                    } else if (y + barheight > canvasHeight) {
-                        h = canvasHeight - y;
-                        complete = false;
-                    }
-                    if (x < labelWidth) {
-                        w -= (labelWidth - x);
-                        x = labelWidth;
-                        complete = false;
-                    } else if (x + w > rect().width()) {
-                        w = rect().width() - x;
-                        complete = false;
-                    }
-
-                    if (cx < labelWidth) {
-                        cw -= (labelWidth - cx);
-                        cx = labelWidth;
-                        complete = false;
-                    } else if (cx + cw > rect().width()) {
-                        cw = rect().width() - cx;
-                        complete = false;
-                    }
-
-
-                    // Change pen color if selected
-                    if (*evt == selected_event && !selected_aggregate)
-                        painter->setPen(QPen(Qt::yellow));
-
-                    if (options->colorTraditionalByMetric
-                        && (*evt)->hasMetric(options->metric))
-                    {
-                        // Background color on the larger image
-                        if (entity_spacing > 0)
-                            painter->fillRect(QRectF(cx+1, y+1, cw-2, h-2),
-                                              QBrush(options->colormap->color((*evt)->getMetric(options->metric))));
-                        else
-                            painter->fillRect(QRectF(cx, y, cw, h),
-                                              QBrush(options->colormap->color((*evt)->getMetric(options->metric))));
-
-                        painter->fillRect(QRectF(x, y, w, h),
-                                          QBrush(options->colormap->color((*evt)->getMetric(options->metric))));
-                    }
-                    else
-                    {
-                        if (*evt == selected_event && !selected_aggregate)
-                            painter->fillRect(QRectF(x, y, w, h),
-                                              QBrush(Qt::yellow));
-                        else
-                            // Draw event
-                            painter->fillRect(QRectF(x, y, w, h),
-                                              QBrush(QColor(200, 200, 255)));
-                    }
-
-                    // Draw border
-                    if (entity_spacing > 0)
-                    {
-                        if (complete)
-                            painter->drawRect(QRectF(x,y,w,h));
-                        else
-                            incompleteBox(painter, x, y, w, h, &extents);
-                    }
-
-                    // Revert pen color
-                    if (*evt == selected_event && !selected_aggregate)
-                        painter->setPen(QPen(QColor(0, 0, 0)));
-
-                    drawnEvents[*evt] = QRect(x, y, w, h);
-
-                    unsigned long long drawnEnter = std::max(startTime, (*evt)->enter);
-                    unsigned long long available_w = ((*evt)->exit - drawnEnter)
-                                        / 1.0 / timeSpan * rect().width() + 2;
-                    QString fxnName = ((*(trace->functions))[(*evt)->function])->name;
-                    QRect fxnRect = painter->fontMetrics().boundingRect(fxnName);
-                    if (fxnRect.width() < available_w && fxnRect.height() < h)
-                        painter->drawText(x + 2, y + fxnRect.height(), fxnName);
-
-                    // Selected aggregate
-                    if (*evt == selected_event && selected_aggregate)
-                    {
-                        int xa = labelWidth;
-                        if ((*evt)->comm_prev)
-                            xa = floor(static_cast<long long>((*evt)->comm_prev->exit - startTime)
-                                       / 1.0 / timeSpan * rect().width()) + 1 + labelWidth;
-                        int wa = x - xa;
-                        painter->setPen(QPen(Qt::yellow));
-                        painter->drawRect(xa, y, wa, h);
-                        painter->setPen(QPen(QColor(0, 0, 0)));
-                    }
-
-                }
-                else if (cw >= 2) // Still draw the surrounding
-                {
-                    cx = floor(static_cast<long long>((*evt)->extent_begin - startTime)
-                               / 1.0 / timeSpan * rect().width()) + 1 + labelWidth;
-                    h = barheight;
-
-                    // Corrections for partially drawn
-                    complete = true;
-                    if (y < 0) {
-                        h = barheight - fabs(y);
-                        y = 0;
-                        complete = false;
-                    } else if (y + barheight > canvasHeight) {
-                        h = canvasHeight - y;
-                        complete = false;
-                    }
-
-                    if (cx < labelWidth) {
-                        cw -= (labelWidth - cx);
-                        cx = labelWidth;
-                        complete = false;
-                    } else if (cx + cw > rect().width()) {
-                        cw = rect().width() - cx;
-                        complete = false;
-                    }
-
-
-                    // Change pen color if selected
-                    if (*evt == selected_event && !selected_aggregate)
-                        painter->setPen(QPen(Qt::yellow));
-
-                    if (options->colorTraditionalByMetric
-                        && (*evt)->hasMetric(options->metric))
-                    {
-                        // Background color on the larger image
-                        if (entity_spacing > 0)
-                            painter->fillRect(QRectF(cx+1, y+1, cw-2, h-2),
-                                              QBrush(options->colormap->color((*evt)->getMetric(options->metric))));
-                        else
-                            painter->fillRect(QRectF(cx, y, cw, h),
-                                              QBrush(options->colormap->color((*evt)->getMetric(options->metric))));
-                    }
-
-                    // Revert pen color
-                    if (*evt == selected_event && !selected_aggregate)
-                        painter->setPen(QPen(QColor(0, 0, 0)));
-
-                    drawnEvents[*evt] = QRect(cx, y, cw, h);
-                }
-                (*evt)->addComms(&drawComms);
-                if (*evt == selected_event)
-                    (*evt)->addComms(&selectedComms);
-            }
+            static_cast<CommEvent *>(selected_event)->addComms(&selectedComms);
         }
     }
 
+    // The steps shown are those of the step pairs overlapping the view
+    int oldStart = startStep;
+    int oldStop = stepSpan + startStep;
+    startStep = maxStep;
+    int stopStep = 0;
+    for (int i = 0; i < stepToTime->size(); i++)
+    {
+        TimePair * pair = stepToTime->at(i);
+        if (pair->start > stopTime || pair->stop < startTime)
+            continue;
+        if (2 * i < startStep)
+            startStep = 2 * i;
+        stopStep = std::min(2 * i + 1, maxStep);
+    }
+
     // Messages
     // We need to do all of the message drawing after the event drawing
     // for overlap purposes
     if (options->showMessages != VisOptions::MSG_NONE)
     {
-        for (QSet<CommBundle *>::Iterator comm = drawComms.begin();
-             comm != drawComms.end(); ++comm)
-        {
-            if (!selectedComms.contains(*comm))
-                (*comm)->draw(painter, this);
-        }
-
-        for (QSet<CommBundle *>::Iterator comm = selectedComms.begin();
-             comm != selectedComms.end(); ++comm)
-        {
-            (*comm)->draw(painter, this);
-        }
+        // The steps of the comm events shown bound those of their messages
+        drawCommBundles(painter, int(startStep), stopStep, &selectedComms);
     }
 
     if (selected_event && options->traceBack)
     {
-        selected_event->track_delay(painter, this);
+        trackDelay(painter, selected_event);
     }
 
     if (stopStep == 0 && startStep == maxStep)
@@ -905,7 +721,7 @@ void TraditionalVis::drawMessage(QPainter * painter, Message * msg)
     x = getX(msg->receiver) + getW(msg->receiver);
     QPointF p2 = QPointF(x, y);
     painter->setPen(QPen(pencolor, penwidth, Qt::SolidLine));
-    painter->drawLine(p1, p2);
+    drawCommLine(painter, p1, p2);
 }
 
 void TraditionalVis::drawCollective(QPainter * painter, CollectiveRecord * cr)
@@ -963,7 +779,7 @@ void TraditionalVis::drawCollective(QPainter * painter, CollectiveRecord * cr)
         painter->setBrush(QBrush());
         p1 = QPointF(prev_x, prev_y + h/2.0);
         p2 = QPointF(x, y + h/2.0);
-        painter->drawLine(p1, p2);
+        drawCommLine(painter, p1, p2);
 
         prev_x = x;
         prev_y = y;
@@ -1042,102 +858,121 @@ void TraditionalVis::drawDelayTracking(QPainter * painter, CommEvent * c)
 }
 
 
-// To make sure events have correct overlapping, this draws from the root down
-// TODO: Have a level cut off so we don't descend all the way down the tree
-void TraditionalVis::paintNotStepEvents(QPainter *painter, Event * evt,
-                                        float position, int entity_spacing,
-                                        float barheight, float blockheight,
-                                        QRect * extents)
+// Draw the selected event as the tiles would have with it selected: in
+// yellow, or with a yellow border if it is a comm event colored by metric.
+// A selected aggregate gets a yellow box from the previous comm event.
+void TraditionalVis::paintSelected(QPainter *painter, int entity_spacing,
+                                   float barheight, QRect * extents)
 {
-    if (evt->enter > startTime + timeSpan || evt->exit < startTime)
-        return; // Out of time
-    if (evt->isCommEvent())
-        return; // Drawn later
-
-    int x, y, w, h;
-    w = (evt->exit - evt->enter) / 1.0 / timeSpan * rect().width();
-    if (w >= 2) // Don't draw tiny events
+    Event * evt = selected_event;
+    int position = proc_to_order[evt->pe];
+    if (position < floor(startEntity)
+        || position > ceil(startEntity + entitySpan)
+        || evt->exit < startTime || evt->enter > startTime + timeSpan)
     {
-        y = floor((position - startEntity) * blockheight) + 1;
-        x = floor(static_cast<long long>(evt->enter - startTime) / 1.0
-                  / timeSpan * rect().width()) + 1 + labelWidth;
-        h = barheight;
-
-        if (evt->function == idleFunction)
-        {
-            h = barheight / 2;
-            y += barheight / 4;
-        }
-
+        return;
+    }
 
-        // Corrections for partially drawn
-        bool complete = true;
-        if (y < 0) {
-            h = barheight - fabs(y);
-            y = 0;
-            complete = false;
-        } else if (y + h > rect().height() - timescaleHeight) {
-            h = rect().height() - timescaleHeight - y;
-            complete = false;
-        }
-        if (x < labelWidth) {
-            w -= (labelWidth - x);
-            x = labelWidth;
-            complete = false;
-        } else if (x + w > rect().width()) {
-            w = rect().width() - x;
-            complete = false;
-        }
+    float w = (evt->exit - evt->enter) / 1.0 / timeSpan * rect().width();
+    if (evt->isCommEvent() && evt->exit == evt->enter)
+        w = std::max(2.0, ceil(rect().width() / 1.0 / timeSpan));
+    if (w < 2)
+        return;
 
+    float x = floor(static_cast<long long>(evt->enter - startTime) / 1.0
+                    / timeSpan * rect().width()) + 1 + labelWidth;
+    float y = floor((position - startEntity) * blockheight) + 1;
+    float h = barheight;
+    CommEvent * comm = NULL;
+    if (evt->isCommEvent())
+        comm = static_cast<CommEvent *>(evt);
 
-        // Change pen color if selected
-        if (evt == selected_event)
-            painter->setPen(QPen(Qt::yellow));
+    if (comm && selected_aggregate)
+    {
+        int xa = labelWidth;
+        if (comm->comm_prev)
+            xa = floor(static_cast<long long>(comm->comm_prev->exit - startTime)
+                       / 1.0 / timeSpan * rect().width()) + 1 + labelWidth;
+        painter->setPen(QPen(Qt::yellow));
+        painter->drawRect(xa, y, x - xa, h);
+        painter->setPen(QPen(QColor(0, 0, 0)));
+        return;
+    }
 
+    if (evt->function == idleFunction)
+    {
+        h = barheight / 2;
+        y += barheight / 4;
+    }
+    float available = w + 2;
+    if (!comm)
+        available = (evt->getVisibleEnd(evt->enter) - evt->enter) / 1.0
+                    / timeSpan * rect().width() + 2;
+    float nameX = x;
 
-        if (evt == selected_event)
-            painter->fillRect(QRectF(x, y, w, h), QBrush(Qt::yellow));
+    // Corrections for partially drawn
+    int canvasHeight = rect().height() - timescaleHeight;
+    bool complete = true;
+    if (y < 0) {
+        h = h - fabs(y);
+        y = 0;
+        complete = false;
+    } else if (y + h > canvasHeight) {
+        h = canvasHeight - y;
+        complete = false;
+    }
+    if (x < labelWidth) {
+        w -= (labelWidth - x);
+        x = labelWidth;
+        complete = false;
+    }
+    if (x + w > rect().width()) {
+        w = rect().width() - x;
+        complete = false;
+    }
+
+    bool colored = comm && options->colorTraditionalByMetric
+                   && comm->hasMetric(options->metric);
+    if (!colored)
+        painter->fillRect(QRectF(x, y, w, h), QBrush(Qt::yellow));
+    if (entity_spacing > 0)
+    {
+        painter->setPen(QPen(Qt::yellow));
+        if (complete)
+            painter->drawRect(QRectF(x, y, w, h));
         else
-        {
-            // Draw event
-            int graycolor = 0;
-            if (evt->function != idleFunction)
-                graycolor = std::min(240, std::max(100, 100 + evt->depth * 20));
-            painter->fillRect(QRectF(x, y, w, h),
-                              QBrush(QColor(graycolor, graycolor, graycolor)));
-        }
-
-
-        // Draw border
-        if (entity_spacing > 0)
-        {
-            if (complete)
-                painter->drawRect(QRectF(x,y,w,h));
-            else
-                incompleteBox(painter, x, y, w, h, extents);
-        }
-
-        // Revert pen color
-        if (evt == selected_event)
-            painter->setPen(QPen(QColor(0, 0, 0)));
-
-        unsigned long long drawnEnter = std::max(startTime, evt->enter);
-        unsigned long long available_w = (evt->getVisibleEnd(drawnEnter)
-                           - drawnEnter)
-                            / 1.0 / timeSpan * rect().width() + 2;
-
-        QString fxnName = ((*(trace->functions))[evt->function])->name;
-        QRect fxnRect = painter->fontMetrics().boundingRect(fxnName);
-        if (fxnRect.width() < available_w && fxnRect.height() < h)
-            painter->drawText(x + 2, y + fxnRect.height(), fxnName);
+            incompleteBox(painter, x, y, w, h, extents);
+        painter->setPen(QPen(QColor(0, 0, 0)));
     }
 
-    for (QVector<Event *>::Iterator child = evt->callees->begin();
-         child != evt->callees->end(); ++child)
+    // The fill covered the name the tile drew
+    if (colored)
+        return;
+    QString fxnName = ((*(trace->functions))[evt->function])->name;
+    QRect fxnRect = painter->fontMetrics().boundingRect(fxnName);
+    if (fxnRect.width() < available && fxnRect.height() < h)
     {
-        paintNotStepEvents(painter, *child, position, entity_spacing,
-                           barheight, blockheight, extents);
+        painter->save();
+        painter->setClipRect(QRectF(x, y, w, h));
+        painter->drawText(nameX + 2, y + fxnRect.height(), fxnName);
+        painter->restore();
     }
+}
 
+// The deepest event under a widget point, from the time index since the
+// boxes are drawn in tiles rather than kept for hit tests
+Event * TraditionalVis::eventAt(int x, int y)
+{
+    if (!visProcessed || blockheight <= 0 || timeSpan == 0
+        || x <= labelWidth || y > blockheight * entitySpan)
+    {
+        return NULL;
+    }
 
+    int position = floor((y - 1) / blockheight + startEntity);
+    if (position < 0 || position >= trace->num_pes)
+        return NULL;
+    unsigned long long time = (x - 1 - labelWidth) / 1.0 / rect().width()
+                              * timeSpan + startTime;
+    return trace->findEvent(order_to_proc[position], time);
 }
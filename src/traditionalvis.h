@@ -26,6 +26,7 @@
 #define TRADITIONALVIS_H
 
 #include "timelinevis.h"
+#include "traditionaltiles.h"
 #include <QVector>
 
 class CommEvent;
@@ -39,6 +40,9 @@ public:
                    VisOptions *_options = new VisOptions());
     ~TraditionalVis();
     void setTrace(Trace * t);
+    void processVis();
+    void clear();
+    void countMemory(MemoryCensus * census);
 
     void mouseMoveEvent(QMouseEvent * event);
     void wheelEvent(QWheelEvent * event);
@@ -59,16 +63,18 @@ public slots:
 protected:
     void qtPaint(QPainter *painter);
 
-    // Paint MPI events we handle directly and thus can color.
+    // Paint the events from tiles, with the selection and messages on top
     void paintEvents(QPainter *painter);
+    bool commEventShown(CommEvent * evt);
 
     void prepaint();
+    bool viewRange(ViewRange * range);
     void drawNativeGL();
 
-    // Paint all other events available
-    void paintNotStepEvents(QPainter *painter, Event * evt, float position,
-                            int entity_spacing, float barheight,
-                            float blockheight, QRect * extents);
+    // Highlight the selected event over the tiles
+    void paintSelected(QPainter *painter, int entity_spacing,
+                       float barheight, QRect * extents);
+    Event * eventAt(int x, int y);
 
 private:
     // For keeping track of map betewen real time and step time
@@ -88,6 +94,7 @@ private:
     QVector<TimePair* > * stepToTime;
     QRect lassoRect;
     float blockheight;
+    TraditionalTiles tiles;
 
     int getX(CommEvent * evt);
     int getY(CommEvent * evt);
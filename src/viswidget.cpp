@@ -32,9 +32,19 @@
 #include <QList>
 #include <QPaintEvent>
 #include <QLocale>
+#include <QElapsedTimer>
 
 #include "trace.h"
 #include "ravelutils.h"
+#include "memorycensus.h"
+#include "stagetimer.h"
+#include "commbundle.h"
+#include "message.h"
+#include "collectiverecord.h"
+#include "collectiveevent.h"
+#include "p2pevent.h"
+#include "commindex.h"
+#include "commevent.h"
 
 
 VisWidget::VisWidget(QWidget *parent, VisOptions * _options) :
@@ -47,7 +57,7 @@ VisWidget::VisWidget(QWidget *parent, VisOptions * _options) :
     selectColor(QBrush(Qt::yellow)),
     changeSource(false),
     border(20),
-    drawnEvents(QMap<Event *, QRect>()),
+    drawnEvents(HitGrid()),
     selected_entities(QList<int>()),
     selected_gnome(NULL),
     selected_event(NULL),
@@ -55,12 +65,29 @@ VisWidget::VisWidget(QWidget *parent, VisOptions * _options) :
     overdraw_selected(false),
     hover_event(NULL),
     hover_aggregate(NULL),
-    closed(false)
+    closed(false),
+    commLines(PixelLines()),
+    bundleLines(false),
+    frame(QImage()),
+    frameRange(ViewRange()),
+    shownRange(ViewRange()),
+    paintTime(0),
+    paintFull(false),
+    frameReuse(true),
+    frameReused(false),
+    settleTimer(this),
+    frameStats(FrameStats()),
+    showFrameStats(false)
 {
     // GLWidget options
     setMinimumSize(30, 50);
     setAutoFillBackground(false);
     setWindowTitle("");
+
+    setAutoBufferSwap(false);
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(settleDelay);
+    connect(&settleTimer, SIGNAL(timeout()), this, SLOT(paintSettled()));
 }
 
 VisWidget::~VisWidget()
@@ -111,6 +138,10 @@ void VisWidget::setTrace(Trace * t)
     overdraw_selected = false;
     hover_event = NULL;
     hover_aggregate = false;
+
+    settleTimer.stop();
+    frame = QImage();
+    paintTime = 0;
 }
 
 void VisWidget::prepaint()
@@ -120,8 +151,37 @@ void VisWidget::prepaint()
 
 void VisWidget::paintEvent(QPaintEvent *event)
 {
+    StageTimer stageTimer("paint");
     Q_UNUSED(event);
-    prepaint();
+
+    // When the last full paint blew the frame budget and only the view range
+    // has changed since, we reuse that frame and paint properly once the
+    // panning or zooming stops. Anything else changing (hover, selection,
+    // options) keeps the range the same and so gets a full paint.
+    frameStats.begin();
+    ViewRange range;
+    bool movable = visProcessed && viewRange(&range);
+    if (frameReuse && movable && !paintFull && paintTime > frameBudget
+        && !frame.isNull() && frame.size() == size() && range != frameRange)
+    {
+        // No prepaint: that would reset the hit grid, which still describes
+        // the reused frame and is looked up through framePoint()
+        paintFrame(range);
+        settleTimer.start();
+        frameReused = true;
+        frameStats.end(true);
+        return;
+    }
+    settleTimer.stop();
+    paintFull = false;
+    frameReused = false;
+
+    QElapsedTimer timer;
+    timer.start();
+    {
+        FrameStats::Section section(&frameStats, FrameStats::FS_PREPAINT);
+        prepaint();
+    }
 
     // Clear
     qglClearColor(backgroundColor);
@@ -138,6 +198,123 @@ void VisWidget::paintEvent(QPaintEvent *event)
     painter.setRenderHint(QPainter::Antialiasing);
     qtPaint(&painter);
     painter.end();
+
+    // Buffers are swapped by hand so the frame can be read back from the
+    // back buffer before it is shown, without the statistics overlay
+    paintTime = timer.elapsed();
+    if (movable && paintTime > frameBudget)
+    {
+        frame = grabFrameBuffer();
+        frameRange = range;
+    }
+    else
+    {
+        frame = QImage();
+    }
+    if (showFrameStats)
+    {
+        painter.begin(this);
+        drawFrameStats(&painter);
+        painter.end();
+    }
+    swapBuffers();
+    frameStats.end();
+}
+
+// Draw the last full frame with its plot area moved and scaled to where the
+// same data sits in the current range. Whatever the old frame did not cover
+// stays background until the full paint.
+void VisWidget::paintFrame(const ViewRange &range)
+{
+    QPainter painter(this);
+    painter.drawImage(0, 0, frame);
+
+    painter.setClipRect(range.plot);
+    painter.fillRect(range.plot, backgroundColor);
+    QRectF target(range.plot.left()
+                      + (frameRange.x - range.x) * range.xscale,
+                  range.plot.top()
+                      + (frameRange.y - range.y) * range.yscale,
+                  frameRange.plot.width() * range.xscale / frameRange.xscale,
+                  frameRange.plot.height() * range.yscale / frameRange.yscale);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawImage(target, frame, QRectF(frameRange.plot));
+    painter.setClipping(false);
+    if (showFrameStats)
+        drawFrameStats(&painter);
+    painter.end();
+    swapBuffers();
+    shownRange = range;
+}
+
+// Where a widget point was drawn in the frame being reused, so hit tests can
+// use the hit grid of the paint that drew it. Points of the plot area the
+// old frame did not cover map outside the widget.
+QPoint VisWidget::framePoint(const QPoint &point) const
+{
+    if (!frameReused || !shownRange.plot.contains(point))
+        return point;
+
+    double x = shownRange.x
+               + (point.x() - shownRange.plot.left()) / shownRange.xscale;
+    double y = shownRange.y
+               + (point.y() - shownRange.plot.top()) / shownRange.yscale;
+    QPoint old(frameRange.plot.left() + floor((x - frameRange.x)
+                                              * frameRange.xscale),
+               frameRange.plot.top() + floor((y - frameRange.y)
+                                             * frameRange.yscale));
+    if (!frameRange.plot.contains(old))
+        return QPoint(-1, -1);
+    return old;
+}
+
+// The event under a widget point and, in widget coordinates, where it is
+// drawn now
+Event * VisWidget::findDrawnEvent(int x, int y, QRect * rect) const
+{
+    QPoint point = framePoint(QPoint(x, y));
+    Event * evt = drawnEvents.find(point.x(), point.y(), rect);
+    if (evt && rect && frameReused && frameRange.plot.intersects(*rect))
+    {
+        double xscale = shownRange.xscale / frameRange.xscale;
+        double yscale = shownRange.yscale / frameRange.yscale;
+        double left = shownRange.plot.left()
+                      + (frameRange.x - shownRange.x) * shownRange.xscale;
+        double top = shownRange.plot.top()
+                     + (frameRange.y - shownRange.y) * shownRange.yscale;
+        *rect = QRect(left + (rect->x() - frameRange.plot.left()) * xscale,
+                      top + (rect->y() - frameRange.plot.top()) * yscale,
+                      rect->width() * xscale, rect->height() * yscale);
+    }
+    return evt;
+}
+
+// The previous frame's timings and counts in the top right corner
+void VisWidget::drawFrameStats(QPainter * painter)
+{
+    painter->setFont(QFont("Helvetica", 9));
+    QRect textRect = painter->fontMetrics().boundingRect(rect(),
+                                                         Qt::AlignRight
+                                                         | Qt::AlignTop,
+                                                         frameStats.summary());
+    textRect.moveTopRight(QPoint(rect().right() - 4, 4));
+    painter->fillRect(textRect.adjusted(-3, -2, 3, 2),
+                      QBrush(QColor(255, 255, 255, 200)));
+    painter->setPen(QPen(Qt::black));
+    painter->drawText(textRect, Qt::AlignRight | Qt::AlignTop,
+                      frameStats.summary());
+}
+
+void VisWidget::paintSettled()
+{
+    paintFull = true;
+    repaint();
+}
+
+bool VisWidget::ViewRange::operator==(const ViewRange &other) const
+{
+    return plot == other.plot && x == other.x && xscale == other.xscale
+           && y == other.y && yscale == other.yscale;
 }
 
 void VisWidget::drawNativeGL()
@@ -187,9 +364,21 @@ void VisWidget::qtPaint(QPainter *painter)
 void VisWidget::clear()
 {
     visProcessed = false;
+    settleTimer.stop();
+    frame = QImage();
     repaint();
 }
 
+// Add what the view keeps between paints to the vis caches
+void VisWidget::countMemory(MemoryCensus * census)
+{
+    census->add(MemoryCensus::MC_VIS, drawnEvents.size(),
+                drawnEvents.memoryBytes());
+    census->add(MemoryCensus::MC_VIS, frame.isNull() ? 0 : 1,
+                frame.byteCount());
+    census->add(MemoryCensus::MC_VIS, 1, frameStats.memoryBytes());
+}
+
 // If a described box falls outside the given extents
 // We only draw the border where to the edge of the extents.
 // We use this when we draw partial boxes and cannot rely on automatic clipping.
@@ -222,6 +411,24 @@ void VisWidget::incompleteBox(QPainter *painter, float x, float y, float w, floa
 }
 
 
+// Messages and collectives are drawn by the view, not by themselves, so
+// that the trace classes need no painting
+void VisWidget::drawCommBundle(QPainter * painter, CommBundle * comm)
+{
+    if (comm->isMessage())
+        drawMessage(painter, static_cast<Message *>(comm));
+    else
+        drawCollective(painter, static_cast<CollectiveRecord *>(comm));
+}
+
+// Only point-to-point events have a delay to trace back
+void VisWidget::trackDelay(QPainter * painter, Event * evt)
+{
+    if (evt->isCommEvent() && static_cast<CommEvent *>(evt)->isP2P())
+        drawDelayTracking(painter, static_cast<CommEvent *>(evt));
+}
+
+
 // If we want an odd step, we actually need the step after it since that is
 // where in the information is stored. This function computes that.
 int VisWidget::boundStep(float step) {
@@ -320,3 +527,73 @@ QString VisWidget::drawTimescale(QPainter * painter, unsigned long long start,
     }
     return seconds;
 }
+
+// Draw the messages and collectives in the step range that have an event
+// the view shows, the selected ones last so they are on top. Once there are
+// more lines than pixel columns they mostly pile onto the same pixels, so
+// the unselected ones are merged by endpoint and drawn once.
+void VisWidget::drawCommBundles(QPainter * painter, int start_step,
+                                int stop_step, QSet<CommBundle *> * selected)
+{
+    FrameStats::Section section(&frameStats, FrameStats::FS_MESSAGES);
+    QVector<CommBundle *> candidates;
+    trace->comm_index->find(start_step, stop_step, &candidates);
+    QVector<CommBundle *> comms;
+    for (QVector<CommBundle *>::Iterator comm = candidates.begin();
+         comm != candidates.end(); ++comm)
+    {
+        if (!selected->contains(*comm) && commShown(*comm))
+            comms.append(*comm);
+    }
+
+    commLines.clear();
+    commLines.setClip(rect());
+    bundleLines = comms.size() > rect().width();
+    for (QVector<CommBundle *>::Iterator comm = comms.begin();
+         comm != comms.end(); ++comm)
+    {
+        drawCommBundle(painter, *comm);
+    }
+    if (bundleLines)
+    {
+        bundleLines = false;
+        commLines.draw(painter);
+        commLines.clear();
+    }
+
+    for (QSet<CommBundle *>::Iterator comm = selected->begin();
+         comm != selected->end(); ++comm)
+    {
+        drawCommBundle(painter, *comm);
+    }
+    frameStats.count(FrameStats::FS_MESSAGES_DRAWN,
+                     comms.size() + selected->size());
+}
+
+// A message or collective is drawn when the view shows one of its events
+bool VisWidget::commShown(CommBundle * comm)
+{
+    if (comm->isMessage())
+    {
+        Message * msg = static_cast<Message *>(comm);
+        return commEventShown(msg->sender) || commEventShown(msg->receiver);
+    }
+
+    CollectiveRecord * cr = static_cast<CollectiveRecord *>(comm);
+    for (QList<CollectiveEvent *>::Iterator evt = cr->events->begin();
+         evt != cr->events->end(); ++evt)
+    {
+        if (commEventShown(*evt))
+            return true;
+    }
+    return false;
+}
+
+void VisWidget::drawCommLine(QPainter * painter, const QPointF &p1,
+                             const QPointF &p2)
+{
+    if (bundleLines)
+        commLines.add(p1, p2, painter->pen().color(), painter->pen().widthF());
+    else
+        painter->drawLine(p1, p2);
+}
@@ -28,12 +28,17 @@
 #include <QGLWidget>
 #include <QList>
 #include <QMap>
+#include <QSet>
 #include <QString>
 #include <QRect>
 #include <QColor>
+#include <QImage>
+#include <QTimer>
 
 #include "visoptions.h"
-#include "commdrawinterface.h"
+#include "hitgrid.h"
+#include "pixellines.h"
+#include "framestats.h"
 
 class VisOptions;
 class Trace;
@@ -42,8 +47,12 @@ class Message;
 class Gnome;
 class QPaintEvent;
 class Event;
+class MemoryCensus;
+class CommBundle;
+class CollectiveRecord;
+class CommEvent;
 
-class VisWidget : public QGLWidget, public CommDrawInterface
+class VisWidget : public QGLWidget
 {
     Q_OBJECT
 public:
@@ -52,7 +61,8 @@ public:
     virtual void setTrace(Trace *t);
     Trace * getTrace() { return trace; }
     virtual void processVis();
-    void clear();
+    virtual void clear();
+    virtual void countMemory(MemoryCensus * census);
     virtual QSize sizeHint() const;
 
     void setClosed(bool _closed);
@@ -60,6 +70,15 @@ public:
     void setVisOptions(VisOptions * _options);
     QWidget * container;
 
+    // For the render benchmark: whether slow views may reuse the last frame
+    // while the range moves, and views drawing in the background may show
+    // frames before that is done
+    void setFrameReuse(bool reuse) { frameReuse = reuse; }
+
+    // Frame timings and counts, optionally drawn over the view
+    FrameStats * getFrameStats() { return &frameStats; }
+    void setShowFrameStats(bool show) { showFrameStats = show; }
+
     virtual int getHeight() { return rect().height(); }
     virtual void drawMessage(QPainter * painter, Message * msg)
         { Q_UNUSED(painter); Q_UNUSED(msg); }
@@ -79,7 +98,26 @@ public slots:
     virtual void selectEvent(Event *, bool, bool);
     virtual void selectEntities(QList<int> entities, Gnome * gnome);
 
+private slots:
+    void paintSettled();
+
 protected:
+    // Where the data sits in the widget and how it maps to pixels:
+    // x = plot.left() + (value - x) * xscale, likewise for y.
+    class ViewRange {
+    public:
+        ViewRange() : plot(QRect()), x(0), xscale(1), y(0), yscale(1) {}
+        bool operator==(const ViewRange &other) const;
+        bool operator!=(const ViewRange &other) const
+            { return !(*this == other); }
+
+        QRect plot;
+        double x;
+        double xscale;
+        double y;
+        double yscale;
+    };
+
     void initializeGL();
     void paintEvent(QPaintEvent *event);
     void incompleteBox(QPainter *painter,
@@ -89,12 +127,27 @@ protected:
     virtual void drawNativeGL();
     virtual void qtPaint(QPainter *painter);
     virtual void prepaint();
+    virtual bool viewRange(ViewRange * range)
+        { Q_UNUSED(range); return false; }
     QString drawTimescale(QPainter * painter, unsigned long long start,
                        unsigned long long span, int margin = 0);
+    void drawCommBundles(QPainter * painter, int start_step, int stop_step,
+                         QSet<CommBundle *> * selected);
+    virtual bool commEventShown(CommEvent * evt)
+        { Q_UNUSED(evt); return false; }
+    void drawCommLine(QPainter * painter, const QPointF &p1,
+                      const QPointF &p2);
+    void drawCommBundle(QPainter * painter, CommBundle * comm);
+    bool commShown(CommBundle * comm);
+    void trackDelay(QPainter * painter, Event * evt);
+    QPoint framePoint(const QPoint &point) const;
+    Event * findDrawnEvent(int x, int y, QRect * rect = NULL) const;
 
 private:
     void beginNativeGL();
     void endNativeGL();
+    void paintFrame(const ViewRange &range);
+    void drawFrameStats(QPainter * painter);
 
 protected:
     Trace * trace;
@@ -106,7 +159,7 @@ protected:
     int border;
 
     // Interactions
-    QMap<Event *, QRect> drawnEvents;
+    HitGrid drawnEvents;
     QList<int> selected_entities;
     Gnome * selected_gnome;
     Event * selected_event;
@@ -116,7 +169,27 @@ protected:
     bool hover_aggregate;
     bool closed;
 
+    // Message and collective lines merged by pixel while bundleLines is set
+    PixelLines commLines;
+    bool bundleLines;
+
+    // Last full paint, moved to follow pans and zooms while a slow
+    // view waits for the interaction to settle before painting again
+    QImage frame;
+    ViewRange frameRange;
+    ViewRange shownRange; // where the reused frame was last drawn to
+    qint64 paintTime;
+    bool paintFull;
+    bool frameReuse;
+    bool frameReused;
+    QTimer settleTimer;
+
+    FrameStats frameStats;
+    bool showFrameStats;
+
     static const int initStepSpan = 15;
+    static const int frameBudget = 16; // ms
+    static const int settleDelay = 120; // ms
     static const int timescaleHeight = 20;
     static const int timescaleTickHeight = 5;
 };